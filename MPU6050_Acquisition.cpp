@@ -0,0 +1,116 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Dedicated acquisition thread for the MPU6050 feeding a lock free sample ring
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Polled and FIFO acquisition into an SPSC ring, optional CPU pinning
+* Rev 2: Paced by UNR_PeriodicSampler (absolute deadlines, SCHED_FIFO, timing statistics)
+* Rev 3: Data ready interrupt mode, one read per GPIO edge event
+* Rev 4: Sensor FIFO overflows counted
+* Rev 5: The periodic sampler and its thread only exist in the polled and FIFO modes
+*/
+
+
+#include "MPU6050_Acquisition.h"
+#include <sys/mman.h>
+
+MPU6050_Acquisition::MPU6050_Acquisition(MPU6050_RaspbPi* _device, const UNR_SamplerConfig& _timing,
+										UNR_RingPolicy _policy, MPU6050_AcquisitionMode _mode) noexcept(false) : m_device(_device)
+																								, m_ring(_policy)
+																								, m_sampler(_mode != MPU6050_ACQ_DATA_READY ? new UNR_PeriodicSampler(_timing) : nullptr)
+																								, m_readErrors(0)
+																								, m_fifoOverflows(0)
+																								, m_mode(_mode)
+																								, m_timing(_timing)
+																								, m_eventFd(-1)
+																								, m_edgeRunning(false)
+{
+}
+
+int MPU6050_Acquisition::start(void)
+{
+	if (isRunning()) return -1;
+	if (m_mode == MPU6050_ACQ_FIFO && m_device->enableFIFO() < 0) return -1;
+	if (m_sampler) return m_sampler->start(&MPU6050_Acquisition::acquire, this);
+
+	if (m_eventFd < 0 || m_device->enableDataReadyInterrupt() < 0) return -1;
+	if (m_timing.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) return -1;
+	m_edgeRunning.store(true);
+	m_edgeThread = std::thread(&MPU6050_Acquisition::runDataReady, this);
+	if (UNR_applyThreadConfig(m_edgeThread, m_timing) < 0)
+	{
+		stop();
+		return -1;
+	}
+	return 1;
+}
+
+void MPU6050_Acquisition::stop(void)
+{
+	if (m_sampler) m_sampler->stop();
+	m_edgeRunning.store(false);
+	if (m_edgeThread.joinable()) m_edgeThread.join();
+}
+
+/*
+* Data ready thread. Sleeps in poll() until the INT pin edge, so there is no idle polling of the bus and the
+* sample timestamp is the kernel edge timestamp rather than the time the thread got scheduled.
+*/
+void MPU6050_Acquisition::runDataReady(void)
+{
+	MPU6050_Sample& sample = m_batch[0];
+	int result;
+
+	while (m_edgeRunning.load(std::memory_order_relaxed))
+	{
+		result = m_device->waitForSample(m_eventFd, sample, MPU6050_ACQ_EDGE_TIMEOUT_MS);
+		if (result > 0)
+			m_ring.push(sample);
+		else if (result < 0)
+			m_readErrors.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+/*
+* One acquisition period, called from the sampler thread. The device is only touched from here while running.
+*/
+void MPU6050_Acquisition::acquire(void* _context, uint64_t _deadline_ns)
+{
+	MPU6050_Acquisition* self = static_cast<MPU6050_Acquisition*>(_context);
+	int result;
+	(void)_deadline_ns;
+
+	if (self->m_mode == MPU6050_ACQ_FIFO)
+	{
+		result = self->m_device->getFIFOSamples(self->m_batch, MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_SIZE);
+		if (result == MPU6050_FIFO_OVERFLOW) self->m_fifoOverflows.fetch_add(1, std::memory_order_relaxed);
+		else if (result < 0) self->m_readErrors.fetch_add(1, std::memory_order_relaxed);
+		for (int i = 0; i < result; i++)
+			self->m_ring.push(self->m_batch[i]);
+	}
+	else
+	{
+		if (self->m_device->getSample(self->m_batch[0]) > 0)
+			self->m_ring.push(self->m_batch[0]);
+		else
+			self->m_readErrors.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+MPU6050_Acquisition::~MPU6050_Acquisition(void)
+{
+	stop();
+	delete m_device;
+}
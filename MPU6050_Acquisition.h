@@ -0,0 +1,112 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Dedicated acquisition thread for the MPU6050 feeding a lock free sample ring
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Polled and FIFO acquisition into an SPSC ring, optional CPU pinning
+* Rev 2: Paced by UNR_PeriodicSampler (absolute deadlines, SCHED_FIFO, timing statistics)
+* Rev 3: Data ready interrupt mode, one read per GPIO edge event
+* Rev 4: Sensor FIFO overflows counted
+* Rev 5: The periodic sampler and its thread only exist in the polled and FIFO modes
+*/
+
+
+#pragma once
+#include <memory>
+#include "MPU6050_RaspbPi.h"
+#include "UNR_SPSCRing.h"
+#include "UNR_PeriodicSampler.h"
+
+#define MPU6050_ACQ_RING_CAPACITY	4096U
+
+typedef UNR_SPSCRing<MPU6050_Sample, MPU6050_ACQ_RING_CAPACITY> MPU6050_SampleRing;
+
+enum MPU6050_AcquisitionMode
+{
+	MPU6050_ACQ_POLLED = 0,		// one getSample() burst per period
+	MPU6050_ACQ_FIFO = 1,		// FIFO streaming, the FIFO is drained once per period
+	MPU6050_ACQ_DATA_READY = 2	// one getSample() burst per INT pin edge, see setDataReadySource()
+};
+
+#define MPU6050_ACQ_EDGE_TIMEOUT_MS	100		// data ready thread checks for stop() at least this often
+
+/*
+* The acquisition thread owns the device: it is the only thread that touches the MPU6050 while running,
+* and the device is deleted together with this object. Consumers pop samples from any one other thread.
+*/
+class MPU6050_Acquisition
+{
+private:
+	MPU6050_RaspbPi* m_device;
+	MPU6050_SampleRing m_ring;
+	std::unique_ptr<UNR_PeriodicSampler> m_sampler;	// nullptr in data ready mode, the edge thread paces itself
+	std::atomic<uint64_t> m_readErrors;
+	std::atomic<uint64_t> m_fifoOverflows;
+	MPU6050_AcquisitionMode m_mode;
+	UNR_SamplerConfig m_timing;
+	int m_eventFd;
+	std::atomic<bool> m_edgeRunning;
+	std::thread m_edgeThread;
+	MPU6050_Sample m_batch[MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_SIZE];
+
+	static void acquire(void* _context, uint64_t _deadline_ns);
+	void runDataReady(void);
+
+public:
+	/*
+	* _device is taken over by this object. _timing.rateHz is the sample rate (polled) or the drain rate (FIFO),
+	* priority, affinity and memory locking of the acquisition thread come from _timing as well.
+	* In data ready mode the rate is not used for timing, the device sample rate paces the thread.
+	*/
+	MPU6050_Acquisition(MPU6050_RaspbPi* _device, const UNR_SamplerConfig& _timing,
+						UNR_RingPolicy _policy = UNR_RING_DROP_OLDEST,
+						MPU6050_AcquisitionMode _mode = MPU6050_ACQ_POLLED) noexcept(false);
+	~MPU6050_Acquisition(void);
+	MPU6050_Acquisition() = delete;
+	MPU6050_Acquisition(const MPU6050_Acquisition&) = delete;
+	MPU6050_Acquisition& operator = (const MPU6050_Acquisition&) = delete;
+
+	/*
+	* Edge event fd of the GPIO line wired to the INT pin (gpio_request_edge with GPIO_EDGE_RISING), required
+	* for MPU6050_ACQ_DATA_READY. The fd stays owned by the caller and must outlive the acquisition thread.
+	*/
+	void setDataReadySource(int _eventFd) { m_eventFd = _eventFd; }
+
+	/*
+	* Starts the acquisition thread. Returns 1 on success, -1 if already running, if the FIFO or the data ready
+	* interrupt could not be enabled, if no data ready source is set or if the scheduling options could not be
+	* applied (see UNR_PeriodicSampler::start)
+	*/
+	int start(void);
+	void stop(void);
+	bool isRunning(void) const { return (m_sampler && m_sampler->isRunning()) || m_edgeRunning.load(); }
+
+	/*
+	* Consumer side, no locks. pop() returns false when no sample is waiting, popBatch() returns the number copied.
+	*/
+	bool pop(MPU6050_Sample& _sample) { return m_ring.pop(_sample); }
+	unsigned int popBatch(MPU6050_Sample* _samples, unsigned int _max) { return m_ring.popBatch(_samples, _max); }
+	unsigned int available(void) const { return m_ring.size(); }
+
+	/*
+	* Samples lost: getOverruns() counts those dropped by a full ring, getFIFOOverflows() the drains that found the
+	* sensor FIFO overflowed (or out of frame alignment) and reset, losing its contents.
+	*/
+	uint64_t getOverruns(void) const { return m_ring.overruns(); }
+	uint64_t getFIFOOverflows(void) const { return m_fifoOverflows.load(std::memory_order_relaxed); }
+	uint64_t getReadErrors(void) const { return m_readErrors.load(std::memory_order_relaxed); }
+	UNR_SamplerStats getTimingStats(void) const { return m_sampler ? m_sampler->getStats() : UNR_SamplerStats(); }	// empty in data ready mode
+	void resetTimingStats(void) { if (m_sampler) m_sampler->resetStats(); }
+};
@@ -0,0 +1,211 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Bulk decoder for blocks of raw 14 byte MPU6050 records (FIFO drains, capture files)
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Scalar, NEON (aarch64) and SSSE3 / AVX2 (x86) decoders into structure of arrays float buffers
+*
+* All SIMD paths work on groups of 8 records: each record is loaded as one 16 byte vector, byte swapped with one
+* shuffle, and the 8x8 matrix of 16 bit words is transposed so that every vector holds one channel of 8 records.
+* Lane 7 (2 bytes of the next record) is dropped by the transpose.
+*/
+
+#include "MPU6050_BulkDecoder.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MPU6050_DECODE_NEON
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define MPU6050_DECODE_AVX2
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define MPU6050_DECODE_SSSE3
+#endif
+
+#define MPU6050_DECODE_GROUP	8U
+
+static const float kTempScaleInv = 1.0f / 340.0f;
+
+static inline void decodeRecord(const unsigned char* _p, unsigned int _i, const MPU6050_SoA& _out, float _accelScaleInv, float _gyroScaleInv)
+{
+	int16_t v[7];
+	for (unsigned int c = 0; c < 7; c++)
+		v[c] = (int16_t)((_p[2 * c] << 8) | _p[2 * c + 1]);
+
+	_out.ax[_i] = (float)v[0] * _accelScaleInv;
+	_out.ay[_i] = (float)v[1] * _accelScaleInv;
+	_out.az[_i] = (float)v[2] * _accelScaleInv;
+	_out.temp[_i] = ((float)v[3] + MPU6050_TEMP_OFFSET_LSB) * kTempScaleInv;
+	_out.gx[_i] = (float)v[4] * _gyroScaleInv;
+	_out.gy[_i] = (float)v[5] * _gyroScaleInv;
+	_out.gz[_i] = (float)v[6] * _gyroScaleInv;
+}
+
+void MPU6050_decodeBlockScalar(const unsigned char* _records, unsigned int _count, const MPU6050_SoA& _out,
+						float _accelScaleInv, float _gyroScaleInv)
+{
+	for (unsigned int i = 0; i < _count; i++)
+		decodeRecord(&_records[i * MPU6050_RECORD_SIZE], i, _out, _accelScaleInv, _gyroScaleInv);
+}
+
+#if defined(MPU6050_DECODE_NEON)
+
+static inline void decodeGroup(const unsigned char* _p, unsigned int _i, const MPU6050_SoA& _out, float _accelScaleInv, float _gyroScaleInv)
+{
+	int16x8_t r[8], t[8], u[8], c[7];
+	float* dst[7] = { _out.ax, _out.ay, _out.az, _out.temp, _out.gx, _out.gy, _out.gz };
+	const float32x4_t accel = vdupq_n_f32(_accelScaleInv);
+	const float32x4_t gyro = vdupq_n_f32(_gyroScaleInv);
+	const float32x4_t tempScale = vdupq_n_f32(kTempScaleInv);
+	const float32x4_t tempOffset = vdupq_n_f32(MPU6050_TEMP_OFFSET_LSB);
+
+	for (unsigned int k = 0; k < 7; k++)
+		r[k] = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(_p + k * MPU6050_RECORD_SIZE)));
+	// the last record is loaded 2 bytes early so the load ends exactly at the end of the group
+	r[7] = vreinterpretq_s16_u8(vrev16q_u8(vextq_u8(vld1q_u8(_p + 7 * MPU6050_RECORD_SIZE - 2), vdupq_n_u8(0), 2)));
+
+	for (unsigned int k = 0; k < 8; k += 2)
+	{
+		t[k] = vzip1q_s16(r[k], r[k + 1]);
+		t[k + 1] = vzip2q_s16(r[k], r[k + 1]);
+	}
+	for (unsigned int k = 0; k < 8; k += 4)
+	{
+		u[k] = vreinterpretq_s16_s32(vzip1q_s32(vreinterpretq_s32_s16(t[k]), vreinterpretq_s32_s16(t[k + 2])));
+		u[k + 1] = vreinterpretq_s16_s32(vzip2q_s32(vreinterpretq_s32_s16(t[k]), vreinterpretq_s32_s16(t[k + 2])));
+		u[k + 2] = vreinterpretq_s16_s32(vzip1q_s32(vreinterpretq_s32_s16(t[k + 1]), vreinterpretq_s32_s16(t[k + 3])));
+		u[k + 3] = vreinterpretq_s16_s32(vzip2q_s32(vreinterpretq_s32_s16(t[k + 1]), vreinterpretq_s32_s16(t[k + 3])));
+	}
+	for (unsigned int k = 0; k < 4; k++)
+	{
+		c[2 * k] = vreinterpretq_s16_s64(vzip1q_s64(vreinterpretq_s64_s16(u[k]), vreinterpretq_s64_s16(u[k + 4])));
+		if (k < 3)
+			c[2 * k + 1] = vreinterpretq_s16_s64(vzip2q_s64(vreinterpretq_s64_s16(u[k]), vreinterpretq_s64_s16(u[k + 4])));
+	}
+
+	for (unsigned int k = 0; k < 7; k++)
+	{
+		float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(c[k])));
+		float32x4_t hi = vcvtq_f32_s32(vmovl_high_s16(c[k]));
+		if (k == 3)
+		{
+			lo = vmulq_f32(vaddq_f32(lo, tempOffset), tempScale);
+			hi = vmulq_f32(vaddq_f32(hi, tempOffset), tempScale);
+		}
+		else
+		{
+			lo = vmulq_f32(lo, k < 3 ? accel : gyro);
+			hi = vmulq_f32(hi, k < 3 ? accel : gyro);
+		}
+		vst1q_f32(dst[k] + _i, lo);
+		vst1q_f32(dst[k] + _i + 4, hi);
+	}
+}
+
+#elif defined(MPU6050_DECODE_AVX2) || defined(MPU6050_DECODE_SSSE3)
+
+static inline void decodeGroup(const unsigned char* _p, unsigned int _i, const MPU6050_SoA& _out, float _accelScaleInv, float _gyroScaleInv)
+{
+	__m128i r[8], t[8], u[8], c[7];
+	float* dst[7] = { _out.ax, _out.ay, _out.az, _out.temp, _out.gx, _out.gy, _out.gz };
+	const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+	for (unsigned int k = 0; k < 7; k++)
+		r[k] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(_p + k * MPU6050_RECORD_SIZE)), swap);
+	// the last record is loaded 2 bytes early so the load ends exactly at the end of the group
+	r[7] = _mm_shuffle_epi8(_mm_srli_si128(_mm_loadu_si128((const __m128i*)(_p + 7 * MPU6050_RECORD_SIZE - 2)), 2), swap);
+
+	for (unsigned int k = 0; k < 8; k += 2)
+	{
+		t[k] = _mm_unpacklo_epi16(r[k], r[k + 1]);
+		t[k + 1] = _mm_unpackhi_epi16(r[k], r[k + 1]);
+	}
+	for (unsigned int k = 0; k < 8; k += 4)
+	{
+		u[k] = _mm_unpacklo_epi32(t[k], t[k + 2]);
+		u[k + 1] = _mm_unpackhi_epi32(t[k], t[k + 2]);
+		u[k + 2] = _mm_unpacklo_epi32(t[k + 1], t[k + 3]);
+		u[k + 3] = _mm_unpackhi_epi32(t[k + 1], t[k + 3]);
+	}
+	for (unsigned int k = 0; k < 4; k++)
+	{
+		c[2 * k] = _mm_unpacklo_epi64(u[k], u[k + 4]);
+		if (k < 3)
+			c[2 * k + 1] = _mm_unpackhi_epi64(u[k], u[k + 4]);
+	}
+
+#if defined(MPU6050_DECODE_AVX2)
+	const __m256 accel = _mm256_set1_ps(_accelScaleInv);
+	const __m256 gyro = _mm256_set1_ps(_gyroScaleInv);
+	for (unsigned int k = 0; k < 7; k++)
+	{
+		__m256 v = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(c[k]));
+		if (k == 3)
+			v = _mm256_mul_ps(_mm256_add_ps(v, _mm256_set1_ps(MPU6050_TEMP_OFFSET_LSB)), _mm256_set1_ps(kTempScaleInv));
+		else
+			v = _mm256_mul_ps(v, k < 3 ? accel : gyro);
+		_mm256_storeu_ps(dst[k] + _i, v);
+	}
+#else
+	const __m128 accel = _mm_set1_ps(_accelScaleInv);
+	const __m128 gyro = _mm_set1_ps(_gyroScaleInv);
+	for (unsigned int k = 0; k < 7; k++)
+	{
+		// sign extend by unpacking against itself and shifting the copy out
+		__m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(c[k], c[k]), 16));
+		__m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(c[k], c[k]), 16));
+		if (k == 3)
+		{
+			lo = _mm_mul_ps(_mm_add_ps(lo, _mm_set1_ps(MPU6050_TEMP_OFFSET_LSB)), _mm_set1_ps(kTempScaleInv));
+			hi = _mm_mul_ps(_mm_add_ps(hi, _mm_set1_ps(MPU6050_TEMP_OFFSET_LSB)), _mm_set1_ps(kTempScaleInv));
+		}
+		else
+		{
+			lo = _mm_mul_ps(lo, k < 3 ? accel : gyro);
+			hi = _mm_mul_ps(hi, k < 3 ? accel : gyro);
+		}
+		_mm_storeu_ps(dst[k] + _i, lo);
+		_mm_storeu_ps(dst[k] + _i + 4, hi);
+	}
+#endif
+}
+
+#endif
+
+void MPU6050_decodeBlock(const unsigned char* _records, unsigned int _count, const MPU6050_SoA& _out,
+						float _accelScaleInv, float _gyroScaleInv)
+{
+	unsigned int i = 0;
+#if defined(MPU6050_DECODE_NEON) || defined(MPU6050_DECODE_AVX2) || defined(MPU6050_DECODE_SSSE3)
+	for (; i + MPU6050_DECODE_GROUP <= _count; i += MPU6050_DECODE_GROUP)
+		decodeGroup(&_records[i * MPU6050_RECORD_SIZE], i, _out, _accelScaleInv, _gyroScaleInv);
+#endif
+	for (; i < _count; i++)
+		decodeRecord(&_records[i * MPU6050_RECORD_SIZE], i, _out, _accelScaleInv, _gyroScaleInv);
+}
+
+const char* MPU6050_decodeBlockPath(void)
+{
+#if defined(MPU6050_DECODE_NEON)
+	return "neon";
+#elif defined(MPU6050_DECODE_AVX2)
+	return "avx2";
+#elif defined(MPU6050_DECODE_SSSE3)
+	return "ssse3";
+#else
+	return "scalar";
+#endif
+}
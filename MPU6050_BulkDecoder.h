@@ -0,0 +1,61 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Bulk decoder for blocks of raw 14 byte MPU6050 records (FIFO drains, capture files)
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Scalar, NEON (aarch64) and SSSE3 / AVX2 (x86) decoders into structure of arrays float buffers
+*/
+
+
+#pragma once
+#include <stdint.h>
+
+#define MPU6050_RECORD_SIZE			14U
+#define MPU6050_TEMP_OFFSET_LSB		12420.2f	// 36.53 deg C * 340 LSB/deg C
+
+/*
+* Destination buffers, one float per record each. Accel is in g, gyro in deg/s, temperature in deg C.
+*/
+struct MPU6050_SoA
+{
+	float* ax;
+	float* ay;
+	float* az;
+	float* temp;
+	float* gx;
+	float* gy;
+	float* gz;
+};
+
+/*
+* Decodes _count big endian records laid out back to back (ACCEL_XOUT_H .. GYRO_ZOUT_L) into _out.
+* The widest path compiled in is used (NEON on aarch64, AVX2 or SSSE3 on x86) and the scalar path handles the tail.
+* Every path computes (float)raw * scale, and the temperature as ((float)raw + MPU6050_TEMP_OFFSET_LSB) * (1 / 340),
+* which has no multiply-add the compiler could contract, so all paths are bit exact with MPU6050_decodeBlockScalar().
+* The input is never read past the last record.
+*/
+void MPU6050_decodeBlock(const unsigned char* _records, unsigned int _count, const MPU6050_SoA& _out,
+						float _accelScaleInv, float _gyroScaleInv);
+
+/*
+* Reference implementation, one record at a time.
+*/
+void MPU6050_decodeBlockScalar(const unsigned char* _records, unsigned int _count, const MPU6050_SoA& _out,
+						float _accelScaleInv, float _gyroScaleInv);
+
+/*
+* Name of the path MPU6050_decodeBlock() was compiled with ("neon", "avx2", "ssse3" or "scalar")
+*/
+const char* MPU6050_decodeBlockPath(void);
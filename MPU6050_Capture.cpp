@@ -0,0 +1,293 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Binary capture files of MPU6050 samples, block writer and memory mapped reader
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Page aligned blocks written with O_DIRECT, block headers as the time index
+*/
+
+
+#include "MPU6050_Capture.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+MPU6050_CaptureConfig MPU6050_captureConfig(const MPU6050_RaspbPi& _device)
+{
+	MPU6050_CaptureConfig config = {};
+	config.accelScale = _device.getAccelScale();
+	config.gyroScale = _device.getGyroScale();
+	config.outputRateHz = _device.getOutputRate();
+	config.deviceAddress = _device.getDeviceAddress();
+	return config;
+}
+
+MPU6050_CaptureWriter::MPU6050_CaptureWriter(const char* _path, const MPU6050_CaptureConfig& _config,
+											unsigned int _blockBytes, bool _direct) noexcept(false) : m_fd(-1)
+																									, m_direct(false)
+																									, m_block(nullptr)
+																									, m_page(nullptr)
+																									, m_header()
+																									, m_blockIndex(0)
+																									, m_blockRecords(0)
+																									, m_records(0)
+																									, m_lastTimestamp(0)
+{
+	struct timespec now;
+	unsigned int blockBytes = (_blockBytes + MPU6050_CAPTURE_PAGE_SIZE - 1U) & ~(MPU6050_CAPTURE_PAGE_SIZE - 1U);
+	if (blockBytes < MPU6050_CAPTURE_PAGE_SIZE) blockBytes = MPU6050_CAPTURE_PAGE_SIZE;
+
+	if (_direct)
+	{
+		m_fd = open(_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+		m_direct = m_fd >= 0;
+	}
+	// tmpfs and some others refuse O_DIRECT with EINVAL
+	if (m_fd < 0) m_fd = open(_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (m_fd < 0)
+	{
+		throw std::runtime_error(std::string("Error Creating Capture File"));
+	}
+	if (posix_memalign((void**)&m_block, MPU6050_CAPTURE_PAGE_SIZE, blockBytes) != 0
+		|| posix_memalign((void**)&m_page, MPU6050_CAPTURE_PAGE_SIZE, MPU6050_CAPTURE_PAGE_SIZE) != 0)
+	{
+		free(m_block);
+		::close(m_fd);
+		throw std::runtime_error(std::string("Error Allocating Capture Buffers"));
+	}
+	memset(m_block, 0x00, blockBytes);
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	memcpy(m_header.magic, MPU6050_CAPTURE_MAGIC, sizeof(m_header.magic));
+	m_header.version = MPU6050_CAPTURE_VERSION;
+	m_header.byteOrder = MPU6050_CAPTURE_BYTE_ORDER;
+	m_header.headerBytes = MPU6050_CAPTURE_PAGE_SIZE;
+	m_header.blockBytes = blockBytes;
+	m_header.recordBytes = sizeof(MPU6050_Sample);
+	m_header.recordsPerBlock = (blockBytes - (unsigned int)sizeof(MPU6050_CaptureBlock)) / (unsigned int)sizeof(MPU6050_Sample);
+	m_header.config = _config;
+	m_header.created_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+
+	if (writeHeader() < 0)
+	{
+		free(m_block);
+		free(m_page);
+		::close(m_fd);
+		throw std::runtime_error(std::string("Error Writing Capture Header"));
+	}
+}
+
+MPU6050_CaptureWriter::~MPU6050_CaptureWriter(void)
+{
+	close();
+	free(m_block);
+	free(m_page);
+}
+
+int MPU6050_CaptureWriter::writeHeader(void)
+{
+	memset(m_page, 0x00, MPU6050_CAPTURE_PAGE_SIZE);
+	memcpy(m_page, &m_header, sizeof(m_header));
+	return pwrite(m_fd, m_page, MPU6050_CAPTURE_PAGE_SIZE, 0) == (ssize_t)MPU6050_CAPTURE_PAGE_SIZE ? 1 : -1;
+}
+
+/*
+* The block is always written whole, O_DIRECT needs aligned lengths and the reader relies on the fixed stride
+*/
+int MPU6050_CaptureWriter::writeBlock(void)
+{
+	MPU6050_CaptureBlock* header = (MPU6050_CaptureBlock*)m_block;
+	const MPU6050_Sample* records = (const MPU6050_Sample*)(m_block + sizeof(MPU6050_CaptureBlock));
+	off_t offset = (off_t)m_header.headerBytes + (off_t)(m_blockIndex * m_header.blockBytes);
+	ssize_t written;
+
+	header->magic = MPU6050_CAPTURE_BLOCK_MAGIC;
+	header->records = m_blockRecords;
+	header->firstTimestamp = records[0].timestamp;
+	header->lastTimestamp = records[m_blockRecords - 1U].timestamp;
+	header->firstSequence = records[0].sequence;
+
+	do
+	{
+		written = pwrite(m_fd, m_block, m_header.blockBytes, offset);
+	} while (written < 0 && errno == EINTR);
+	return written == (ssize_t)m_header.blockBytes ? 1 : -1;
+}
+
+int MPU6050_CaptureWriter::append(const MPU6050_Sample* _samples, unsigned int _count)
+{
+	MPU6050_Sample* records = (MPU6050_Sample*)(m_block + sizeof(MPU6050_CaptureBlock));
+	unsigned int n;
+
+	if (m_fd < 0) return -1;
+	// checked up front so a rejected batch leaves nothing behind
+	for (unsigned int i = 0; i < _count; i++)
+		if (_samples[i].timestamp < (i == 0 ? m_lastTimestamp : _samples[i - 1U].timestamp)) return -1;
+	if (_count > 0) m_lastTimestamp = _samples[_count - 1U].timestamp;
+
+	for (unsigned int i = 0; i < _count; i += n)
+	{
+		n = m_header.recordsPerBlock - m_blockRecords;
+		if (n > _count - i) n = _count - i;
+		memcpy(&records[m_blockRecords], &_samples[i], n * sizeof(MPU6050_Sample));
+		m_blockRecords += n;
+		m_records += n;
+
+		if (m_blockRecords == m_header.recordsPerBlock)
+		{
+			if (writeBlock() < 0) return -1;
+			m_blockIndex++;
+			m_blockRecords = 0;
+		}
+	}
+	return (int)_count;
+}
+
+int MPU6050_CaptureWriter::flush(void)
+{
+	if (m_fd < 0) return -1;
+	if (m_blockRecords > 0)
+	{
+		// clear what a previous flush of this block left behind the valid records
+		memset(m_block + sizeof(MPU6050_CaptureBlock) + m_blockRecords * sizeof(MPU6050_Sample), 0x00,
+				(m_header.recordsPerBlock - m_blockRecords) * sizeof(MPU6050_Sample));
+		if (writeBlock() < 0) return -1;
+	}
+	m_header.records = m_records;
+	m_header.lastTimestamp = m_lastTimestamp;
+	return writeHeader();
+}
+
+int MPU6050_CaptureWriter::close(void)
+{
+	int result;
+	if (m_fd < 0) return 1;
+	m_header.closed = 1;
+	result = flush();
+	if (fdatasync(m_fd) < 0) result = -1;
+	::close(m_fd);
+	m_fd = -1;
+	return result;
+}
+
+MPU6050_CaptureReader::MPU6050_CaptureReader(const char* _path) noexcept(false) : m_fd(-1)
+																				, m_map(nullptr)
+																				, m_mapBytes(0)
+																				, m_header(nullptr)
+																				, m_blocks(0)
+																				, m_records(0)
+{
+	struct stat info;
+	void* map;
+
+	m_fd = open(_path, O_RDONLY | O_CLOEXEC);
+	if (m_fd < 0)
+	{
+		throw std::runtime_error(std::string("Error Opening Capture File"));
+	}
+	if (fstat(m_fd, &info) < 0 || (uint64_t)info.st_size < MPU6050_CAPTURE_PAGE_SIZE)
+	{
+		::close(m_fd);
+		throw std::runtime_error(std::string("Capture File Too Short"));
+	}
+	m_mapBytes = (uint64_t)info.st_size;
+	map = mmap(nullptr, m_mapBytes, PROT_READ, MAP_SHARED, m_fd, 0);
+	if (map == MAP_FAILED)
+	{
+		::close(m_fd);
+		throw std::runtime_error(std::string("Error Mapping Capture File"));
+	}
+	m_map = (const unsigned char*)map;
+	m_header = (const MPU6050_CaptureHeader*)m_map;
+
+	if (memcmp(m_header->magic, MPU6050_CAPTURE_MAGIC, sizeof(m_header->magic)) != 0
+		|| m_header->version != MPU6050_CAPTURE_VERSION || m_header->byteOrder != MPU6050_CAPTURE_BYTE_ORDER
+		|| m_header->recordBytes != sizeof(MPU6050_Sample) || m_header->headerBytes < sizeof(MPU6050_CaptureHeader)
+		|| m_header->blockBytes < sizeof(MPU6050_CaptureBlock) + sizeof(MPU6050_Sample)
+		|| m_header->recordsPerBlock != (m_header->blockBytes - sizeof(MPU6050_CaptureBlock)) / sizeof(MPU6050_Sample))
+	{
+		munmap(map, m_mapBytes);
+		::close(m_fd);
+		throw std::runtime_error(std::string("Not A Capture File"));
+	}
+
+	// a block only counts once it is complete on disk; an interrupted last write leaves a short tail that is ignored
+	if (m_mapBytes > m_header->headerBytes) m_blocks = (m_mapBytes - m_header->headerBytes) / m_header->blockBytes;
+	while (m_blocks > 0 && (block(m_blocks - 1U)->magic != MPU6050_CAPTURE_BLOCK_MAGIC || block(m_blocks - 1U)->records == 0
+							|| block(m_blocks - 1U)->records > m_header->recordsPerBlock)) m_blocks--;
+	if (m_blocks > 0) m_records = (m_blocks - 1U) * m_header->recordsPerBlock + block(m_blocks - 1U)->records;
+}
+
+MPU6050_CaptureReader::~MPU6050_CaptureReader(void)
+{
+	munmap((void*)m_map, m_mapBytes);
+	::close(m_fd);
+}
+
+const MPU6050_Sample* MPU6050_CaptureReader::records(uint64_t _index, unsigned int& _contiguous) const
+{
+	uint64_t perBlock = m_header->recordsPerBlock;
+	uint64_t end;
+
+	_contiguous = 0;
+	if (_index >= m_records) return nullptr;
+	end = (_index / perBlock + 1U) * perBlock;
+	if (end > m_records) end = m_records;
+	_contiguous = (unsigned int)(end - _index);
+	return &record(_index);
+}
+
+uint64_t MPU6050_CaptureReader::find(uint64_t _timestamp) const
+{
+	uint64_t low = 0, high = m_blocks, middle;
+	const MPU6050_Sample* records;
+	unsigned int count, first, last, half;
+
+	if (m_records == 0) return 0;
+	// first block whose last record is at or after _timestamp
+	while (low < high)
+	{
+		middle = low + (high - low) / 2U;
+		if (block(middle)->lastTimestamp < _timestamp) low = middle + 1U;
+		else high = middle;
+	}
+	if (low == m_blocks) return m_records;
+
+	records = (const MPU6050_Sample*)((const unsigned char*)block(low) + sizeof(MPU6050_CaptureBlock));
+	count = block(low)->records;
+	first = 0;
+	last = count;
+	while (first < last)
+	{
+		half = first + (last - first) / 2U;
+		if (records[half].timestamp < _timestamp) first = half + 1U;
+		else last = half;
+	}
+	return low * m_header->recordsPerBlock + first;
+}
+
+uint64_t MPU6050_CaptureReader::findRange(uint64_t _from, uint64_t _to, uint64_t& _first) const
+{
+	uint64_t end;
+	_first = find(_from);
+	if (_to <= _from) return 0;
+	end = find(_to);
+	return end - _first;
+}
@@ -0,0 +1,200 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Binary capture files of MPU6050 samples, block writer and memory mapped reader
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Page aligned blocks written with O_DIRECT, block headers as the time index
+*/
+
+
+#pragma once
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include "MPU6050_RaspbPi.h"
+
+#define MPU6050_CAPTURE_MAGIC			"MPU6050C"
+#define MPU6050_CAPTURE_VERSION			1U
+#define MPU6050_CAPTURE_BYTE_ORDER		0x01020304U		// written in host order, a reader on the other endianness sees 0x04030201
+#define MPU6050_CAPTURE_PAGE_SIZE		4096U			// header size and block alignment, also what O_DIRECT needs
+#define MPU6050_CAPTURE_BLOCK_SIZE		65536U			// default, 2046 records per block
+#define MPU6050_CAPTURE_BLOCK_MAGIC		0x4B4C4243U		// "CBLK"
+
+/*
+* Device settings of the recording, filled by the caller or by MPU6050_captureConfig()
+*/
+struct MPU6050_CaptureConfig
+{
+	double accelScale;			// LSB per g
+	double gyroScale;			// LSB per deg/s
+	uint32_t outputRateHz;
+	uint8_t deviceAddress;
+	uint8_t reserved[3];
+};
+
+/*
+* First page of the file. records and lastTimestamp are only valid when the writer was closed cleanly
+* (closed == 1), the reader does not depend on them.
+*/
+struct MPU6050_CaptureHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t headerBytes;		// offset of the first block
+	uint32_t blockBytes;
+	uint32_t recordBytes;		// sizeof(MPU6050_Sample)
+	uint32_t recordsPerBlock;
+	MPU6050_CaptureConfig config;
+	uint64_t created_ns;		// CLOCK_REALTIME when the file was created
+	uint64_t records;
+	uint64_t lastTimestamp;
+	uint32_t closed;
+	uint32_t reserved;
+};
+
+/*
+* Every block starts with this header, followed by recordsPerBlock MPU6050_Sample records (records of them valid).
+* All blocks but the last are full, so record n is in block n / recordsPerBlock. The block headers are the sparse
+* time index: one entry per recordsPerBlock records, at a fixed stride, searchable without reading any records.
+*/
+struct MPU6050_CaptureBlock
+{
+	uint32_t magic;
+	uint32_t records;
+	uint64_t firstTimestamp;
+	uint64_t lastTimestamp;
+	uint64_t firstSequence;
+	uint8_t reserved[32];
+};
+static_assert(sizeof(MPU6050_CaptureBlock) == 64, "MPU6050_CaptureBlock must stay 64 bytes");
+static_assert(sizeof(MPU6050_CaptureHeader) <= MPU6050_CAPTURE_PAGE_SIZE, "MPU6050_CaptureHeader must fit the first page");
+
+/*
+* Scales, output rate and address of a configured device
+*/
+MPU6050_CaptureConfig MPU6050_captureConfig(const MPU6050_RaspbPi& _device);
+
+/*
+* Append only writer. Records are collected in a page aligned block buffer and written one block per pwrite(),
+* with O_DIRECT where the file system supports it (the page cache is bypassed, a long recording does not push
+* everything else out of memory), plain buffered writes otherwise.
+* Timestamps must not decrease, the reader binary searches on them.
+* Not thread safe; fed from the consumer side of an MPU6050_Acquisition ring, for example.
+*/
+class MPU6050_CaptureWriter
+{
+private:
+	int m_fd;
+	bool m_direct;
+	unsigned char* m_block;			// MPU6050_CAPTURE_PAGE_SIZE aligned, blockBytes long
+	unsigned char* m_page;			// header page, aligned as well
+	MPU6050_CaptureHeader m_header;
+	uint64_t m_blockIndex;			// block being filled
+	unsigned int m_blockRecords;
+	uint64_t m_records;
+	uint64_t m_lastTimestamp;
+
+	int writeBlock(void);
+	int writeHeader(void);
+
+public:
+	/*
+	* Creates (truncates) _path and writes the header page. _blockBytes is rounded up to a multiple of
+	* MPU6050_CAPTURE_PAGE_SIZE. Throws std::runtime_error when the file cannot be created.
+	*/
+	MPU6050_CaptureWriter(const char* _path, const MPU6050_CaptureConfig& _config,
+						unsigned int _blockBytes = MPU6050_CAPTURE_BLOCK_SIZE, bool _direct = true) noexcept(false);
+	~MPU6050_CaptureWriter(void);
+	MPU6050_CaptureWriter() = delete;
+	MPU6050_CaptureWriter(const MPU6050_CaptureWriter&) = delete;
+	MPU6050_CaptureWriter& operator = (const MPU6050_CaptureWriter&) = delete;
+
+	/*
+	* Copies _count samples into the block buffer, every full block goes to the file right away.
+	* @return _count or -1 on a write error or a timestamp older than the previous one
+	*/
+	int append(const MPU6050_Sample* _samples, unsigned int _count);
+
+	/*
+	* Writes the partly filled block (padded to its full size) and the header, so a reader sees every record
+	* appended so far. Appending continues in the same block, which is written again when it fills up.
+	* close() does this and marks the header closed, the destructor calls close().
+	*/
+	int flush(void);
+	int close(void);
+
+	bool isDirect(void) const { return m_direct; }
+	uint64_t getRecords(void) const { return m_records; }
+	unsigned int getRecordsPerBlock(void) const { return m_header.recordsPerBlock; }
+};
+
+/*
+* Read only view of a capture file. The whole file is mapped, records are returned as pointers into the mapping,
+* nothing is copied or parsed up front. find() is a binary search over the block headers followed by one over the
+* records of a block. A file that is still being written can be opened, it shows the blocks flushed so far.
+*/
+class MPU6050_CaptureReader
+{
+private:
+	int m_fd;
+	const unsigned char* m_map;
+	uint64_t m_mapBytes;
+	const MPU6050_CaptureHeader* m_header;
+	uint64_t m_blocks;
+	uint64_t m_records;
+
+	const MPU6050_CaptureBlock* block(uint64_t _index) const
+	{
+		return (const MPU6050_CaptureBlock*)(m_map + m_header->headerBytes + _index * m_header->blockBytes);
+	}
+
+public:
+	/*
+	* Throws std::runtime_error when the file cannot be mapped or is not a capture file of this version,
+	* record size and byte order.
+	*/
+	explicit MPU6050_CaptureReader(const char* _path) noexcept(false);
+	~MPU6050_CaptureReader(void);
+	MPU6050_CaptureReader() = delete;
+	MPU6050_CaptureReader(const MPU6050_CaptureReader&) = delete;
+	MPU6050_CaptureReader& operator = (const MPU6050_CaptureReader&) = delete;
+
+	const MPU6050_CaptureHeader& header(void) const { return *m_header; }
+	const MPU6050_CaptureConfig& config(void) const { return m_header->config; }
+	uint64_t getRecords(void) const { return m_records; }
+	uint64_t getBlocks(void) const { return m_blocks; }
+
+	/*
+	* Record _index and the number of records stored contiguously from it (up to the end of its block) in
+	* _contiguous. nullptr past the end.
+	*/
+	const MPU6050_Sample* records(uint64_t _index, unsigned int& _contiguous) const;
+	const MPU6050_Sample& record(uint64_t _index) const
+	{
+		uint64_t perBlock = m_header->recordsPerBlock;
+		return ((const MPU6050_Sample*)((const unsigned char*)block(_index / perBlock) + sizeof(MPU6050_CaptureBlock)))[_index % perBlock];
+	}
+
+	/*
+	* Index of the first record with a timestamp >= _timestamp, getRecords() when there is none. O(log n).
+	*/
+	uint64_t find(uint64_t _timestamp) const;
+
+	/*
+	* Records with _from <= timestamp < _to: first index in _first, number of records returned.
+	*/
+	uint64_t findRange(uint64_t _from, uint64_t _to, uint64_t& _first) const;
+};
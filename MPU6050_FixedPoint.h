@@ -0,0 +1,180 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Fixed point conversion of raw MPU6050 samples, integer only at run time
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Q15 (fraction of full scale) and Q16.16 (g, deg/s, deg C) formats with constexpr scale tables
+*/
+
+
+#pragma once
+#include <stdint.h>
+#include <limits>
+#include "MPU6050_RegisterMap.h"
+
+#define MPU6050_FIXED_SHIFT		16U		// fraction bits of the multipliers
+#define MPU6050_FIXED_RANGES	4U		// full scale settings per sensor, MPU6050_ACCEL_FS_2 .. _16, MPU6050_GYRO_FS_250 .. _2000
+
+/*
+* Output format. _FracBits fraction bits in _Type. Engineering formats give g, deg/s and deg C,
+* per unit formats give accel and gyro as a fraction of the selected full scale range (the raw value itself for Q15)
+* and the temperature in units of MPU6050_FIXED_TEMP_UNIT deg C.
+*/
+template <typename _Type, unsigned int _FracBits, bool _PerUnit>
+struct MPU6050_FixedFormat
+{
+	typedef _Type value_type;
+	static constexpr unsigned int FRAC_BITS = _FracBits;
+	static constexpr bool PER_UNIT = _PerUnit;
+};
+
+typedef MPU6050_FixedFormat<int16_t, 15U, true> MPU6050_Q15;
+typedef MPU6050_FixedFormat<int32_t, 16U, false> MPU6050_Q16_16;
+
+#define MPU6050_FIXED_TEMP_UNIT	128.0	// deg C per 1.0 of a per unit temperature
+
+/*
+* Multiplier for raw * multiplier >> MPU6050_FIXED_SHIFT. Only ever evaluated at compile time.
+*/
+constexpr int64_t MPU6050_fixedMultiplier(double _lsbPerUnit, unsigned int _fracBits)
+{
+	return (int64_t)((double)(1ULL << (_fracBits + MPU6050_FIXED_SHIFT)) / _lsbPerUnit + 0.5);
+}
+
+constexpr int64_t MPU6050_fixedOffset(double _value, unsigned int _fracBits)
+{
+	return (int64_t)(_value * (double)(1ULL << _fracBits) + (_value < 0.0 ? -0.5 : 0.5));
+}
+
+/*
+* True when every int16 input converts into [_min, _max], the conversion then needs no saturation
+*/
+constexpr bool MPU6050_fixedFits(int64_t _multiplier, int64_t _offset, int64_t _min, int64_t _max)
+{
+	return ((32767LL * _multiplier + (1LL << (MPU6050_FIXED_SHIFT - 1))) >> MPU6050_FIXED_SHIFT) + _offset <= _max
+		&& ((-32768LL * _multiplier + (1LL << (MPU6050_FIXED_SHIFT - 1))) >> MPU6050_FIXED_SHIFT) + _offset >= _min;
+}
+
+/*
+* Scale factors of a format, indexed by the FS_SEL / AFS_SEL value
+*/
+template <typename _Format>
+struct MPU6050_FixedScale
+{
+	static constexpr double ACCEL_LSB[MPU6050_FIXED_RANGES] = { MPU6050_ACCEL_FS_2_SCALE, MPU6050_ACCEL_FS_4_SCALE,
+																MPU6050_ACCEL_FS_8_SCALE, MPU6050_ACCEL_FS_16_SCALE };
+	static constexpr double GYRO_LSB[MPU6050_FIXED_RANGES] = { MPU6050_GYRO_FS_250_SCALE, MPU6050_GYRO_FS_500_SCALE,
+																MPU6050_GYRO_FS_1000_SCALE, MPU6050_GYRO_FS_2000_SCALE };
+	// LSB per output unit: full scale is 32768 LSB in a per unit format
+	static constexpr double accelLsbPerUnit(unsigned int _range) { return _Format::PER_UNIT ? 32768.0 : ACCEL_LSB[_range]; }
+	static constexpr double gyroLsbPerUnit(unsigned int _range) { return _Format::PER_UNIT ? 32768.0 : GYRO_LSB[_range]; }
+
+	static constexpr int64_t ACCEL[MPU6050_FIXED_RANGES] = {
+		MPU6050_fixedMultiplier(accelLsbPerUnit(0), _Format::FRAC_BITS), MPU6050_fixedMultiplier(accelLsbPerUnit(1), _Format::FRAC_BITS),
+		MPU6050_fixedMultiplier(accelLsbPerUnit(2), _Format::FRAC_BITS), MPU6050_fixedMultiplier(accelLsbPerUnit(3), _Format::FRAC_BITS) };
+	static constexpr int64_t GYRO[MPU6050_FIXED_RANGES] = {
+		MPU6050_fixedMultiplier(gyroLsbPerUnit(0), _Format::FRAC_BITS), MPU6050_fixedMultiplier(gyroLsbPerUnit(1), _Format::FRAC_BITS),
+		MPU6050_fixedMultiplier(gyroLsbPerUnit(2), _Format::FRAC_BITS), MPU6050_fixedMultiplier(gyroLsbPerUnit(3), _Format::FRAC_BITS) };
+	// raw / 340 + 36.53 deg C
+	static constexpr int64_t TEMP = MPU6050_fixedMultiplier(_Format::PER_UNIT ? 340.0 * MPU6050_FIXED_TEMP_UNIT : 340.0, _Format::FRAC_BITS);
+	static constexpr int64_t TEMP_OFFSET = MPU6050_fixedOffset(_Format::PER_UNIT ? 36.53 / MPU6050_FIXED_TEMP_UNIT : 36.53, _Format::FRAC_BITS);
+
+	// saturation is only compiled in where some raw value can leave the output type (e.g. Q15 temperatures above 128 deg C)
+	static constexpr int64_t MIN = (int64_t)std::numeric_limits<typename _Format::value_type>::min();
+	static constexpr int64_t MAX = (int64_t)std::numeric_limits<typename _Format::value_type>::max();
+	static constexpr bool ACCEL_SATURATES = !(MPU6050_fixedFits(ACCEL[0], 0, MIN, MAX) && MPU6050_fixedFits(ACCEL[1], 0, MIN, MAX)
+											&& MPU6050_fixedFits(ACCEL[2], 0, MIN, MAX) && MPU6050_fixedFits(ACCEL[3], 0, MIN, MAX));
+	static constexpr bool GYRO_SATURATES = !(MPU6050_fixedFits(GYRO[0], 0, MIN, MAX) && MPU6050_fixedFits(GYRO[1], 0, MIN, MAX)
+											&& MPU6050_fixedFits(GYRO[2], 0, MIN, MAX) && MPU6050_fixedFits(GYRO[3], 0, MIN, MAX));
+	static constexpr bool TEMP_SATURATES = !MPU6050_fixedFits(TEMP, TEMP_OFFSET, MIN, MAX);
+};
+
+#if __cplusplus < 201703L
+// indexed at run time, so C++14 needs the definitions (C++17 static constexpr members are inline)
+template <typename _Format> constexpr double MPU6050_FixedScale<_Format>::ACCEL_LSB[MPU6050_FIXED_RANGES];
+template <typename _Format> constexpr double MPU6050_FixedScale<_Format>::GYRO_LSB[MPU6050_FIXED_RANGES];
+template <typename _Format> constexpr int64_t MPU6050_FixedScale<_Format>::ACCEL[MPU6050_FIXED_RANGES];
+template <typename _Format> constexpr int64_t MPU6050_FixedScale<_Format>::GYRO[MPU6050_FIXED_RANGES];
+template <typename _Format> constexpr int64_t MPU6050_FixedScale<_Format>::TEMP;
+template <typename _Format> constexpr int64_t MPU6050_FixedScale<_Format>::TEMP_OFFSET;
+template <typename _Format> constexpr int64_t MPU6050_FixedScale<_Format>::MIN;
+template <typename _Format> constexpr int64_t MPU6050_FixedScale<_Format>::MAX;
+template <typename _Format> constexpr bool MPU6050_FixedScale<_Format>::ACCEL_SATURATES;
+template <typename _Format> constexpr bool MPU6050_FixedScale<_Format>::GYRO_SATURATES;
+template <typename _Format> constexpr bool MPU6050_FixedScale<_Format>::TEMP_SATURATES;
+#endif
+
+/*
+* raw * _multiplier >> MPU6050_FIXED_SHIFT rounded to nearest, plus _offset, saturated to the output type
+* when _Saturate (see MPU6050_FixedScale::ACCEL_SATURATES and friends)
+*/
+template <typename _Format, bool _Saturate = true>
+static inline typename _Format::value_type MPU6050_toFixed(int16_t _raw, int64_t _multiplier, int64_t _offset = 0)
+{
+	typedef typename _Format::value_type T;
+	int64_t value = (((int64_t)_raw * _multiplier + (1LL << (MPU6050_FIXED_SHIFT - 1))) >> MPU6050_FIXED_SHIFT) + _offset;
+	if (_Saturate)
+	{
+		if (value > (int64_t)std::numeric_limits<T>::max()) return std::numeric_limits<T>::max();
+		if (value < (int64_t)std::numeric_limits<T>::min()) return std::numeric_limits<T>::min();
+	}
+	return (T)value;
+}
+
+static inline int16_t MPU6050_fixedWord(const unsigned char* _records, unsigned int _record, unsigned int _channel)
+{
+	const unsigned char* p = &_records[_record * 14U + 2U * _channel];
+	return (int16_t)((p[0] << 8) | p[1]);
+}
+
+/*
+* Destination buffers for MPU6050_decodeBlockFixed(), one value per record each
+*/
+template <typename _Type>
+struct MPU6050_FixedSoA
+{
+	_Type* ax;
+	_Type* ay;
+	_Type* az;
+	_Type* temp;
+	_Type* gx;
+	_Type* gy;
+	_Type* gz;
+};
+
+/*
+* Fixed point counterpart of MPU6050_decodeBlock(): _count big endian 14 byte records into _out, with the
+* AFS_SEL / FS_SEL values the records were taken with. Integer only, one pass per channel so the compiler can
+* vectorize each.
+*/
+template <typename _Format>
+void MPU6050_decodeBlockFixed(const unsigned char* _records, unsigned int _count,
+							const MPU6050_FixedSoA<typename _Format::value_type>& _out,
+							unsigned char _accelRange, unsigned char _gyroRange)
+{
+	typedef MPU6050_FixedScale<_Format> Scale;
+	const int64_t accel = Scale::ACCEL[_accelRange & (MPU6050_FIXED_RANGES - 1U)];
+	const int64_t gyro = Scale::GYRO[_gyroRange & (MPU6050_FIXED_RANGES - 1U)];
+	typename _Format::value_type* dst[7] = { _out.ax, _out.ay, _out.az, _out.temp, _out.gx, _out.gy, _out.gz };
+
+	for (unsigned int c = 0; c < 3; c++)
+		for (unsigned int i = 0; i < _count; i++)
+			dst[c][i] = MPU6050_toFixed<_Format, Scale::ACCEL_SATURATES>(MPU6050_fixedWord(_records, i, c), accel);
+	for (unsigned int i = 0; i < _count; i++)
+		dst[3][i] = MPU6050_toFixed<_Format, Scale::TEMP_SATURATES>(MPU6050_fixedWord(_records, i, 3), Scale::TEMP, Scale::TEMP_OFFSET);
+	for (unsigned int c = 4; c < 7; c++)
+		for (unsigned int i = 0; i < _count; i++)
+			dst[c][i] = MPU6050_toFixed<_Format, Scale::GYRO_SATURATES>(MPU6050_fixedWord(_records, i, c), gyro);
+}
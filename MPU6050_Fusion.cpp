@@ -0,0 +1,381 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Orientation filters over batches of decoded MPU6050 samples
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Complementary, Madgwick and Mahony filters, single precision, NEON / SSE accelerometer normalization
+*
+* The filter recursion depends on the previous sample, so only the preparation of a chunk is vectorized:
+* 4 or 8 samples per vector, rsqrt estimate plus one Newton step, lanes with a zero accelerometer vector masked to 0.
+*/
+
+#include "MPU6050_Fusion.h"
+#include <math.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MPU6050_FUSION_NEON
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define MPU6050_FUSION_AVX
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MPU6050_FUSION_SSE
+#endif
+
+static const float kDegToRad = 0.0174532925f;
+static const float kRadToDeg = 57.2957795f;
+
+/*
+* Normalized accelerometer and gyro in rad/s of one chunk
+*/
+struct FusionChunk
+{
+	float ax[MPU6050_FUSION_CHUNK];
+	float ay[MPU6050_FUSION_CHUNK];
+	float az[MPU6050_FUSION_CHUNK];
+	float gx[MPU6050_FUSION_CHUNK];
+	float gy[MPU6050_FUSION_CHUNK];
+	float gz[MPU6050_FUSION_CHUNK];
+	float dt[MPU6050_FUSION_CHUNK];
+};
+
+static inline void prepareSample(const MPU6050_SoA& _in, unsigned int _i, FusionChunk& _chunk, unsigned int _k)
+{
+	float normSq = _in.ax[_i] * _in.ax[_i] + _in.ay[_i] * _in.ay[_i] + _in.az[_i] * _in.az[_i];
+	float inv = normSq > 0.0f ? MPU6050_invSqrt(normSq) : 0.0f;
+	_chunk.ax[_k] = _in.ax[_i] * inv;
+	_chunk.ay[_k] = _in.ay[_i] * inv;
+	_chunk.az[_k] = _in.az[_i] * inv;
+	_chunk.gx[_k] = _in.gx[_i] * kDegToRad;
+	_chunk.gy[_k] = _in.gy[_i] * kDegToRad;
+	_chunk.gz[_k] = _in.gz[_i] * kDegToRad;
+}
+
+#if defined(MPU6050_FUSION_NEON)
+
+#define MPU6050_FUSION_LANES	4U
+
+static inline void prepareGroup(const MPU6050_SoA& _in, unsigned int _i, FusionChunk& _chunk, unsigned int _k)
+{
+	const float32x4_t deg = vdupq_n_f32(kDegToRad);
+	float32x4_t ax = vld1q_f32(_in.ax + _i);
+	float32x4_t ay = vld1q_f32(_in.ay + _i);
+	float32x4_t az = vld1q_f32(_in.az + _i);
+	float32x4_t normSq = vmlaq_f32(vmlaq_f32(vmulq_f32(ax, ax), ay, ay), az, az);
+	float32x4_t inv = vrsqrteq_f32(normSq);
+	inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(normSq, inv), inv));
+	inv = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(inv), vcgtq_f32(normSq, vdupq_n_f32(0.0f))));
+
+	vst1q_f32(_chunk.ax + _k, vmulq_f32(ax, inv));
+	vst1q_f32(_chunk.ay + _k, vmulq_f32(ay, inv));
+	vst1q_f32(_chunk.az + _k, vmulq_f32(az, inv));
+	vst1q_f32(_chunk.gx + _k, vmulq_f32(vld1q_f32(_in.gx + _i), deg));
+	vst1q_f32(_chunk.gy + _k, vmulq_f32(vld1q_f32(_in.gy + _i), deg));
+	vst1q_f32(_chunk.gz + _k, vmulq_f32(vld1q_f32(_in.gz + _i), deg));
+}
+
+#elif defined(MPU6050_FUSION_AVX)
+
+#define MPU6050_FUSION_LANES	8U
+
+static inline void prepareGroup(const MPU6050_SoA& _in, unsigned int _i, FusionChunk& _chunk, unsigned int _k)
+{
+	const __m256 deg = _mm256_set1_ps(kDegToRad);
+	__m256 ax = _mm256_loadu_ps(_in.ax + _i);
+	__m256 ay = _mm256_loadu_ps(_in.ay + _i);
+	__m256 az = _mm256_loadu_ps(_in.az + _i);
+	__m256 normSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay)), _mm256_mul_ps(az, az));
+	__m256 inv = _mm256_rsqrt_ps(normSq);
+	inv = _mm256_mul_ps(inv, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), normSq), _mm256_mul_ps(inv, inv))));
+	inv = _mm256_and_ps(inv, _mm256_cmp_ps(normSq, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+	_mm256_storeu_ps(_chunk.ax + _k, _mm256_mul_ps(ax, inv));
+	_mm256_storeu_ps(_chunk.ay + _k, _mm256_mul_ps(ay, inv));
+	_mm256_storeu_ps(_chunk.az + _k, _mm256_mul_ps(az, inv));
+	_mm256_storeu_ps(_chunk.gx + _k, _mm256_mul_ps(_mm256_loadu_ps(_in.gx + _i), deg));
+	_mm256_storeu_ps(_chunk.gy + _k, _mm256_mul_ps(_mm256_loadu_ps(_in.gy + _i), deg));
+	_mm256_storeu_ps(_chunk.gz + _k, _mm256_mul_ps(_mm256_loadu_ps(_in.gz + _i), deg));
+}
+
+#elif defined(MPU6050_FUSION_SSE)
+
+#define MPU6050_FUSION_LANES	4U
+
+static inline void prepareGroup(const MPU6050_SoA& _in, unsigned int _i, FusionChunk& _chunk, unsigned int _k)
+{
+	const __m128 deg = _mm_set1_ps(kDegToRad);
+	__m128 ax = _mm_loadu_ps(_in.ax + _i);
+	__m128 ay = _mm_loadu_ps(_in.ay + _i);
+	__m128 az = _mm_loadu_ps(_in.az + _i);
+	__m128 normSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)), _mm_mul_ps(az, az));
+	__m128 inv = _mm_rsqrt_ps(normSq);
+	inv = _mm_mul_ps(inv, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), normSq), _mm_mul_ps(inv, inv))));
+	inv = _mm_and_ps(inv, _mm_cmpgt_ps(normSq, _mm_setzero_ps()));
+
+	_mm_storeu_ps(_chunk.ax + _k, _mm_mul_ps(ax, inv));
+	_mm_storeu_ps(_chunk.ay + _k, _mm_mul_ps(ay, inv));
+	_mm_storeu_ps(_chunk.az + _k, _mm_mul_ps(az, inv));
+	_mm_storeu_ps(_chunk.gx + _k, _mm_mul_ps(_mm_loadu_ps(_in.gx + _i), deg));
+	_mm_storeu_ps(_chunk.gy + _k, _mm_mul_ps(_mm_loadu_ps(_in.gy + _i), deg));
+	_mm_storeu_ps(_chunk.gz + _k, _mm_mul_ps(_mm_loadu_ps(_in.gz + _i), deg));
+}
+
+#endif
+
+MPU6050_Fusion::MPU6050_Fusion(MPU6050_FusionFilter _filter, float _samplePeriod) : m_filter(_filter)
+																					, m_beta(MPU6050_FUSION_MADGWICK_BETA)
+																					, m_kp(MPU6050_FUSION_MAHONY_KP)
+																					, m_ki(MPU6050_FUSION_MAHONY_KI)
+																					, m_alpha(MPU6050_FUSION_ALPHA)
+																					, m_samplePeriod(_samplePeriod)
+																					, m_lastTimestamp(0)
+{
+	reset();
+}
+
+void MPU6050_Fusion::reset(void)
+{
+	m_q[0] = 1.0f;
+	m_q[1] = m_q[2] = m_q[3] = 0.0f;
+	m_integral[0] = m_integral[1] = m_integral[2] = 0.0f;
+	m_aligned = false;
+}
+
+/*
+* Roll and pitch from gravity, yaw 0. _a is normalized.
+*/
+void MPU6050_Fusion::align(float _ax, float _ay, float _az)
+{
+	float roll = atan2f(_ay, _az);
+	float pitch = atan2f(-_ax, sqrtf(_ay * _ay + _az * _az));
+	float cr = cosf(0.5f * roll), sr = sinf(0.5f * roll);
+	float cp = cosf(0.5f * pitch), sp = sinf(0.5f * pitch);
+
+	m_q[0] = cr * cp;
+	m_q[1] = sr * cp;
+	m_q[2] = cr * sp;
+	m_q[3] = -sr * sp;
+	m_aligned = true;
+}
+
+/*
+* Gyro integration, then a rotation by (1 - alpha) of the angle between the measured and the predicted gravity
+*/
+void MPU6050_Fusion::updateComplementary(float _gx, float _gy, float _gz, float _ax, float _ay, float _az, float _dt)
+{
+	float w = m_q[0], x = m_q[1], y = m_q[2], z = m_q[3];
+	float h = 0.5f * _dt;
+	float inv, vx, vy, vz, ex, ey, ez, k;
+
+	w += h * (-x * _gx - y * _gy - z * _gz);
+	x += h * (m_q[0] * _gx + y * _gz - z * _gy);
+	y += h * (m_q[0] * _gy - m_q[1] * _gz + z * _gx);
+	z += h * (m_q[0] * _gz + m_q[1] * _gy - m_q[2] * _gx);
+
+	if (_ax != 0.0f || _ay != 0.0f || _az != 0.0f)
+	{
+		// gravity in the sensor frame as predicted by the quaternion, error is measured x predicted
+		vx = 2.0f * (x * z - w * y);
+		vy = 2.0f * (w * x + y * z);
+		vz = w * w - x * x - y * y + z * z;
+		k = 0.5f * (1.0f - m_alpha);
+		ex = k * (_ay * vz - _az * vy);
+		ey = k * (_az * vx - _ax * vz);
+		ez = k * (_ax * vy - _ay * vx);
+
+		float qw = w, qx = x, qy = y;
+		w -= qx * ex + qy * ey + z * ez;
+		x += qw * ex + qy * ez - z * ey;
+		y += qw * ey - qx * ez + z * ex;
+		z += qw * ez + qx * ey - qy * ex;
+	}
+
+	inv = MPU6050_invSqrt(w * w + x * x + y * y + z * z);
+	m_q[0] = w * inv;
+	m_q[1] = x * inv;
+	m_q[2] = y * inv;
+	m_q[3] = z * inv;
+}
+
+/*
+* Madgwick's IMU update: gyro rate minus beta along the normalized gradient of the gravity error
+*/
+void MPU6050_Fusion::updateMadgwick(float _gx, float _gy, float _gz, float _ax, float _ay, float _az, float _dt)
+{
+	float w = m_q[0], x = m_q[1], y = m_q[2], z = m_q[3];
+	float dw = 0.5f * (-x * _gx - y * _gy - z * _gz);
+	float dx = 0.5f * (w * _gx + y * _gz - z * _gy);
+	float dy = 0.5f * (w * _gy - x * _gz + z * _gx);
+	float dz = 0.5f * (w * _gz + x * _gy - y * _gx);
+	float inv;
+
+	if (_ax != 0.0f || _ay != 0.0f || _az != 0.0f)
+	{
+		float w2 = 2.0f * w, x2 = 2.0f * x, y2 = 2.0f * y, z2 = 2.0f * z;
+		float w4 = 4.0f * w, x4 = 4.0f * x, y4 = 4.0f * y;
+		float x8 = 8.0f * x, y8 = 8.0f * y;
+		float ww = w * w, xx = x * x, yy = y * y, zz = z * z;
+
+		float sw = w4 * yy + y2 * _ax + w4 * xx - x2 * _ay;
+		float sx = x4 * zz - z2 * _ax + 4.0f * ww * x - w2 * _ay - x4 + x8 * xx + x8 * yy + x4 * _az;
+		float sy = 4.0f * ww * y + w2 * _ax + y4 * zz - z2 * _ay - y4 + y8 * xx + y8 * yy + y4 * _az;
+		float sz = 4.0f * xx * z - x2 * _ax + 4.0f * yy * z - y2 * _ay;
+		float normSq = sw * sw + sx * sx + sy * sy + sz * sz;
+
+		if (normSq > 0.0f)
+		{
+			inv = m_beta * MPU6050_invSqrt(normSq);
+			dw -= inv * sw;
+			dx -= inv * sx;
+			dy -= inv * sy;
+			dz -= inv * sz;
+		}
+	}
+
+	w += dw * _dt;
+	x += dx * _dt;
+	y += dy * _dt;
+	z += dz * _dt;
+	inv = MPU6050_invSqrt(w * w + x * x + y * y + z * z);
+	m_q[0] = w * inv;
+	m_q[1] = x * inv;
+	m_q[2] = y * inv;
+	m_q[3] = z * inv;
+}
+
+/*
+* Mahony's IMU update: proportional and integral feedback of the gravity error added to the gyro rate
+*/
+void MPU6050_Fusion::updateMahony(float _gx, float _gy, float _gz, float _ax, float _ay, float _az, float _dt)
+{
+	float w = m_q[0], x = m_q[1], y = m_q[2], z = m_q[3];
+	float inv;
+
+	if (_ax != 0.0f || _ay != 0.0f || _az != 0.0f)
+	{
+		float vx = x * z - w * y;
+		float vy = w * x + y * z;
+		float vz = w * w - 0.5f + z * z;
+		float ex = _ay * vz - _az * vy;
+		float ey = _az * vx - _ax * vz;
+		float ez = _ax * vy - _ay * vx;
+
+		if (m_ki > 0.0f)
+		{
+			m_integral[0] += 2.0f * m_ki * ex * _dt;
+			m_integral[1] += 2.0f * m_ki * ey * _dt;
+			m_integral[2] += 2.0f * m_ki * ez * _dt;
+			_gx += m_integral[0];
+			_gy += m_integral[1];
+			_gz += m_integral[2];
+		}
+		_gx += 2.0f * m_kp * ex;
+		_gy += 2.0f * m_kp * ey;
+		_gz += 2.0f * m_kp * ez;
+	}
+
+	_gx *= 0.5f * _dt;
+	_gy *= 0.5f * _dt;
+	_gz *= 0.5f * _dt;
+	w += -x * _gx - y * _gy - z * _gz;
+	x += m_q[0] * _gx + y * _gz - z * _gy;
+	y += m_q[0] * _gy - m_q[1] * _gz + z * _gx;
+	z += m_q[0] * _gz + m_q[1] * _gy - m_q[2] * _gx;
+	inv = MPU6050_invSqrt(w * w + x * x + y * y + z * z);
+	m_q[0] = w * inv;
+	m_q[1] = x * inv;
+	m_q[2] = y * inv;
+	m_q[3] = z * inv;
+}
+
+unsigned int MPU6050_Fusion::update(const MPU6050_SoA& _in, const uint64_t* _timestamps, unsigned int _count, const MPU6050_OrientationSoA& _out)
+{
+	FusionChunk chunk;
+	uint64_t period_ns = (uint64_t)(m_samplePeriod * 1e9f);
+	uint64_t timestamp;
+	unsigned int n, k, i;
+
+	for (unsigned int base = 0; base < _count; base += n)
+	{
+		n = _count - base < MPU6050_FUSION_CHUNK ? _count - base : MPU6050_FUSION_CHUNK;
+
+		k = 0;
+#if defined(MPU6050_FUSION_NEON) || defined(MPU6050_FUSION_AVX) || defined(MPU6050_FUSION_SSE)
+		for (; k + MPU6050_FUSION_LANES <= n; k += MPU6050_FUSION_LANES)
+			prepareGroup(_in, base + k, chunk, k);
+#endif
+		for (; k < n; k++)
+			prepareSample(_in, base + k, chunk, k);
+
+		for (k = 0; k < n; k++)
+		{
+			timestamp = _timestamps ? _timestamps[base + k] : m_lastTimestamp + period_ns;
+			chunk.dt[k] = (m_lastTimestamp == 0 || timestamp <= m_lastTimestamp) ? m_samplePeriod : (float)(timestamp - m_lastTimestamp) * 1e-9f;
+			if (_out.timestamp) _out.timestamp[base + k] = timestamp;
+			m_lastTimestamp = timestamp;
+		}
+
+		for (k = 0; k < n; k++)
+		{
+			i = base + k;
+			if (!m_aligned && (chunk.ax[k] != 0.0f || chunk.ay[k] != 0.0f || chunk.az[k] != 0.0f))
+				align(chunk.ax[k], chunk.ay[k], chunk.az[k]);
+			switch (m_filter)
+			{
+			case MPU6050_FUSION_COMPLEMENTARY:
+				updateComplementary(chunk.gx[k], chunk.gy[k], chunk.gz[k], chunk.ax[k], chunk.ay[k], chunk.az[k], chunk.dt[k]);
+				break;
+			case MPU6050_FUSION_MAHONY:
+				updateMahony(chunk.gx[k], chunk.gy[k], chunk.gz[k], chunk.ax[k], chunk.ay[k], chunk.az[k], chunk.dt[k]);
+				break;
+			default:
+				updateMadgwick(chunk.gx[k], chunk.gy[k], chunk.gz[k], chunk.ax[k], chunk.ay[k], chunk.az[k], chunk.dt[k]);
+				break;
+			}
+			_out.qw[i] = m_q[0];
+			_out.qx[i] = m_q[1];
+			_out.qy[i] = m_q[2];
+			_out.qz[i] = m_q[3];
+		}
+	}
+
+	if (_out.roll)
+	{
+		for (i = 0; i < _count; i++)
+		{
+			float w = _out.qw[i], x = _out.qx[i], y = _out.qy[i], z = _out.qz[i];
+			float sinPitch = 2.0f * (w * y - z * x);
+			sinPitch = sinPitch > 1.0f ? 1.0f : (sinPitch < -1.0f ? -1.0f : sinPitch);
+			_out.roll[i] = kRadToDeg * atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y));
+			_out.pitch[i] = kRadToDeg * asinf(sinPitch);
+			_out.yaw[i] = kRadToDeg * atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z));
+		}
+	}
+	return _count;
+}
+
+const char* MPU6050_Fusion::preparePath(void)
+{
+#if defined(MPU6050_FUSION_NEON)
+	return "neon";
+#elif defined(MPU6050_FUSION_AVX)
+	return "avx";
+#elif defined(MPU6050_FUSION_SSE)
+	return "sse";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,142 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Orientation filters over batches of decoded MPU6050 samples
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Complementary, Madgwick and Mahony filters, single precision, NEON / SSE accelerometer normalization
+*/
+
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include "MPU6050_BulkDecoder.h"
+
+#define MPU6050_FUSION_CHUNK		64U			// samples prepared per pass, scratch lives on the stack
+#define MPU6050_FUSION_MADGWICK_BETA	0.1f
+#define MPU6050_FUSION_MAHONY_KP	1.0f
+#define MPU6050_FUSION_MAHONY_KI	0.0f
+#define MPU6050_FUSION_ALPHA		0.98f		// complementary filter: weight of the gyro per sample
+
+enum MPU6050_FusionFilter
+{
+	MPU6050_FUSION_COMPLEMENTARY,
+	MPU6050_FUSION_MADGWICK,
+	MPU6050_FUSION_MAHONY
+};
+
+/*
+* Destination buffers, one entry per sample. The quaternion (w, x, y, z) rotates the sensor frame into the
+* reference frame (Z up). roll / pitch / yaw are in degrees (Z-Y-X order) and skipped when roll is nullptr,
+* timestamp is skipped when nullptr.
+*/
+struct MPU6050_OrientationSoA
+{
+	float* qw;
+	float* qx;
+	float* qy;
+	float* qz;
+	float* roll;
+	float* pitch;
+	float* yaw;
+	uint64_t* timestamp;
+};
+
+/*
+* 1 / sqrt(_x) from the exponent trick and two Newton steps, relative error below 5e-6. One step leaves up to
+* 0.18 %, which the filters would see as a steady shrink of the quaternion.
+*/
+static inline float MPU6050_invSqrt(float _x)
+{
+	uint32_t bits;
+	float y;
+	memcpy(&bits, &_x, sizeof(bits));
+	bits = 0x5F375A86U - (bits >> 1);
+	memcpy(&y, &bits, sizeof(y));
+	y = y * (1.5f - 0.5f * _x * y * y);
+	return y * (1.5f - 0.5f * _x * y * y);
+}
+
+/*
+* Streaming 6 axis orientation filter. update() takes the output of MPU6050_decodeBlock() (accel in g, gyro in
+* deg/s, temp is not used) with the CLOCK_MONOTONIC timestamps of the samples and continues from the state the
+* previous batch left. Every batch is processed in chunks of MPU6050_FUSION_CHUNK: the per sample work that does
+* not depend on the filter state (accelerometer normalization, gyro to rad/s, time steps) runs vectorized over the
+* chunk, then the filter recursion runs once per sample.
+*
+* Without a magnetometer yaw is the integrated gyro and drifts with its bias (see calibrate()).
+* The first sample with a usable accelerometer reading sets roll and pitch directly, so the filters do not have
+* to converge from the identity after start or reset().
+* Not thread safe, one instance per sensor.
+*/
+class MPU6050_Fusion
+{
+private:
+	MPU6050_FusionFilter m_filter;
+	float m_q[4];					// w, x, y, z
+	float m_integral[3];			// Mahony integral feedback, rad/s
+	float m_beta;
+	float m_kp;
+	float m_ki;
+	float m_alpha;
+	float m_samplePeriod;			// s, used when there are no timestamps
+	uint64_t m_lastTimestamp;		// ns, 0 before the first sample
+	bool m_aligned;
+
+	void align(float _ax, float _ay, float _az);
+	void updateComplementary(float _gx, float _gy, float _gz, float _ax, float _ay, float _az, float _dt);
+	void updateMadgwick(float _gx, float _gy, float _gz, float _ax, float _ay, float _az, float _dt);
+	void updateMahony(float _gx, float _gy, float _gz, float _ax, float _ay, float _az, float _dt);
+
+public:
+	explicit MPU6050_Fusion(MPU6050_FusionFilter _filter = MPU6050_FUSION_MADGWICK, float _samplePeriod = 0.001f);
+
+	/*
+	* Identity orientation, cleared Mahony integral. The next batch aligns to gravity again.
+	*/
+	void reset(void);
+
+	void setFilter(MPU6050_FusionFilter _filter) { m_filter = _filter; }
+	MPU6050_FusionFilter getFilter(void) const { return m_filter; }
+
+	/*
+	* Madgwick gradient descent gain (rad/s), Mahony proportional and integral gains, complementary filter
+	* gyro weight per sample (1 - _alpha of the tilt error is corrected every sample).
+	*/
+	void setMadgwickBeta(float _beta) { m_beta = _beta; }
+	void setMahonyGains(float _kp, float _ki) { m_kp = _kp; m_ki = _ki; }
+	void setComplementaryAlpha(float _alpha) { m_alpha = _alpha; }
+
+	/*
+	* Time step used when update() gets no timestamps, and for a timestamp that does not advance.
+	* Normally 1 / getOutputRate().
+	*/
+	void setSamplePeriod(float _seconds) { m_samplePeriod = _seconds; }
+
+	/*
+	* Runs the filter over _count samples of _in. _timestamps may be nullptr, then the samples are taken to be
+	* setSamplePeriod() apart and the output timestamps continue from the last one.
+	* An accelerometer reading of 0 (free fall, missing axis) skips the correction for that sample.
+	* @return _count
+	*/
+	unsigned int update(const MPU6050_SoA& _in, const uint64_t* _timestamps, unsigned int _count, const MPU6050_OrientationSoA& _out);
+
+	void getQuaternion(float& _w, float& _x, float& _y, float& _z) const { _w = m_q[0]; _x = m_q[1]; _y = m_q[2]; _z = m_q[3]; }
+
+	/*
+	* Name of the path the batch preparation was compiled with ("neon", "avx", "sse" or "scalar")
+	*/
+	static const char* preparePath(void);
+};
@@ -17,17 +17,34 @@
 * Unauthorized Distrubution is strictly prohibited.
 * Rev 1: Added Startup code 
 * Rev 2: Finished the ACCEL GYRO and TEMP sensor data acquition functions // TODO: OFFSET data calibration
+* Rev 3: FIFO burst acquisition with overflow detection and resync
+* Rev 4: Allocation free read path into MPU6050_Sample, bswap decode and reciprocal scales
+* Rev 5: Data ready interrupt through GPIO edge events
+* Rev 6: FIFO drained with chunked bulk reads, one I2C_RDWR call for a full FIFO
+* Rev 7: Register access through the owned UNR_I2CHandle
+* Rev 8: Configuration register shadow, initialize() is one read and one write transaction
+* Rev 9: Sample rate, DLPF, standby axes and the matching sample read window
+* Rev 10: Offset calibration into the XA..ZA_OFFS / XG..ZG_OFFS_USR registers, calibration cache file
+* Rev 11: Auxiliary I2C master reads in the sample burst and in the FIFO frames
+* Rev 12: DMP memory access in bank batches, firmware upload with verification, quaternion packets
+* Rev 13: Full scale range indices kept for the fixed point conversion
+* Rev 14: DMP start address checked against the 12 bank memory
+* Rev 15: Partial FIFO frames / DMP packets are left for the next drain instead of resetting the FIFO
+* Rev 16: Samples go through stampSamples() after every read
 */
 
 
 #include "MPU6050_RaspbPi.h"
+#include "UNR_GPIO_BCM2711.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
 
 int MPU6050_RaspbPi::initialize(void)
 {
-	//Check for the correct IC
+	//Check for the correct IC, the shadowed configuration registers come along in the same transaction
 	resetBuffer();
-	accessRegisterID = MPU6050_RA_WHO_AM_I;
-	if (this->i2c_readReg(tempBuffer[0], accessRegisterID, SINGLE_BYTE_TRANSACTION) < 0) return -1;
+	if (refreshShadow(tempBuffer[0]) < 0) return -1;
 	if (tempBuffer[0] == 0x68)
 	{
 		printf("MPU6050 IC Detected!\n");
@@ -40,28 +57,120 @@ int MPU6050_RaspbPi::initialize(void)
 	setClockSource(MPU6050_CLOCK_PLL_XGYRO);
 	setFullScaleGyroRange(MPU6050_GYRO_FS_250);
 	setFullScaleAccelRange(MPU6050_ACCEL_FS_2);
-	setSleepEnabled(false); 
+	setSleepEnabled(false);
+	// GYRO_CONFIG..ACCEL_CONFIG and PWR_MGMT_1 in one I2C_RDWR call
+	return commit() < 0 ? -1 : 1;
 }
 
-int MPU6050_RaspbPi::getClockSource(unsigned char _in)
+int MPU6050_RaspbPi::refreshShadow(unsigned char& _whoAmI)
 {
-	resetBuffer();
-	accessRegisterID = MPU6050_RA_PWR_MGMT_1;
-	return (this->i2c_readReg(_in, accessRegisterID, SINGLE_BYTE_TRANSACTION));	
+	unsigned char firstRegister[MPU6050_SHADOW_RANGE_COUNT + 1U];
+
+	m_i2c.i2c_clearQueue();
+	firstRegister[0] = MPU6050_RA_WHO_AM_I;
+	m_i2c.i2c_queueReadReg(_whoAmI, firstRegister[0], SINGLE_BYTE_TRANSACTION);
+	for (unsigned int i = 0; i < MPU6050_SHADOW_RANGE_COUNT; i++)
+	{
+		firstRegister[i + 1U] = MPU6050_SHADOW_RANGES[i].first;
+		m_i2c.i2c_queueReadReg(m_shadow[MPU6050_SHADOW_RANGES[i].first], firstRegister[i + 1U], MPU6050_SHADOW_RANGES[i].count);
+	}
+	if (m_i2c.i2c_submit() < 0) return -1;
+
+	for (unsigned int i = 0; i < MPU6050_SHADOW_RANGE_COUNT; i++)
+	{
+		for (unsigned int r = MPU6050_SHADOW_RANGES[i].first; r < MPU6050_SHADOW_RANGES[i].first + MPU6050_SHADOW_RANGES[i].count; r++)
+		{
+			m_shadowState[r] = MPU6050_SHADOW_CACHED;
+			m_shadowPulse[r] = 0x00;
+		}
+	}
+	updateSampleWindow();
+	updateAuxLayout();
+	return 1;
+}
+
+/*
+* Stages _value under _mask (plus the self clearing _pulse bits) in the shadow. Registers without a shadow, or before
+* refreshShadow(), are read-modify-written right away instead.
+* Output: 0 when staged, otherwise the result of the write
+*/
+int MPU6050_RaspbPi::stageRegisterBits(unsigned char _register, unsigned char _mask, unsigned char _value, unsigned char _pulse)
+{
+	unsigned char value;
+	if (!(m_shadowState[_register] & MPU6050_SHADOW_CACHED))
+	{
+		resetBuffer();
+		accessRegisterID = _register;
+		if (m_i2c.i2c_readReg(tempBuffer[0], accessRegisterID, SINGLE_BYTE_TRANSACTION) < 0) return -1;
+		tempBuffer[1] = (tempBuffer[0] & ~_mask) | (_value & _mask) | _pulse;
+		return (m_i2c.i2c_writeReg(tempBuffer[1], accessRegisterID, SINGLE_BYTE_TRANSACTION));
+	}
+	value = (m_shadow[_register] & ~_mask) | (_value & _mask);
+	if (value != m_shadow[_register] || _pulse != 0x00)
+	{
+		m_shadow[_register] = value;
+		m_shadowPulse[_register] |= _pulse;
+		m_shadowState[_register] |= MPU6050_SHADOW_DIRTY;
+	}
+	return 0;
+}
+
+int MPU6050_RaspbPi::commit(void)
+{
+	unsigned int used = 0;
+	unsigned int bursts = 0;
+	unsigned int last, r;
+
+	m_i2c.i2c_clearQueue();
+	for (unsigned int reg = 0; reg < MPU6050_SHADOW_SIZE; reg++)
+	{
+		if (!(m_shadowState[reg] & MPU6050_SHADOW_DIRTY)) continue;
+		// the burst runs on over shadowed registers as far as the last dirty one
+		last = reg;
+		for (r = reg + 1U; r < MPU6050_SHADOW_SIZE && (m_shadowState[r] & MPU6050_SHADOW_CACHED); r++)
+			if (m_shadowState[r] & MPU6050_SHADOW_DIRTY) last = r;
+
+		m_commitBuffer[used] = (unsigned char)reg;
+		for (r = reg; r <= last; r++)
+			m_commitBuffer[used + 1U + r - reg] = m_shadow[r] | m_shadowPulse[r];
+		m_i2c.i2c_queueWrite(m_commitBuffer[used], (unsigned short)(last - reg + 2U));
+		used += last - reg + 2U;
+		bursts++;
+		reg = last;
+	}
+	if (bursts == 0) return 0;
+	if (m_i2c.i2c_submit() < 0) return -1;
+
+	for (unsigned int reg = 0; reg < MPU6050_SHADOW_SIZE; reg++)
+	{
+		m_shadowState[reg] &= ~MPU6050_SHADOW_DIRTY;
+		m_shadowPulse[reg] = 0x00;
+	}
+	return (int)bursts;
+}
+
+bool MPU6050_RaspbPi::shadowDirty(void) const
+{
+	for (unsigned int reg = 0; reg < MPU6050_SHADOW_SIZE; reg++)
+		if (m_shadowState[reg] & MPU6050_SHADOW_DIRTY) return true;
+	return false;
+}
+
+int MPU6050_RaspbPi::getClockSource(void) const
+{
+	if (!(m_shadowState[MPU6050_RA_PWR_MGMT_1] & MPU6050_SHADOW_CACHED)) return -1;
+	return m_shadow[MPU6050_RA_PWR_MGMT_1] & 0b00000111;
 }
 
 int MPU6050_RaspbPi::setClockSource(unsigned char _source) 
 {
-	if (getClockSource(tempBuffer[0]) < 0) return -1;
-	tempBuffer[1] = tempBuffer[0] |  ((_source) & 0b00000111);
-	return (this->i2c_writeReg(tempBuffer[1], accessRegisterID, SINGLE_BYTE_TRANSACTION));
+	return stageRegisterBits(MPU6050_RA_PWR_MGMT_1, 0b00000111, _source);
 }
 
-int MPU6050_RaspbPi::getFullScaleGyroRange(unsigned char _in)
+int MPU6050_RaspbPi::getFullScaleGyroRange(void) const
 {
-	resetBuffer();
-	accessRegisterID = MPU6050_RA_GYRO_CONFIG;
-	return this->i2c_readReg(_in, accessRegisterID, SINGLE_BYTE_TRANSACTION);
+	if (!(m_shadowState[MPU6050_RA_GYRO_CONFIG] & MPU6050_SHADOW_CACHED)) return -1;
+	return (m_shadow[MPU6050_RA_GYRO_CONFIG] & 0b00011000) >> (MPU6050_GCONFIG_FS_SEL_BIT - 1);
 }
 
 int MPU6050_RaspbPi::setFullScaleGyroRange(unsigned char _scale)
@@ -72,19 +181,19 @@ int MPU6050_RaspbPi::setFullScaleGyroRange(unsigned char _scale)
 		case MPU6050_GYRO_FS_500:  gyroScale = MPU6050_GYRO_FS_500_SCALE; break;
 		case MPU6050_GYRO_FS_1000: gyroScale = MPU6050_GYRO_FS_1000_SCALE; break;
 		case MPU6050_GYRO_FS_2000: gyroScale = MPU6050_GYRO_FS_2000_SCALE; break;
-		default: gyroScale = MPU6050_GYRO_FS_250_SCALE; break;
+		default: gyroScale = MPU6050_GYRO_FS_250_SCALE; _scale = MPU6050_GYRO_FS_250; break;
 	}
-	if (getFullScaleGyroRange(tempBuffer[0]) < 0) return -1;
-	tempBuffer[1] = tempBuffer[0] | ((_scale << (MPU6050_GCONFIG_FS_SEL_BIT-1)) & 0b00011000);
-	return (this->i2c_writeReg(tempBuffer[1], accessRegisterID, SINGLE_BYTE_TRANSACTION));
+	gyroScaleInv = 1.0 / gyroScale;
+	gyroRange = _scale;
+	// the mask clears the previous range, OR-ing alone could only ever widen it
+	return stageRegisterBits(MPU6050_RA_GYRO_CONFIG, 0b00011000, (unsigned char)(_scale << (MPU6050_GCONFIG_FS_SEL_BIT - 1)));
 }
 
 
-int MPU6050_RaspbPi::getFullScaleAccelRange(unsigned char _in)
+int MPU6050_RaspbPi::getFullScaleAccelRange(void) const
 {
-	resetBuffer();
-	accessRegisterID = MPU6050_RA_ACCEL_CONFIG;
-	return (this->i2c_readReg(_in, accessRegisterID, SINGLE_BYTE_TRANSACTION));
+	if (!(m_shadowState[MPU6050_RA_ACCEL_CONFIG] & MPU6050_SHADOW_CACHED)) return -1;
+	return (m_shadow[MPU6050_RA_ACCEL_CONFIG] & 0b00011000) >> (MPU6050_ACONFIG_AFS_SEL_BIT - 1);
 }
 
 int MPU6050_RaspbPi::setFullScaleAccelRange(unsigned char _scale)
@@ -95,81 +204,633 @@ int MPU6050_RaspbPi::setFullScaleAccelRange(unsigned char _scale)
 		case MPU6050_ACCEL_FS_4: accelScale = MPU6050_ACCEL_FS_4_SCALE; break;
 		case MPU6050_ACCEL_FS_8: accelScale = MPU6050_ACCEL_FS_8_SCALE; break;
 		case MPU6050_ACCEL_FS_16: accelScale = MPU6050_ACCEL_FS_16_SCALE; break;
-		default: accelScale = MPU6050_ACCEL_FS_2_SCALE; break;
+		default: accelScale = MPU6050_ACCEL_FS_2_SCALE; _scale = MPU6050_ACCEL_FS_2; break;
 	}
-	if (getFullScaleAccelRange(tempBuffer[0]) < 0) return -1;
-	tempBuffer[1] = tempBuffer[0] | ((_scale << (MPU6050_ACONFIG_AFS_SEL_BIT-1)) & 0b00011000);
-	return (this->i2c_writeReg(tempBuffer[1], accessRegisterID, SINGLE_BYTE_TRANSACTION));
+	accelScaleInv = 1.0 / accelScale;
+	accelRange = _scale;
+	return stageRegisterBits(MPU6050_RA_ACCEL_CONFIG, 0b00011000, (unsigned char)(_scale << (MPU6050_ACONFIG_AFS_SEL_BIT - 1)));
 }
 
-bool MPU6050_RaspbPi::getSleepEnabled()
+bool MPU6050_RaspbPi::getSleepEnabled() const
 {
-	resetBuffer();
-	accessRegisterID = MPU6050_RA_PWR_MGMT_1;
-	if (this->i2c_readReg(tempBuffer[0], accessRegisterID, SINGLE_BYTE_TRANSACTION) < 0)
-		return false;
-	return (tempBuffer[0] && (1U << (MPU6050_PWR1_SLEEP_BIT)));
+	return (m_shadow[MPU6050_RA_PWR_MGMT_1] & (1U << MPU6050_PWR1_SLEEP_BIT)) != 0;
 }
 
 int MPU6050_RaspbPi::setSleepEnabled(bool _in)
 {
-	resetBuffer();
-	accessRegisterID = MPU6050_RA_PWR_MGMT_1;
-	if (this->i2c_readReg(tempBuffer[0], accessRegisterID, SINGLE_BYTE_TRANSACTION) < 0)
-		return -1;
-	
-	_in == true ? tempBuffer[0] |= (1U << MPU6050_PWR1_SLEEP_BIT) : tempBuffer[0] &= 0xBF;
-
-	if (this->i2c_writeReg(tempBuffer[0], accessRegisterID, SINGLE_BYTE_TRANSACTION) < 0)
-		return -1;
-	if (this->i2c_readReg(tempBuffer[0], accessRegisterID, SINGLE_BYTE_TRANSACTION) < 0)
-		return -1;
-	return 1;
+	return stageRegisterBits(MPU6050_RA_PWR_MGMT_1, (1U << MPU6050_PWR1_SLEEP_BIT), _in ? 0xFF : 0x00);
 }
 
 int MPU6050_RaspbPi::getSensorValues()
 { 
-	if (this->i2c_readReg(m_sensorvalues->sensorValues_t.Accelx_t.u8_AXData[0], accessSensorValuesRegister, 14U) < 0) return -1;
-	m_sensorvalues->swapAllBytes();		
+	return getSample(m_sample);
+}
+
+int MPU6050_RaspbPi::getSample(MPU6050_Sample& _sample)
+{
+	if (m_i2c.i2c_readReg(*(unsigned char*)&_sample.raw[m_windowFirst], accessSensorValuesRegister, m_windowBytes) < 0) return -1;
+	_sample.timestamp = MPU6050_timestampNow();
+	_sample.sequence = m_sequence++;
+	decodeWindow(_sample);
+	stampSamples(&_sample, 1U, false);
 	return 1;
 }
 
-int MPU6050_RaspbPi::getDoubleSensorValues(double* accel, double* gyro, double* temperature)
+void MPU6050_RaspbPi::decodeWindow(MPU6050_Sample& _sample) const
 {
-	if (getSensorValues() > 0)
+	if (m_windowBytes == MPU6050_FIFO_FRAME_SIZE)
+	{
+		MPU6050_decodeSample(_sample);
+		return;
+	}
+	for (unsigned int i = 0; i < MPU6050_CHANNELS; i++)
 	{
-		accel[0] = (double)_f2sComplement(m_sensorvalues->sensorValues_t.Accelx_t.u16_AXData) / accelScale;
-		accel[1] = (double)_f2sComplement(m_sensorvalues->sensorValues_t.Accely_t.u16_AYData) / accelScale;
-		accel[2] = (double)_f2sComplement(m_sensorvalues->sensorValues_t.Accelz_t.u16_AZData) / accelScale;
+		if (i >= m_windowFirst && i < m_windowFirst + (m_windowBytes >> 1U))
+			_sample.raw[i] = (int16_t)__builtin_bswap16((uint16_t)_sample.raw[i]);
+		else
+			_sample.raw[i] = 0;
+	}
+}
+
+int MPU6050_RaspbPi::setDLPFMode(unsigned char _bandwidth)
+{
+	return stageRegisterBits(MPU6050_RA_CONFIG, 0b00000111, _bandwidth);
+}
 
-		temperature[0] = (double)(_f2sComplement(m_sensorvalues->sensorValues_t.Temperature_t.u16_TData)) / 340.00 + 36.53;
+int MPU6050_RaspbPi::setOutputRate(unsigned int _rateHz)
+{
+	unsigned char dlpf = m_shadow[MPU6050_RA_CONFIG] & 0b00000111;
+	unsigned int gyroRate = (dlpf == MPU6050_DLPF_BW_256 || dlpf == 0x07) ? MPU6050_GYRO_RATE_DLPF_OFF : MPU6050_GYRO_RATE_DLPF_ON;
+	unsigned int divider;
 
-		gyro[0] = (double)_f2sComplement(m_sensorvalues->sensorValues_t.Gyrox_t.u16_GXData)/ gyroScale;
-		gyro[1] = (double)_f2sComplement(m_sensorvalues->sensorValues_t.Gyroy_t.u16_GYData) / gyroScale;
-		gyro[2] = (double)_f2sComplement(m_sensorvalues->sensorValues_t.Gyroz_t.u16_GZData) / gyroScale;
+	if (_rateHz == 0) return -1;
+	// Sample Rate = Gyroscope Output Rate / (1 + SMPLRT_DIV), rounded towards the slower rate
+	divider = (gyroRate + _rateHz - 1U) / _rateHz;
+	if (divider < 1U) divider = 1U;
+	if (divider > 256U) divider = 256U;
+	if (stageRegisterBits(MPU6050_RA_SMPLRT_DIV, 0xFF, (unsigned char)(divider - 1U)) < 0) return -1;
+	return (int)(gyroRate / divider);
+}
+
+unsigned int MPU6050_RaspbPi::getOutputRate(void) const
+{
+	unsigned char dlpf = m_shadow[MPU6050_RA_CONFIG] & 0b00000111;
+	unsigned int gyroRate = (dlpf == MPU6050_DLPF_BW_256 || dlpf == 0x07) ? MPU6050_GYRO_RATE_DLPF_OFF : MPU6050_GYRO_RATE_DLPF_ON;
+	return gyroRate / (1U + m_shadow[MPU6050_RA_SMPLRT_DIV]);
+}
 
+int MPU6050_RaspbPi::setStandby(unsigned char _standbyBits)
+{
+	int result = stageRegisterBits(MPU6050_RA_PWR_MGMT_2, MPU6050_STANDBY_MASK, _standbyBits);
+	updateSampleWindow();
+	return result;
+}
+
+int MPU6050_RaspbPi::setTemperatureEnabled(bool _enable)
+{
+	int result = stageRegisterBits(MPU6050_RA_PWR_MGMT_1, (1U << MPU6050_PWR1_TEMP_DIS_BIT), _enable ? 0x00 : 0xFF);
+	updateSampleWindow();
+	return result;
+}
+
+/*
+* Narrows the sample read to the registers from the first to the last enabled channel. The data registers are
+* contiguous (ACCEL, TEMP, GYRO), so one burst still covers the window.
+*/
+void MPU6050_RaspbPi::updateSampleWindow(void)
+{
+	unsigned char standby = m_shadow[MPU6050_RA_PWR_MGMT_2];
+	bool enabled[MPU6050_CHANNELS];
+	unsigned int first = 0, last = MPU6050_CHANNELS - 1U;
+
+	enabled[MPU6050_AX] = !(standby & (1U << MPU6050_PWR2_STBY_XA_BIT));
+	enabled[MPU6050_AY] = !(standby & (1U << MPU6050_PWR2_STBY_YA_BIT));
+	enabled[MPU6050_AZ] = !(standby & (1U << MPU6050_PWR2_STBY_ZA_BIT));
+	enabled[MPU6050_TEMP] = !(m_shadow[MPU6050_RA_PWR_MGMT_1] & (1U << MPU6050_PWR1_TEMP_DIS_BIT));
+	enabled[MPU6050_GX] = !(standby & (1U << MPU6050_PWR2_STBY_XG_BIT));
+	enabled[MPU6050_GY] = !(standby & (1U << MPU6050_PWR2_STBY_YG_BIT));
+	enabled[MPU6050_GZ] = !(standby & (1U << MPU6050_PWR2_STBY_ZG_BIT));
+
+	while (first < MPU6050_CHANNELS && !enabled[first]) first++;
+	if (first == MPU6050_CHANNELS)
+	{
+		// everything in standby, keep the full window
+		first = 0;
+	}
+	else
+	{
+		while (!enabled[last]) last--;
+	}
+	m_windowFirst = (unsigned char)first;
+	m_windowBytes = (unsigned short)((last - first + 1U) << 1);
+	accessSensorValuesRegister = (unsigned char)(MPU6050_RA_ACCEL_XOUT_H + (first << 1));
+}
+
+int MPU6050_RaspbPi::getDoubleSensorValues(double* accel, double* gyro, double* temperature)
+{
+	if (getSample(m_sample) > 0)
+	{
+		toDouble(m_sample, accel, gyro, temperature);
 		return 1;
 	}
 
 	else
 		return -1;
-	
-	
 }
 
-signed int MPU6050_RaspbPi::_f2sComplement(uint16_t& _in)
+int MPU6050_RaspbPi::enableDataReadyInterrupt(void)
+{
+	// active high, push-pull, 50us pulse (no latch), status cleared by any read. Bypass and FSYNC bits are left alone.
+	if (stageRegisterBits(MPU6050_RA_INT_PIN_CFG,
+							(1U << MPU6050_INTCFG_INT_LEVEL_BIT) | (1U << MPU6050_INTCFG_INT_OPEN_BIT)
+							| (1U << MPU6050_INTCFG_LATCH_INT_EN_BIT) | (1U << MPU6050_INTCFG_INT_RD_CLEAR_BIT),
+							(1U << MPU6050_INTCFG_INT_RD_CLEAR_BIT)) < 0) return -1;
+	if (stageRegisterBits(MPU6050_RA_INT_ENABLE, (1U << MPU6050_INTERRUPT_DATA_RDY_BIT), 0xFF) < 0) return -1;
+	// INT_PIN_CFG and INT_ENABLE are adjacent, one burst
+	return commit();
+}
+
+int MPU6050_RaspbPi::waitForSample(int _eventFd, MPU6050_Sample& _sample, int _timeoutMs)
+{
+	uint64_t edge = 0;
+	int result = gpio_wait_edge(_eventFd, _timeoutMs, &edge);
+	if (result <= 0) return result;
+	if (getSample(_sample) < 0) return -1;
+	_sample.timestamp = edge;
+	return 1;
+}
+
+int MPU6050_RaspbPi::enableFIFO(void)
+{
+	// the slave routing bits of FIFO_EN belong to setAuxRead()
+	if (stageRegisterBits(MPU6050_RA_FIFO_EN, 0xF8, (1U << MPU6050_TEMP_FIFO_EN_BIT) | (1U << MPU6050_XG_FIFO_EN_BIT)
+					| (1U << MPU6050_YG_FIFO_EN_BIT) | (1U << MPU6050_ZG_FIFO_EN_BIT) | (1U << MPU6050_ACCEL_FIFO_EN_BIT)) < 0) return -1;
+	if (stageRegisterBits(MPU6050_RA_INT_ENABLE, (1U << MPU6050_INTERRUPT_FIFO_OFLOW_BIT), 0xFF) < 0) return -1;
+	// FIFO_RESET is self clearing, so enabling and resetting in one write starts the stream on a frame boundary
+	if (stageRegisterBits(MPU6050_RA_USER_CTRL, (1U << MPU6050_USERCTRL_FIFO_EN_BIT), 0xFF, (1U << MPU6050_USERCTRL_FIFO_RESET_BIT)) < 0)
+		return -1;
+	return commit();
+}
+
+int MPU6050_RaspbPi::disableFIFO(void)
+{
+	if (stageRegisterBits(MPU6050_RA_FIFO_EN, 0xF8, 0x00) < 0) return -1;
+	if (stageRegisterBits(MPU6050_RA_USER_CTRL, (1U << MPU6050_USERCTRL_FIFO_EN_BIT), 0x00) < 0) return -1;
+	return commit();
+}
+
+int MPU6050_RaspbPi::resetFIFO(void)
+{
+	if (stageRegisterBits(MPU6050_RA_USER_CTRL, 0x00, 0x00, (1U << MPU6050_USERCTRL_FIFO_RESET_BIT)) < 0) return -1;
+	return commit();
+}
+
+int MPU6050_RaspbPi::getFIFOCount(unsigned short& _count)
+{
+	resetBuffer();
+	accessRegisterID = MPU6050_RA_FIFO_COUNTH;
+	if (m_i2c.i2c_readReg(tempBuffer[0], accessRegisterID, 2U) < 0) return -1;
+	_count = (unsigned short)((tempBuffer[0] << 8) | tempBuffer[1]);
+	return 1;
+}
+
+/*
+* Checks the overflow flag and the fill level, resets the FIFO after an overflow.
+* A count that is not a whole number of frames is normal, the chip is writing a frame while the count is read. The
+* complete frames are drained and the partial one stays for the next call.
+* Returns the number of complete frames to drain (at most _maxSamples), -1 on a bus error or MPU6050_FIFO_OVERFLOW
+*/
+int MPU6050_RaspbPi::checkFIFO(unsigned int _maxSamples)
 {
-	if (_in >= 0b1000000000000000)
+	unsigned short fifoCount = 0;
+	unsigned int frames;
+
+	// INT_STATUS is cleared on read, so the overflow flag is seen exactly once per overflow event
+	resetBuffer();
+	accessRegisterID = MPU6050_RA_INT_STATUS;
+	if (m_i2c.i2c_readReg(tempBuffer[0], accessRegisterID, SINGLE_BYTE_TRANSACTION) < 0) return -1;
+	if (getFIFOCount(fifoCount) < 0) return -1;
+
+	if ((tempBuffer[0] & (1U << MPU6050_INTERRUPT_FIFO_OFLOW_BIT)) || fifoCount >= MPU6050_FIFO_SIZE)
 	{
-		_in = ~(_in);
-		_in = _in + 0b0000000000000001;
-		return (0 - _in);
+		// Oldest bytes have been overwritten, the stream can not be trusted to start on a frame boundary anymore
+		m_fifoOverflows++;
+		if (resetFIFO() < 0) return -1;
+		return MPU6050_FIFO_OVERFLOW;
 	}
-	else
-		return _in;
+
+	frames = fifoCount / m_fifoFrameBytes;
+	return (int)(frames > _maxSamples ? _maxSamples : frames);
+}
+
+/*
+* Reads _frames (at most MPU6050_FIFO_SIZE / frame size) frames from FIFO_R_W and decodes them into _batch, the slave
+* bytes of every frame go to _aux when given.
+* FIFO_R_W does not auto increment, the bulk read keeps addressing it while the chunks stay below the adapter limit.
+*/
+int MPU6050_RaspbPi::readFIFOChunk(MPU6050_Sample* _batch, unsigned char* _aux, unsigned int _frames, uint64_t _timestamp)
+{
+	if (m_i2c.i2c_readBulk(m_fifoBuffer, MPU6050_RA_FIFO_R_W, _frames * m_fifoFrameBytes, false) < 0)
+		return -1;
+
+	for (unsigned int i = 0; i < _frames; i++)
+	{
+		memcpy(_batch[i].raw, &m_fifoBuffer[i * m_fifoFrameBytes], MPU6050_FIFO_FRAME_SIZE);
+		if (_aux != nullptr && m_fifoAuxBytes > 0)
+			memcpy(&_aux[i * m_fifoAuxBytes], &m_fifoBuffer[i * m_fifoFrameBytes + MPU6050_FIFO_FRAME_SIZE], m_fifoAuxBytes);
+		_batch[i].timestamp = _timestamp;
+		_batch[i].sequence = m_sequence++;
+		MPU6050_decodeSample(_batch[i]);
+	}
+	stampSamples(_batch, _frames, true);
+	return (int)_frames;
+}
+
+int MPU6050_RaspbPi::getFIFOSamples(MPU6050_Sample* _batch, unsigned int _maxSamples, unsigned char* _aux)
+{
+	uint64_t timestamp;
+	int frames = checkFIFO(_maxSamples);
+
+	if (frames < 0) return frames;
+	timestamp = MPU6050_timestampNow();
+
+	// checkFIFO() never returns more frames than the FIFO holds, so a single bulk read covers them
+	if (frames > 0 && readFIFOChunk(_batch, _aux, (unsigned int)frames, timestamp) < 0) return -1;
+	return frames;
+}
+
+int MPU6050_RaspbPi::getFIFOSensorValues(double* accel, double* gyro, double* temperature, unsigned int _maxSamples)
+{
+	MPU6050_Sample batch[MPU6050_FIFO_CHUNK_FRAMES];
+	unsigned int chunkFrames, decoded = 0;
+	uint64_t timestamp;
+	int frames = checkFIFO(_maxSamples);
+
+	if (frames < 0) return frames;
+	timestamp = MPU6050_timestampNow();
+
+	while (decoded < (unsigned int)frames)
+	{
+		chunkFrames = (unsigned int)frames - decoded;
+		if (chunkFrames > MPU6050_FIFO_CHUNK_FRAMES) chunkFrames = MPU6050_FIFO_CHUNK_FRAMES;
+		if (readFIFOChunk(batch, nullptr, chunkFrames, timestamp) < 0) return -1;
+		for (unsigned int i = 0; i < chunkFrames; i++, decoded++)
+			toDouble(batch[i], &accel[3 * decoded], &gyro[3 * decoded], &temperature[decoded]);
+	}
+	return (int)decoded;
+}
+
+int MPU6050_RaspbPi::enableAuxMaster(unsigned char _clock)
+{
+	if (stageRegisterBits(MPU6050_RA_INT_PIN_CFG, (1U << MPU6050_INTCFG_I2C_BYPASS_EN_BIT), 0x00) < 0) return -1;
+	if (stageRegisterBits(MPU6050_RA_I2C_MST_CTRL, (1U << MPU6050_WAIT_FOR_ES_BIT) | 0x0F,
+							(1U << MPU6050_WAIT_FOR_ES_BIT) | (_clock & 0x0F)) < 0) return -1;
+	return stageRegisterBits(MPU6050_RA_USER_CTRL, (1U << MPU6050_USERCTRL_I2C_MST_EN_BIT), 0xFF);
+}
+
+int MPU6050_RaspbPi::disableAuxMaster(void)
+{
+	return stageRegisterBits(MPU6050_RA_USER_CTRL, (1U << MPU6050_USERCTRL_I2C_MST_EN_BIT), 0x00);
+}
+
+int MPU6050_RaspbPi::setAuxRead(unsigned int _slave, unsigned char _address, unsigned char _register, unsigned char _length, bool _toFIFO)
+{
+	unsigned char base = (unsigned char)(MPU6050_RA_I2C_SLV0_ADDR + 3U * _slave);
+	unsigned char control;
+	unsigned int total = _length;
+
+	if (_slave >= MPU6050_AUX_SLAVES || _length == 0 || _length > MPU6050_AUX_MAX_LENGTH) return -1;
+	for (unsigned int s = 0; s < MPU6050_AUX_SLAVES; s++)
+	{
+		control = m_shadow[MPU6050_RA_I2C_SLV0_CTRL + 3U * s];
+		if (s != _slave && (control & (1U << MPU6050_I2C_SLV_EN_BIT))) total += control & 0x0F;
+	}
+	if (total > MPU6050_EXT_SENS_BYTES) return -1;
+
+	if (stageRegisterBits(base, 0xFF, (unsigned char)((1U << MPU6050_I2C_SLV_RW_BIT) | (_address & 0x7F))) < 0) return -1;
+	if (stageRegisterBits(base + 1U, 0xFF, _register) < 0) return -1;
+	if (stageRegisterBits(base + 2U, 0xFF, (unsigned char)((1U << MPU6050_I2C_SLV_EN_BIT) | _length)) < 0) return -1;
+	// slaves 0..2 are routed by FIFO_EN, slave 3 by I2C_MST_CTRL
+	if (_slave < 3U)
+	{
+		if (stageRegisterBits(MPU6050_RA_FIFO_EN, (unsigned char)(1U << (MPU6050_SLV0_FIFO_EN_BIT + _slave)), _toFIFO ? 0xFF : 0x00) < 0) return -1;
+	}
+	else if (stageRegisterBits(MPU6050_RA_I2C_MST_CTRL, (1U << MPU6050_SLV_3_FIFO_EN_BIT), _toFIFO ? 0xFF : 0x00) < 0) return -1;
+	updateAuxLayout();
+	return 0;
+}
+
+int MPU6050_RaspbPi::disableAuxRead(unsigned int _slave)
+{
+	if (_slave >= MPU6050_AUX_SLAVES) return -1;
+	if (stageRegisterBits((unsigned char)(MPU6050_RA_I2C_SLV0_CTRL + 3U * _slave), (1U << MPU6050_I2C_SLV_EN_BIT), 0x00) < 0) return -1;
+	if (_slave < 3U)
+	{
+		if (stageRegisterBits(MPU6050_RA_FIFO_EN, (unsigned char)(1U << (MPU6050_SLV0_FIFO_EN_BIT + _slave)), 0x00) < 0) return -1;
+	}
+	else if (stageRegisterBits(MPU6050_RA_I2C_MST_CTRL, (1U << MPU6050_SLV_3_FIFO_EN_BIT), 0x00) < 0) return -1;
+	updateAuxLayout();
+	return 0;
+}
+
+/*
+* EXT_SENS_DATA holds the enabled slaves back to back in slave order, the FIFO appends the routed ones in the same order
+*/
+void MPU6050_RaspbPi::updateAuxLayout(void)
+{
+	unsigned char control;
+	bool routed;
+
+	m_auxBytes = 0;
+	m_fifoAuxBytes = 0;
+	for (unsigned int s = 0; s < MPU6050_AUX_SLAVES; s++)
+	{
+		control = m_shadow[MPU6050_RA_I2C_SLV0_CTRL + 3U * s];
+		if (!(control & (1U << MPU6050_I2C_SLV_EN_BIT))) continue;
+		m_auxBytes += control & 0x0F;
+		routed = (s < 3U) ? (m_shadow[MPU6050_RA_FIFO_EN] & (1U << (MPU6050_SLV0_FIFO_EN_BIT + s))) != 0
+						: (m_shadow[MPU6050_RA_I2C_MST_CTRL] & (1U << MPU6050_SLV_3_FIFO_EN_BIT)) != 0;
+		if (routed) m_fifoAuxBytes += control & 0x0F;
+	}
+	m_fifoFrameBytes = (unsigned short)(MPU6050_FIFO_FRAME_SIZE + m_fifoAuxBytes);
+	if (m_dmpPacketBytes != 0) m_fifoFrameBytes = m_dmpPacketBytes;
+}
+
+/*
+* EXT_SENS_DATA_00 follows GYRO_ZOUT_L, so the burst runs from the sample window through the slave bytes
+*/
+int MPU6050_RaspbPi::getSampleAux(MPU6050_Sample& _sample, unsigned char* _aux)
+{
+	unsigned short sensorBytes = (unsigned short)(MPU6050_RA_EXT_SENS_DATA_00 - accessSensorValuesRegister);
+	unsigned short numBytes = (unsigned short)(sensorBytes + m_auxBytes);
+
+	if (m_i2c.i2c_readReg(m_burstBuffer[0], accessSensorValuesRegister, numBytes) < 0) return -1;
+	_sample.timestamp = MPU6050_timestampNow();
+	_sample.sequence = m_sequence++;
+	memcpy(&_sample.raw[m_windowFirst], m_burstBuffer, sensorBytes);
+	decodeWindow(_sample);
+	if (_aux != nullptr) memcpy(_aux, &m_burstBuffer[sensorBytes], m_auxBytes);
+	stampSamples(&_sample, 1U, false);
+	return 1;
+}
+
+/*
+* Stages a 16 bit register pair, big endian. Bits in _keepMask of the low byte keep their shadow value.
+*/
+void MPU6050_RaspbPi::stageWord(unsigned char _register, int16_t _value, unsigned char _keepMask)
+{
+	stageRegisterBits(_register, 0xFF, (unsigned char)(((uint16_t)_value) >> 8));
+	stageRegisterBits(_register + 1, (unsigned char)~_keepMask, (unsigned char)(((uint16_t)_value) & 0xFF));
+}
+
+int MPU6050_RaspbPi::calibrate(unsigned int _samples)
+{
+	static const unsigned char accelOffset[3] = { MPU6050_RA_XA_OFFS_H, MPU6050_RA_YA_OFFS_H, MPU6050_RA_ZA_OFFS_H };
+	static const unsigned char gyroOffset[3] = { MPU6050_RA_XG_OFFS_USRH, MPU6050_RA_YG_OFFS_USRH, MPU6050_RA_ZG_OFFS_USRH };
+	MPU6050_Sample sample;
+	double sum[MPU6050_CHANNELS] = {};
+	double bias;
+	struct timespec next;
+	uint64_t period_ns;
+	long value;
+
+	if (_samples == 0 || !(m_shadowState[MPU6050_RA_XA_OFFS_H] & MPU6050_SHADOW_CACHED)) return -1;
+	if (m_windowFirst != MPU6050_AX || m_windowBytes != MPU6050_FIFO_FRAME_SIZE) return -1;
+	if (shadowDirty() && commit() < 0) return -1;
+
+	// one read per output period, so every sample is a new conversion
+	period_ns = 1000000000ULL / getOutputRate();
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for (unsigned int i = 0; i < _samples; i++)
+	{
+		next.tv_nsec += (long)period_ns;
+		while (next.tv_nsec >= 1000000000L)
+		{
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) == EINTR) {}
+		if (getSample(sample) < 0) return -1;
+		for (unsigned int c = 0; c < MPU6050_CHANNELS; c++) sum[c] += sample.raw[c];
+	}
+
+	for (unsigned int axis = 0; axis < 3; axis++)
+	{
+		bias = sum[MPU6050_AX + axis] / _samples;
+		if (axis == 2) bias -= accelScale;		// gravity on Z
+		value = shadowWord(accelOffset[axis]) - lround(bias * MPU6050_ACCEL_OFFS_LSB_PER_G / accelScale);
+		if (value > INT16_MAX) value = INT16_MAX;
+		if (value < INT16_MIN) value = INT16_MIN;
+		stageWord(accelOffset[axis], (int16_t)value, 0x01);
+
+		bias = sum[MPU6050_GX + axis] / _samples;
+		value = shadowWord(gyroOffset[axis]) - lround(bias * MPU6050_GYRO_OFFS_LSB_PER_DPS / gyroScale);
+		if (value > INT16_MAX) value = INT16_MAX;
+		if (value < INT16_MIN) value = INT16_MIN;
+		stageWord(gyroOffset[axis], (int16_t)value, 0x00);
+	}
+	return commit() < 0 ? -1 : 1;
+}
+
+int MPU6050_RaspbPi::saveCalibration(const char* _path, const char* _busKey) const
+{
+	char line[MPU6050_CALIBRATION_LINE];
+	char key[MPU6050_CALIBRATION_LINE];
+	unsigned int address;
+	std::string temporary = std::string(_path) + ".tmp";
+	FILE* in;
+	FILE* out;
+
+	if (!(m_shadowState[MPU6050_RA_XA_OFFS_H] & MPU6050_SHADOW_CACHED)) return -1;
+	out = fopen(temporary.c_str(), "w");
+	if (out == nullptr) return -1;
+
+	// copy every other device's line, then replace this one. Written aside and renamed, a crash never leaves half a file.
+	in = fopen(_path, "r");
+	if (in != nullptr)
+	{
+		while (fgets(line, sizeof(line), in) != nullptr)
+		{
+			if (sscanf(line, "%127s %x", key, &address) == 2 && strcmp(key, _busKey) == 0 && address == m_i2c.i2c_address())
+				continue;
+			fputs(line, out);
+		}
+		fclose(in);
+	}
+	fprintf(out, "%s 0x%02x %d %d %d %d %d %d\n", _busKey, m_i2c.i2c_address(),
+			shadowWord(MPU6050_RA_XA_OFFS_H), shadowWord(MPU6050_RA_YA_OFFS_H), shadowWord(MPU6050_RA_ZA_OFFS_H),
+			shadowWord(MPU6050_RA_XG_OFFS_USRH), shadowWord(MPU6050_RA_YG_OFFS_USRH), shadowWord(MPU6050_RA_ZG_OFFS_USRH));
+	if (fclose(out) != 0 || rename(temporary.c_str(), _path) != 0)
+	{
+		unlink(temporary.c_str());
+		return -1;
+	}
+	return 1;
+}
+
+int MPU6050_RaspbPi::loadCalibration(const char* _path, const char* _busKey)
+{
+	char line[MPU6050_CALIBRATION_LINE];
+	char key[MPU6050_CALIBRATION_LINE];
+	unsigned int address;
+	int offset[6];
+	bool found = false;
+	FILE* in;
+
+	if (!(m_shadowState[MPU6050_RA_XA_OFFS_H] & MPU6050_SHADOW_CACHED)) return -1;
+	in = fopen(_path, "r");
+	if (in == nullptr) return 0;
+	while (!found && fgets(line, sizeof(line), in) != nullptr)
+	{
+		found = sscanf(line, "%127s %x %d %d %d %d %d %d", key, &address,
+						&offset[0], &offset[1], &offset[2], &offset[3], &offset[4], &offset[5]) == 8
+				&& strcmp(key, _busKey) == 0 && address == m_i2c.i2c_address();
+	}
+	fclose(in);
+	if (!found) return 0;
+
+	stageWord(MPU6050_RA_XA_OFFS_H, (int16_t)offset[0], 0x01);
+	stageWord(MPU6050_RA_YA_OFFS_H, (int16_t)offset[1], 0x01);
+	stageWord(MPU6050_RA_ZA_OFFS_H, (int16_t)offset[2], 0x01);
+	stageWord(MPU6050_RA_XG_OFFS_USRH, (int16_t)offset[3], 0x00);
+	stageWord(MPU6050_RA_YG_OFFS_USRH, (int16_t)offset[4], 0x00);
+	stageWord(MPU6050_RA_ZG_OFFS_USRH, (int16_t)offset[5], 0x00);
+	return commit() < 0 ? -1 : 1;
+}
+
+/*
+* One batch per bank: for every chunk a BANK_SEL + MEM_START_ADDR write (the two registers are adjacent) followed by
+* the MEM_R_W data write, or by a MEM_R_W pointer write and the read. MEM_R_W is a data port like FIFO_R_W.
+*/
+int MPU6050_RaspbPi::accessDMPMemory(unsigned char* _data, unsigned int _size, unsigned short _address, bool _write)
+{
+	unsigned short chunkBytes = m_i2c.i2c_chunkSize();
+	unsigned short headerBytes = 3U;
+	unsigned short pointerBytes = 1U;
+	unsigned short messageBytes;
+	unsigned int done = 0, bankBytes, offset, used;
+	unsigned int segmentsPerChunk = _write ? 2U : 3U;
+	unsigned char* staging;
+
+	if (_address + _size > MPU6050_DMP_MEMORY_SIZE) return -1;
+	m_dmpStaging.resize((MPU6050_DMP_MEMORY_BANK_SIZE / chunkBytes + 1U) * (headerBytes + pointerBytes + chunkBytes));
+	staging = m_dmpStaging.data();
+	m_i2c.i2c_clearQueue();
+
+	while (done < _size)
+	{
+		unsigned int address = _address + done;
+		bankBytes = MPU6050_DMP_MEMORY_BANK_SIZE - (address & 0xFF);
+		if (bankBytes > _size - done) bankBytes = _size - done;
+
+		used = 0;
+		for (offset = 0; offset < bankBytes; offset += messageBytes)
+		{
+			messageBytes = (unsigned short)((bankBytes - offset) < chunkBytes ? (bankBytes - offset) : chunkBytes);
+			if (m_i2c.i2c_queuedSegments() + segmentsPerChunk > UNR_I2C_MAX_SEGMENTS)
+			{
+				if (m_i2c.i2c_submit() < 0) return -1;
+				used = 0;
+			}
+			staging[used] = MPU6050_RA_BANK_SEL;
+			staging[used + 1U] = (unsigned char)((address + offset) >> 8);
+			staging[used + 2U] = (unsigned char)((address + offset) & 0xFF);
+			m_i2c.i2c_queueWrite(staging[used], headerBytes);
+			used += headerBytes;
+			staging[used] = MPU6050_RA_MEM_R_W;
+			if (_write)
+			{
+				unsigned short dataBytes = (unsigned short)(messageBytes + 1U);
+				memcpy(&staging[used + 1U], &_data[done + offset], messageBytes);
+				m_i2c.i2c_queueWrite(staging[used], dataBytes);
+				used += dataBytes;
+			}
+			else
+			{
+				m_i2c.i2c_queueWrite(staging[used], pointerBytes);
+				m_i2c.i2c_queueRead(_data[done + offset], messageBytes);
+				used += pointerBytes;
+			}
+		}
+		if (m_i2c.i2c_submit() < 0) return -1;
+		done += bankBytes;
+	}
+	return 1;
+}
+
+int MPU6050_RaspbPi::writeDMPMemory(const unsigned char* _data, unsigned int _size, unsigned short _address)
+{
+	// only read from on a write
+	return accessDMPMemory(const_cast<unsigned char*>(_data), _size, _address, true);
+}
+
+int MPU6050_RaspbPi::readDMPMemory(unsigned char* _data, unsigned int _size, unsigned short _address)
+{
+	return accessDMPMemory(_data, _size, _address, false);
+}
+
+int MPU6050_RaspbPi::loadDMPFirmware(const unsigned char* _image, unsigned int _size, unsigned short _startAddress)
+{
+	std::vector<unsigned char> readBack(_size);
+	unsigned char startAddress[2];
+	unsigned char startRegister = MPU6050_RA_DMP_CFG_1;
+
+	if (_size == 0 || _size > MPU6050_DMP_MEMORY_SIZE || _startAddress >= MPU6050_DMP_MEMORY_SIZE) return -1;
+	if (writeDMPMemory(_image, _size, 0) < 0) return -1;
+	if (readDMPMemory(readBack.data(), _size, 0) < 0) return -1;
+	if (memcmp(readBack.data(), _image, _size) != 0) return MPU6050_DMP_VERIFY_FAILED;
+
+	startAddress[0] = (unsigned char)(_startAddress >> 8);
+	startAddress[1] = (unsigned char)(_startAddress & 0xFF);
+	return m_i2c.i2c_writeReg(startAddress[0], startRegister, 2U) < 0 ? -1 : 1;
+}
+
+int MPU6050_RaspbPi::enableDMP(unsigned short _packetBytes)
+{
+	if (_packetBytes == 0 || _packetBytes > MPU6050_FIFO_SIZE) return -1;
+	// the DMP writes the FIFO itself, raw sensor and slave routing would interleave with its packets
+	if (stageRegisterBits(MPU6050_RA_FIFO_EN, 0xFF, 0x00) < 0) return -1;
+	if (stageRegisterBits(MPU6050_RA_I2C_MST_CTRL, (1U << MPU6050_SLV_3_FIFO_EN_BIT), 0x00) < 0) return -1;
+	if (stageRegisterBits(MPU6050_RA_INT_ENABLE, (1U << MPU6050_INTERRUPT_DMP_INT_BIT) | (1U << MPU6050_INTERRUPT_FIFO_OFLOW_BIT), 0xFF) < 0) return -1;
+	if (stageRegisterBits(MPU6050_RA_USER_CTRL, (1U << MPU6050_USERCTRL_DMP_EN_BIT) | (1U << MPU6050_USERCTRL_FIFO_EN_BIT), 0xFF,
+							(1U << MPU6050_USERCTRL_DMP_RESET_BIT) | (1U << MPU6050_USERCTRL_FIFO_RESET_BIT)) < 0) return -1;
+	if (commit() < 0) return -1;
+	m_dmpPacketBytes = _packetBytes;
+	updateAuxLayout();
+	return 1;
+}
+
+int MPU6050_RaspbPi::disableDMP(void)
+{
+	if (stageRegisterBits(MPU6050_RA_INT_ENABLE, (1U << MPU6050_INTERRUPT_DMP_INT_BIT), 0x00) < 0) return -1;
+	if (stageRegisterBits(MPU6050_RA_USER_CTRL, (1U << MPU6050_USERCTRL_DMP_EN_BIT) | (1U << MPU6050_USERCTRL_FIFO_EN_BIT), 0x00,
+							(1U << MPU6050_USERCTRL_FIFO_RESET_BIT)) < 0) return -1;
+	if (commit() < 0) return -1;
+	m_dmpPacketBytes = 0;
+	updateAuxLayout();
+	return 1;
+}
+
+int MPU6050_RaspbPi::getDMPQuaternions(MPU6050_Quaternion* _quaternions, unsigned int _maxQuaternions)
+{
+	uint64_t timestamp;
+	int packets;
+
+	if (m_dmpPacketBytes == 0) return -1;
+	// checkFIFO() counts whole DMP packets, a packet still being written stays in the FIFO
+	packets = checkFIFO(_maxQuaternions);
+	if (packets <= 0) return packets;
+	timestamp = MPU6050_timestampNow();
+	if (m_i2c.i2c_readBulk(m_fifoBuffer, MPU6050_RA_FIFO_R_W, (unsigned int)packets * m_dmpPacketBytes, false) < 0) return -1;
+	for (int i = 0; i < packets; i++)
+	{
+		MPU6050_decodeQuaternion(&m_fifoBuffer[i * m_dmpPacketBytes], _quaternions[i]);
+		_quaternions[i].timestamp = timestamp;
+		_quaternions[i].sequence = m_sequence++;
+	}
+	return packets;
 }
 
 MPU6050_RaspbPi::~MPU6050_RaspbPi(void)
 {
-	delete m_sensorvalues;
 }
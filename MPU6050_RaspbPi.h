@@ -16,92 +16,220 @@
 *
 * Unauthorized Distrubution is strictly prohibited.
 * Rev 1: Added Startup code
+* Rev 2: FIFO burst acquisition mode
+* Rev 3: MPU6050_Sample replaces the heap allocated byte swap union, multiply only conversion
+* Rev 4: Data ready interrupt driven reads
+* Rev 5: Devices on a shared UNR_I2CBus
+* Rev 6: FIFO drained with chunked bulk reads
+* Rev 7: Owns its UNR_I2CHandle instead of deriving from it, runs on any UNR_I2CTransport
+* Rev 8: Shadow of the configuration registers, setters stage and commit() flushes in coalesced bursts
+* Rev 9: Output data rate, DLPF and standby axes, samples read only the enabled register window
+* Rev 10: Hardware offset calibration with a persisted calibration cache
+* Rev 11: Auxiliary I2C master slave reads, returned with the sample burst and in FIFO frames
+* Rev 12: DMP firmware upload with verification, quaternion packets from the FIFO
+* Rev 13: Fixed point sample conversion (Q15, Q16.16)
+* Rev 14: Device address accessor (capture file headers)
+* Rev 15: 12 bank DMP memory, DMP start address and packet size required per image
+* Rev 16: Partial FIFO frames are not treated as an overflow
+* Rev 17: Overridable sample time stamps
 */
 
 
 #pragma once
 #include "UNR_BCM2711_I2CHandle.h"
+#include "UNR_BCM2711_I2CBus.h"
+#include "UNR_Transport.h"
 #include "MPU6050_RegisterMap.h"
+#include "MPU6050_FixedPoint.h"
+#include <time.h>
+#include <vector>
 
 #define SINGLE_BYTE_TRANSACTION		1U
 #define MPU6050_DEVICE_ADDRESS		0x68
 #define SWAP_BYTES(X)	(((0x00FF & X)<<8) | ((0xFF00 & X) >> 8)) 
+#define MPU6050_TEMP_SCALE_INV		(1.0 / 340.00)
+#define MPU6050_TEMP_OFFSET			36.53
 
-class MPU6050_RaspbPi : public UNR_I2CHandle
+#define MPU6050_FIFO_SIZE			1024U	// Size of the on chip FIFO in bytes
+#define MPU6050_FIFO_FRAME_SIZE		14U		// ACCEL(6) + TEMP(2) + GYRO(6), same layout as the ACCEL_XOUT_H burst
+#define MPU6050_FIFO_READ_CHUNK		56U		// 4 frames decoded per pass by getFIFOSensorValues()
+#define MPU6050_FIFO_CHUNK_FRAMES	(MPU6050_FIFO_READ_CHUNK / MPU6050_FIFO_FRAME_SIZE)
+#define MPU6050_FIFO_OVERFLOW		-2		// returned when the FIFO overflowed (OFLOW flag or full) and was reset
+
+#define MPU6050_GYRO_RATE_DLPF_OFF	8000U	// gyro output rate with DLPF_CFG 0 or 7
+#define MPU6050_GYRO_RATE_DLPF_ON	1000U	// gyro output rate with the DLPF on, the accelerometer is 1 kHz in either case
+#define MPU6050_STANDBY_MASK		0x3F	// MPU6050_PWR2_STBY_XA_BIT .. MPU6050_PWR2_STBY_ZG_BIT
+
+#define MPU6050_ACCEL_OFFS_LSB_PER_G	2048.0	// XA/YA/ZA_OFFS count in +/-16g units, bit 0 is reserved
+#define MPU6050_GYRO_OFFS_LSB_PER_DPS	32.8	// XG/YG/ZG_OFFS_USR count in +/-1000 deg/s units
+#define MPU6050_CALIBRATION_LINE		128U	// longest line of a calibration cache file
+
+#define MPU6050_AUX_SLAVES			4U		// I2C_SLV0..3 read into EXT_SENS_DATA (SLV4 is the single byte slave)
+#define MPU6050_AUX_MAX_LENGTH		15U		// I2C_SLV_LEN is 4 bits
+#define MPU6050_EXT_SENS_BYTES		24U		// EXT_SENS_DATA_00..23
+
+#define MPU6050_DMP_MEMORY_SIZE		(MPU6050_DMP_MEMORY_BANKS * MPU6050_DMP_MEMORY_BANK_SIZE)
+// image size, program start (DMP_CFG_1 / DMP_CFG_2) and FIFO packet size belong together, the quaternion comes first in both packets
+#define MPU6050_DMP_MOTIONAPPS20_SIZE			1929U
+#define MPU6050_DMP_MOTIONAPPS20_START_ADDRESS	0x0300
+#define MPU6050_DMP_MOTIONAPPS20_PACKET_SIZE	42U
+#define MPU6050_DMP_MOTIONAPPS612_SIZE			3062U
+#define MPU6050_DMP_MOTIONAPPS612_START_ADDRESS	0x0400
+#define MPU6050_DMP_MOTIONAPPS612_PACKET_SIZE	28U
+#define MPU6050_DMP_VERIFY_FAILED	-3		// DMP memory read back differs from the image
+
+#define MPU6050_SHADOW_SIZE			0x80	// shadow indexed by register address
+#define MPU6050_SHADOW_CACHED		0x01	// shadow holds the device value
+#define MPU6050_SHADOW_DIRTY		0x02	// shadow differs from the device, written by the next commit()
+
+/*
+* Configuration registers the driver keeps a shadow of. The device only changes them on a write (or a reset), so
+* they never need to be read back. The offset registers, XG_OFFS_USRH..ACCEL_CONFIG and USER_CTRL..PWR_MGMT_2 are
+* contiguous and go out as one burst each.
+*/
+struct MPU6050_ShadowRange
 {
-private:
-	union MPU6050_SensorValues 
+	unsigned char first;
+	unsigned char count;
+};
+static constexpr MPU6050_ShadowRange MPU6050_SHADOW_RANGES[] =
+{
+	{ MPU6050_RA_XA_OFFS_H, 6U },		// XA_OFFS .. ZA_OFFS
+	{ MPU6050_RA_XG_OFFS_USRH, 10U },	// XG_OFFS_USR .. ZG_OFFS_USR, SMPLRT_DIV, CONFIG, GYRO_CONFIG, ACCEL_CONFIG
+	{ MPU6050_RA_FIFO_EN, 14U },			// FIFO_EN, I2C_MST_CTRL, I2C_SLV0..3 ADDR / REG / CTRL
+	{ MPU6050_RA_INT_PIN_CFG, 2U },		// INT_PIN_CFG, INT_ENABLE
+	{ MPU6050_RA_USER_CTRL, 3U },		// USER_CTRL, PWR_MGMT_1, PWR_MGMT_2
+};
+static constexpr unsigned int MPU6050_SHADOW_RANGE_COUNT = sizeof(MPU6050_SHADOW_RANGES) / sizeof(MPU6050_SHADOW_RANGES[0]);
+static constexpr unsigned int MPU6050_SHADOW_REGISTERS = 35U;
+
+// Channel order of a sample, identical to the register order starting at MPU6050_RA_ACCEL_XOUT_H
+enum MPU6050_Channel
+{
+	MPU6050_AX = 0,
+	MPU6050_AY,
+	MPU6050_AZ,
+	MPU6050_TEMP,
+	MPU6050_GX,
+	MPU6050_GY,
+	MPU6050_GZ,
+	MPU6050_CHANNELS
+};
+
+/*
+* One raw sample. The 14 byte burst from ACCEL_XOUT_H is read straight into raw[] and byte swapped in place,
+* timestamp is CLOCK_MONOTONIC in nanoseconds taken right after the read.
+* Deliberately 32 byte aligned rather than a full 64 byte cache line: at 32 bytes a sample never straddles a line
+* and two samples fill one line exactly, so rings, FIFO batches and capture files (recordBytes) carry no padding.
+* Per sample line ownership would double every buffer and the capture record size for no gain, samples are
+* written by one thread and read in bulk by another, not shared at a finer grain.
+*/
+struct alignas(32) MPU6050_Sample
+{
+	int16_t raw[MPU6050_CHANNELS];
+	uint16_t reserved;
+	uint64_t timestamp;
+	uint64_t sequence;
+};
+static_assert(sizeof(MPU6050_Sample) == 32, "MPU6050_Sample must stay 32 bytes");
+
+/*
+* Unit quaternion from a DMP FIFO packet, timestamp and sequence as in MPU6050_Sample
+*/
+struct MPU6050_Quaternion
+{
+	float w;
+	float x;
+	float y;
+	float z;
+	uint64_t timestamp;
+	uint64_t sequence;
+};
+
+/*
+* The DMP puts the quaternion at the start of its packets as four big endian Q30 words (w, x, y, z)
+*/
+static inline void MPU6050_decodeQuaternion(const unsigned char* _packet, MPU6050_Quaternion& _quaternion)
+{
+	float value[4];
+	for (unsigned int i = 0; i < 4; i++)
 	{
-		struct sensorValues 
-		{
-			union Accelx 
-			{
-				uint8_t u8_AXData[2];
-				uint16_t u16_AXData;
-			}Accelx_t;
-
-			union Accely
-			{
-				uint8_t u8_AYData[2];
-				uint16_t u16_AYData;
-			}Accely_t;
-
-			union Accelz
-			{
-				uint8_t u8_AZData[2];
-				uint16_t u16_AZData;
-			}Accelz_t;
-
-			union Temperature 
-			{
-				uint8_t u8_TData[2];
-				uint16_t u16_TData;
-			}Temperature_t;
-
-			union Gyrox
-			{
-				uint8_t u8_GXData[2];
-				uint16_t u16_GXData;
-			}Gyrox_t;
-
-			union Gyroy
-			{
-				uint8_t u8_GYData[2];
-				uint16_t u16_GYData;
-			}Gyroy_t;
-
-			union Gyroz
-			{
-				uint8_t u8_GZData[2];
-				uint16_t u16_GZData;
-			}Gyroz_t;
-		}sensorValues_t;
-
-		uint8_t byteData[14];
-		void swapAllBytes() 
-		{
-			sensorValues_t.Accelx_t.u16_AXData = SWAP_BYTES(sensorValues_t.Accelx_t.u16_AXData);
-			sensorValues_t.Accely_t.u16_AYData = SWAP_BYTES(sensorValues_t.Accely_t.u16_AYData);
-			sensorValues_t.Accelz_t.u16_AZData = SWAP_BYTES(sensorValues_t.Accelz_t.u16_AZData);
-			sensorValues_t.Temperature_t.u16_TData = SWAP_BYTES(sensorValues_t.Temperature_t.u16_TData);
-			sensorValues_t.Gyrox_t.u16_GXData = SWAP_BYTES(sensorValues_t.Gyrox_t.u16_GXData);
-			sensorValues_t.Gyroy_t.u16_GYData = SWAP_BYTES(sensorValues_t.Gyroy_t.u16_GYData);
-			sensorValues_t.Gyroz_t.u16_GZData = SWAP_BYTES(sensorValues_t.Gyroz_t.u16_GZData);
-		}
-	};
-
-
-	MPU6050_SensorValues* m_sensorvalues;
+		uint32_t word;
+		memcpy(&word, &_packet[4 * i], sizeof(word));
+		value[i] = (float)(int32_t)__builtin_bswap32(word) * (1.0f / 1073741824.0f);
+	}
+	_quaternion.w = value[0];
+	_quaternion.x = value[1];
+	_quaternion.y = value[2];
+	_quaternion.z = value[3];
+}
+
+/*
+* Big endian register words to host order. No branches, the loop compiles to rev16 / pshufb.
+*/
+static inline void MPU6050_decodeSample(MPU6050_Sample& _sample)
+{
+	for (unsigned int i = 0; i < MPU6050_CHANNELS; i++)
+		_sample.raw[i] = (int16_t)__builtin_bswap16((uint16_t)_sample.raw[i]);
+}
+
+// CLOCK_MONOTONIC in nanoseconds, served from the vDSO so it does not cost a syscall
+static inline uint64_t MPU6050_timestampNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+* The driver talks to the chip through m_i2c only, so the same code runs on /dev/i2c-1, a shared UNR_I2CBus or
+* a UNR_SimTransport with a device model attached.
+*/
+class MPU6050_RaspbPi
+{
+private:
+	UNR_I2CHandle m_i2c;
+	MPU6050_Sample m_sample;
 	unsigned char tempBuffer[2];
 	unsigned char accessRegisterID;
-	unsigned char accessSensorValuesRegister; 
+	unsigned char accessSensorValuesRegister; 	// first register of the sample window
+	unsigned char m_windowFirst;				// first MPU6050_Channel of the sample window
+	unsigned short m_windowBytes;				// bytes per sample read
+	unsigned short m_auxBytes;					// EXT_SENS_DATA bytes of the enabled slaves
+	unsigned short m_fifoAuxBytes;				// slave bytes appended to every FIFO frame
+	unsigned short m_fifoFrameBytes;			// MPU6050_FIFO_FRAME_SIZE + m_fifoAuxBytes
+	unsigned char m_burstBuffer[MPU6050_FIFO_FRAME_SIZE + MPU6050_EXT_SENS_BYTES];
+	unsigned short m_dmpPacketBytes;			// FIFO packet of the running DMP, 0 when the DMP is off
+	std::vector<unsigned char> m_dmpStaging;	// bank select headers and data of one DMP memory batch
+
+	void inline resetBuffer(void) { memset(tempBuffer, 0x00, 2U); }
+
+	unsigned char m_fifoBuffer[MPU6050_FIFO_SIZE];
+	unsigned int m_fifoOverflows;
+	uint64_t m_sequence;
 
-	signed int _f2sComplement(uint16_t& );
-	void inline resetBuffer(void) { memset(tempBuffer, NULL, 2U); }
+	unsigned char m_shadow[MPU6050_SHADOW_SIZE];
+	unsigned char m_shadowState[MPU6050_SHADOW_SIZE];		// MPU6050_SHADOW_CACHED | MPU6050_SHADOW_DIRTY
+	unsigned char m_shadowPulse[MPU6050_SHADOW_SIZE];		// self clearing bits (resets) sent with the next commit() only
+	unsigned char m_commitBuffer[2U * MPU6050_SHADOW_REGISTERS];	// register byte + data for every burst of one commit()
+
+	int stageRegisterBits(unsigned char _register, unsigned char _mask, unsigned char _value, unsigned char _pulse = 0x00);
+	void updateSampleWindow(void);
+	void updateAuxLayout(void);
+	void decodeWindow(MPU6050_Sample& _sample) const;
+	int accessDMPMemory(unsigned char* _data, unsigned int _size, unsigned short _address, bool _write);
+	int16_t shadowWord(unsigned char _register) const { return (int16_t)((m_shadow[_register] << 8) | m_shadow[_register + 1]); }
+	void stageWord(unsigned char _register, int16_t _value, unsigned char _keepMask);
+	int checkFIFO(unsigned int _maxSamples);
+	int readFIFOChunk(MPU6050_Sample* _batch, unsigned char* _aux, unsigned int _frames, uint64_t _timestamp);
 		
 
 	double gyroScale;
 	double accelScale;
+	double gyroScaleInv;		// 1 / gyroScale, the conversion only multiplies
+	double accelScaleInv;		// 1 / accelScale
+	unsigned char gyroRange;	// FS_SEL / AFS_SEL of gyroScale and accelScale, indexes the fixed point scale tables
+	unsigned char accelRange;
 
 	/** Get and Set clock source setting.
  * An internal 8MHz oscillator, gyroscope based clock, or external sources can
@@ -129,7 +257,7 @@ private:
  *
  */
 	int setClockSource(unsigned char);
-	int getClockSource(unsigned char);
+	int getClockSource(void) const;
 
 
 /** Get and set full-scale gyroscope range.
@@ -150,7 +278,7 @@ private:
 * @see MPU6050_GCONFIG_FS_SEL_LENGTH
 */
 	int setFullScaleGyroRange(unsigned char);
-	int getFullScaleGyroRange(unsigned char);
+	int getFullScaleGyroRange(void) const;
 
 /** Get and Set full-scale accelerometer range.
 * The FS_SEL parameter allows setting the full-scale range of the accelerometer
@@ -169,7 +297,7 @@ private:
 * @see MPU6050_ACONFIG_AFS_SEL_BIT
 * @see MPU6050_ACONFIG_AFS_SEL_LENGTH
 */
-	int getFullScaleAccelRange(unsigned char);
+	int getFullScaleAccelRange(void) const;
 	int setFullScaleAccelRange(unsigned char);
 
 /** Get and sleep sleep mode status.
@@ -183,18 +311,70 @@ private:
 * @see MPU6050_RA_PWR_MGMT_1
 * @see MPU6050_PWR1_SLEEP_BIT
 */
-	bool getSleepEnabled();
+	bool getSleepEnabled() const;
 	int setSleepEnabled(bool);
 
+protected:
+	/*
+	* Called with every batch of samples just read, _fifo when they came out of the FIFO in frame order.
+	* The samples carry the host time of the read, a device whose samples have their own time (a replayed
+	* capture) overrides this to put it in.
+	*/
+	virtual void stampSamples(MPU6050_Sample* _samples, unsigned int _count, bool _fifo) { (void)_samples; (void)_count; (void)_fifo; }
+
 public:
-    MPU6050_RaspbPi(unsigned char _devAddress) : UNR_I2CHandle(RPI4_I2C_INSTANCE1, _devAddress, I2C_SLAVE)
+    MPU6050_RaspbPi(unsigned char _devAddress) : m_i2c(RPI4_I2C_INSTANCE1, _devAddress, I2C_SLAVE)
+												, m_sample()
+												, tempBuffer{0x00 , 0x00}
 												, accessRegisterID(0x00) 
-												, tempBuffer({0x00 , 0x00})
 												, accessSensorValuesRegister(MPU6050_RA_ACCEL_XOUT_H)
+												, m_windowFirst(MPU6050_AX)
+												, m_windowBytes(MPU6050_FIFO_FRAME_SIZE)
+												, m_auxBytes(0)
+												, m_fifoAuxBytes(0)
+												, m_fifoFrameBytes(MPU6050_FIFO_FRAME_SIZE)
+												, m_dmpPacketBytes(0)
+												, m_fifoOverflows(0)
+												, m_sequence(0)
+												, m_shadow{}
+												, m_shadowState{}
+												, m_shadowPulse{}
 												, gyroScale(MPU6050_GYRO_FS_250_SCALE)
 												, accelScale(MPU6050_ACCEL_FS_2_SCALE)
+												, gyroScaleInv(1.0 / MPU6050_GYRO_FS_250_SCALE)
+												, accelScaleInv(1.0 / MPU6050_ACCEL_FS_2_SCALE)
+												, gyroRange(MPU6050_GYRO_FS_250)
+												, accelRange(MPU6050_ACCEL_FS_2)
+	{
+	}
+
+	/*
+	* Device on a transport: a shared UNR_I2CBus, e.g. two sensors at MPU6050_ADDRESS_AD0_LOW / MPU6050_ADDRESS_AD0_HIGH
+	* on one adapter, or a UNR_SimTransport. The transport must outlive the driver.
+	*/
+	MPU6050_RaspbPi(UNR_I2CTransport& _transport, unsigned char _devAddress) : m_i2c(_transport, _devAddress)
+												, m_sample()
+												, tempBuffer{0x00 , 0x00}
+												, accessRegisterID(0x00) 
+												, accessSensorValuesRegister(MPU6050_RA_ACCEL_XOUT_H)
+												, m_windowFirst(MPU6050_AX)
+												, m_windowBytes(MPU6050_FIFO_FRAME_SIZE)
+												, m_auxBytes(0)
+												, m_fifoAuxBytes(0)
+												, m_fifoFrameBytes(MPU6050_FIFO_FRAME_SIZE)
+												, m_dmpPacketBytes(0)
+												, m_fifoOverflows(0)
+												, m_sequence(0)
+												, m_shadow{}
+												, m_shadowState{}
+												, m_shadowPulse{}
+												, gyroScale(MPU6050_GYRO_FS_250_SCALE)
+												, accelScale(MPU6050_ACCEL_FS_2_SCALE)
+												, gyroScaleInv(1.0 / MPU6050_GYRO_FS_250_SCALE)
+												, accelScaleInv(1.0 / MPU6050_ACCEL_FS_2_SCALE)
+												, gyroRange(MPU6050_GYRO_FS_250)
+												, accelRange(MPU6050_ACCEL_FS_2)
 	{
-		m_sensorvalues = new MPU6050_SensorValues;
 	}
 
 	MPU6050_RaspbPi() = delete;
@@ -205,7 +385,7 @@ public:
 /*
 * Destructor function
 */
-    ~MPU6050_RaspbPi(void);
+    virtual ~MPU6050_RaspbPi(void);
 
 	/** Power on and prepare for general usage.
  * This will activate the device and take it out of sleep mode (which must be done
@@ -216,6 +396,19 @@ public:
  */
     int initialize(void);
 
+	/** Register shadow.
+	 * refreshShadow() reads every MPU6050_SHADOW_RANGES register (and WHO_AM_I into _whoAmI) in one I2C_RDWR call,
+	 * initialize() does this first. From then on the setters only change the shadow and commit() writes all dirty
+	 * registers in one I2C_RDWR call, one burst per run of adjacent registers. Clean registers between two dirty ones
+	 * are rewritten with their shadow value when that keeps the run in one burst.
+	 * Call refreshShadow() again after anything else wrote the device (another process, a device reset).
+	 * @return refreshShadow: 1 or -1; commit: number of bursts written (0 when nothing was dirty) or -1, the
+	 *         registers stay dirty after a failed commit
+	 */
+	int refreshShadow(unsigned char& _whoAmI);
+	int commit(void);
+	bool shadowDirty(void) const;
+
 	/** Get raw 6-axis motion sensor readings (accel/gyro) and Temperature values.
 	 * Retrieves all currently available motion sensor values.
 	 * @param ax 16-bit signed integer container for accelerometer X-axis value
@@ -234,5 +427,169 @@ public:
 	int getDoubleSensorValues(double*, double*, double*);
 	//int getRAWSensorValues(uint16_t*);
 
+	/** Read one sample straight into the caller's MPU6050_Sample. No copies and no allocation,
+	 * the burst lands in _sample.raw and is byte swapped in place, then timestamp and sequence are set.
+	 */
+	int getSample(MPU6050_Sample& _sample);
+	const MPU6050_Sample& getLastSample(void) const { return m_sample; }
+
+	/** Data ready interrupt.
+	 * enableDataReadyInterrupt() drives the INT pin active high, push-pull, as a 50us pulse per new sample
+	 * (MPU6050_RA_INT_PIN_CFG) and enables MPU6050_INTERRUPT_DATA_RDY_BIT in MPU6050_RA_INT_ENABLE.
+	 * waitForSample() blocks on the GPIO edge event fd the INT pin is wired to (see gpio_request_edge) and reads
+	 * exactly one sample per edge. The timestamp is the kernel timestamp of the edge.
+	 * @return 1 for a sample, 0 on timeout, -1 on a GPIO or bus error
+	 */
+	int enableDataReadyInterrupt(void);
+	int waitForSample(int _eventFd, MPU6050_Sample& _sample, int _timeoutMs);
+
+	/** Scale a raw sample to g, deg/s and deg C with the current full scale settings (multiply only).
+	 */
+	void toDouble(const MPU6050_Sample& _sample, double* accel, double* gyro, double* temperature) const
+	{
+		accel[0] = (double)_sample.raw[MPU6050_AX] * accelScaleInv;
+		accel[1] = (double)_sample.raw[MPU6050_AY] * accelScaleInv;
+		accel[2] = (double)_sample.raw[MPU6050_AZ] * accelScaleInv;
+		temperature[0] = (double)_sample.raw[MPU6050_TEMP] * MPU6050_TEMP_SCALE_INV + MPU6050_TEMP_OFFSET;
+		gyro[0] = (double)_sample.raw[MPU6050_GX] * gyroScaleInv;
+		gyro[1] = (double)_sample.raw[MPU6050_GY] * gyroScaleInv;
+		gyro[2] = (double)_sample.raw[MPU6050_GZ] * gyroScaleInv;
+	}
+
+	/** Scale a raw sample to a fixed point format with the current full scale settings, integer only.
+	 * MPU6050_Q16_16 gives g, deg/s and deg C, MPU6050_Q15 the fraction of the full scale range
+	 * (see MPU6050_FixedPoint.h). getFixedSensorValues() is getDoubleSensorValues() for those formats.
+	 */
+	template <typename _Format>
+	void toFixed(const MPU6050_Sample& _sample, typename _Format::value_type* accel, typename _Format::value_type* gyro,
+				typename _Format::value_type* temperature) const
+	{
+		typedef MPU6050_FixedScale<_Format> Scale;
+		const int64_t accelMultiplier = Scale::ACCEL[accelRange];
+		const int64_t gyroMultiplier = Scale::GYRO[gyroRange];
+		accel[0] = MPU6050_toFixed<_Format, Scale::ACCEL_SATURATES>(_sample.raw[MPU6050_AX], accelMultiplier);
+		accel[1] = MPU6050_toFixed<_Format, Scale::ACCEL_SATURATES>(_sample.raw[MPU6050_AY], accelMultiplier);
+		accel[2] = MPU6050_toFixed<_Format, Scale::ACCEL_SATURATES>(_sample.raw[MPU6050_AZ], accelMultiplier);
+		temperature[0] = MPU6050_toFixed<_Format, Scale::TEMP_SATURATES>(_sample.raw[MPU6050_TEMP], Scale::TEMP, Scale::TEMP_OFFSET);
+		gyro[0] = MPU6050_toFixed<_Format, Scale::GYRO_SATURATES>(_sample.raw[MPU6050_GX], gyroMultiplier);
+		gyro[1] = MPU6050_toFixed<_Format, Scale::GYRO_SATURATES>(_sample.raw[MPU6050_GY], gyroMultiplier);
+		gyro[2] = MPU6050_toFixed<_Format, Scale::GYRO_SATURATES>(_sample.raw[MPU6050_GZ], gyroMultiplier);
+	}
+
+	template <typename _Format>
+	int getFixedSensorValues(typename _Format::value_type* accel, typename _Format::value_type* gyro,
+							typename _Format::value_type* temperature)
+	{
+		if (getSample(m_sample) < 0) return -1;
+		toFixed<_Format>(m_sample, accel, gyro, temperature);
+		return 1;
+	}
+
+	unsigned char getDeviceAddress(void) const { return m_i2c.i2c_address(); }
+	double getAccelScale(void) const { return accelScale; }
+	double getGyroScale(void) const { return gyroScale; }
+
+	/** Output data rate, DLPF and standby axes. All of these are staged in the register shadow, commit() applies them.
+	 * setDLPFMode() takes MPU6050_DLPF_BW_256 .. MPU6050_DLPF_BW_5. BW_256 (DLPF off) runs the gyro at 8 kHz, every
+	 * other setting at 1 kHz, so set the DLPF before the rate.
+	 * setOutputRate() picks SMPLRT_DIV for the closest rate not above _rateHz (gyro rate / 256 at the lowest) and
+	 * returns that rate, or -1. The accelerometer never updates faster than 1 kHz, above that its values repeat.
+	 * setStandby() takes MPU6050_PWR2_STBY_* bits, setTemperatureEnabled() the TEMP_DIS bit. Both also narrow the
+	 * register window getSample() reads to the span from the first to the last enabled channel, e.g. 6 bytes instead
+	 * of 14 for gyro only. Channels outside the window read as 0.
+	 */
+	int setDLPFMode(unsigned char _bandwidth);
+	int setOutputRate(unsigned int _rateHz);
+	unsigned int getOutputRate(void) const;
+	int setStandby(unsigned char _standbyBits);
+	int setTemperatureEnabled(bool _enable);
+	unsigned int getSampleBytes(void) const { return m_windowBytes; }
+
+	/** Offset calibration. The device must be at rest and level, Z axis up.
+	 * calibrate() averages _samples samples at the current output rate, turns the accel (less 1 g on Z) and gyro
+	 * means into offset register counts and writes them to XA/YA/ZA_OFFS (keeping the reserved bit 0) and
+	 * XG/YG/ZG_OFFS_USR, so the chip returns corrected data and the host never subtracts a bias.
+	 * Needs initialize() first and every axis out of standby. Takes _samples / output rate seconds.
+	 * saveCalibration() keeps the offset registers in a text cache, one line "<bus key> <address> ax ay az gx gy gz"
+	 * per device, so several sensors share one file. _busKey names the adapter ("i2c-1"), no white space.
+	 * loadCalibration() restores a saved line with one commit(): both offset blocks in one I2C_RDWR call.
+	 * @return calibrate, saveCalibration: 1 or -1; loadCalibration: 1 applied, 0 nothing cached for this device, -1 error
+	 */
+	int calibrate(unsigned int _samples);
+	int saveCalibration(const char* _path, const char* _busKey) const;
+	int loadCalibration(const char* _path, const char* _busKey);
+
+	/** Auxiliary I2C master. Sensors on the MPU6050 AUX_DA / AUX_CL pins (magnetometer, barometer) are read by the
+	 * MPU itself once per sample into EXT_SENS_DATA, which directly follows GYRO_ZOUT_L, so the host gets them in
+	 * the same burst as the motion data.
+	 * enableAuxMaster() turns the master on at _clock (MPU6050_CLOCK_DIV_*, 400 kHz by default), holds DATA_RDY until
+	 * the external data is in (WAIT_FOR_ES) and turns the bypass mux off. setAuxRead() configures slave 0..3 to read
+	 * _length bytes from _register of the 7 bit _address. Slave data is laid out in slave order and must fit the
+	 * 24 EXT_SENS_DATA bytes. With _toFIFO the bytes are also appended to every FIFO frame.
+	 * All of these are staged, commit() applies them.
+	 * getSampleAux() reads the sample window and the EXT_SENS_DATA bytes in one transaction, _aux receives
+	 * getAuxBytes() bytes.
+	 * @return -1 for a bad slave, length or when the EXT_SENS_DATA bytes would overflow; getSampleAux: 1 or -1
+	 */
+	int enableAuxMaster(unsigned char _clock = MPU6050_CLOCK_DIV_400);
+	int disableAuxMaster(void);
+	int setAuxRead(unsigned int _slave, unsigned char _address, unsigned char _register, unsigned char _length, bool _toFIFO = false);
+	int disableAuxRead(unsigned int _slave);
+	int getSampleAux(MPU6050_Sample& _sample, unsigned char* _aux);
+	unsigned int getAuxBytes(void) const { return m_auxBytes; }
+
+	/** FIFO streaming mode.
+	 * enableFIFO() routes ACCEL, TEMP and GYRO into the on chip FIFO (MPU6050_RA_FIFO_EN), enables the FIFO overflow
+	 * interrupt status and turns the FIFO on through MPU6050_RA_USER_CTRL. The FIFO is reset in the same write so the
+	 * first frame read back is always aligned. Every frame is 14 bytes with the same layout as the ACCEL_XOUT_H burst,
+	 * followed by getFIFOAuxBytes() bytes of the slaves routed with setAuxRead(..., true).
+	 * @see MPU6050_RA_FIFO_EN
+	 * @see MPU6050_RA_USER_CTRL
+	 */
+	int enableFIFO(void);
+	int disableFIFO(void);
+	int resetFIFO(void);
+
+	/** Get the number of bytes currently held in the FIFO (MPU6050_RA_FIFO_COUNTH / MPU6050_RA_FIFO_COUNTL).
+	 */
+	int getFIFOCount(unsigned short&);
+
+	/** Drain the FIFO into a caller provided batch.
+	 * Reads as many complete frames as are available (up to _maxSamples) from MPU6050_RA_FIFO_R_W in
+	 * MPU6050_FIFO_READ_CHUNK sized passes and decodes them the same way getDoubleSensorValues() does.
+	 * accel and gyro must hold 3 * _maxSamples values (x, y, z per sample), temperature _maxSamples values.
+	 * @return number of samples decoded, -1 on a bus error, or MPU6050_FIFO_OVERFLOW when the FIFO overflowed
+	 *         (MPU6050_INTERRUPT_FIFO_OFLOW_BIT or full). In that case the FIFO has already been reset and the next
+	 *         call resumes with fresh, aligned frames. A frame the chip is still writing is left for the next call.
+	 */
+	int getFIFOSensorValues(double* accel, double* gyro, double* temperature, unsigned int _maxSamples);
+
+	/** Same as getFIFOSensorValues() but fills raw samples. Every frame of one drain gets the drain timestamp.
+	 * When _aux is given it receives getFIFOAuxBytes() slave bytes per frame.
+	 */
+	int getFIFOSamples(MPU6050_Sample* _batch, unsigned int _maxSamples, unsigned char* _aux = nullptr);
+	unsigned int getFIFOAuxBytes(void) const { return m_fifoAuxBytes; }
+	unsigned int getFIFOOverflowCount(void) const { return m_fifoOverflows; }
+
+	/** Digital Motion Processor.
+	 * writeDMPMemory() / readDMPMemory() move data to and from the 12 x 256 byte DMP memory. Every bank is one
+	 * I2C_RDWR call: BANK_SEL + MEM_START_ADDR and a MEM_R_W burst for each i2c_chunkSize() piece.
+	 * loadDMPFirmware() uploads a caller supplied image (e.g. the MotionApps dmpMemory[] array) at address 0, reads it
+	 * back for comparison and sets the program start address in DMP_CFG_1 / DMP_CFG_2.
+	 * enableDMP() hands the FIFO to the DMP (sensor routing off, DMP_EN, FIFO and DMP reset) with _packetBytes per
+	 * packet. Start address and packet size depend on the image and have no default: MotionApps 2.0 is
+	 * MPU6050_DMP_MOTIONAPPS20_START_ADDRESS / _PACKET_SIZE, 6.12 is MPU6050_DMP_MOTIONAPPS612_START_ADDRESS / _PACKET_SIZE.
+	 * The output rate is the one programmed into the image.
+	 * getDMPQuaternions() drains whole packets like getFIFOSamples() and decodes the quaternion of each.
+	 * @return 1 or -1, MPU6050_DMP_VERIFY_FAILED when the read back differs; getDMPQuaternions: number of
+	 *         quaternions, -1 or MPU6050_FIFO_OVERFLOW
+	 */
+	int writeDMPMemory(const unsigned char* _data, unsigned int _size, unsigned short _address = 0);
+	int readDMPMemory(unsigned char* _data, unsigned int _size, unsigned short _address = 0);
+	int loadDMPFirmware(const unsigned char* _image, unsigned int _size, unsigned short _startAddress);
+	int enableDMP(unsigned short _packetBytes);
+	int disableDMP(void);
+	int getDMPQuaternions(MPU6050_Quaternion* _quaternions, unsigned int _maxQuaternions);
+
 };
 
@@ -0,0 +1,243 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: MPU6050 that plays back a capture file through the unmodified MPU6050_RaspbPi driver
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Capture timed replay at real time, N times real time or as fast as the driver reads
+* Rev 2: Replayed samples carry their recorded timestamps
+*/
+
+
+#include "MPU6050_Replay.h"
+#include <cmath>
+
+static const double kGyroLsb[4] = { MPU6050_GYRO_FS_250_SCALE, MPU6050_GYRO_FS_500_SCALE, MPU6050_GYRO_FS_1000_SCALE, MPU6050_GYRO_FS_2000_SCALE };
+static const double kAccelLsb[4] = { MPU6050_ACCEL_FS_2_SCALE, MPU6050_ACCEL_FS_4_SCALE, MPU6050_ACCEL_FS_8_SCALE, MPU6050_ACCEL_FS_16_SCALE };
+
+static inline signed short rescale(int16_t _raw, double _from, double _to)
+{
+	double value;
+	if (_from <= 0.0 || _from == _to) return _raw;
+	value = nearbyint((double)_raw * _to / _from);
+	if (value > 32767.0) return 32767;
+	if (value < -32768.0) return -32768;
+	return (signed short)value;
+}
+
+MPU6050_ReplayModel::MPU6050_ReplayModel(const char* _path, double _speed, bool _loop) noexcept(false) : m_reader(_path)
+																										, m_speed(_speed)
+																										, m_loop(_loop)
+																										, m_cursor(0)
+																										, m_replayed(0)
+																										, m_passOffset_ns(0)
+																										, m_start_ns(0)
+																										, m_startCapture_ns(0)
+																										, m_captureTimestamp(0)
+																										, m_fifoFrameBytes(0)
+																										, m_consumed(true)
+{
+}
+
+/*
+* Length of one pass of a looped replay: the recorded span plus one average sample period
+*/
+uint64_t MPU6050_ReplayModel::passLength(void) const
+{
+	uint64_t records = m_reader.getRecords();
+	uint64_t span = m_reader.record(records - 1U).timestamp - m_reader.record(0).timestamp;
+	if (records > 1U) return span + span / (records - 1U);
+	return m_reader.config().outputRateHz ? 1000000000ULL / m_reader.config().outputRateHz : 1000000ULL;
+}
+
+/*
+* Capture time (from the first record, over all passes) of the next sample, UINT64_MAX when there is none
+*/
+uint64_t MPU6050_ReplayModel::nextCaptureTime(void) const
+{
+	uint64_t records = m_reader.getRecords();
+	if (m_cursor < records) return m_reader.record(m_cursor).timestamp - m_reader.record(0).timestamp + m_passOffset_ns;
+	if (m_loop && records > 0) return m_passOffset_ns + passLength();
+	return UINT64_MAX;
+}
+
+bool MPU6050_ReplayModel::generate(signed short* _value)
+{
+	uint64_t records = m_reader.getRecords();
+	unsigned char accelRange, gyroRange;
+
+	if (m_cursor >= records)
+	{
+		if (!m_loop || records == 0) return false;
+		m_passOffset_ns += passLength();
+		m_cursor = 0;
+	}
+
+	const MPU6050_Sample& sample = m_reader.record(m_cursor++);
+	accelRange = (registerValue(MPU6050_RA_ACCEL_CONFIG) >> (MPU6050_ACONFIG_AFS_SEL_BIT - 1)) & 0x03;
+	gyroRange = (registerValue(MPU6050_RA_GYRO_CONFIG) >> (MPU6050_GCONFIG_FS_SEL_BIT - 1)) & 0x03;
+	_value[0] = rescale(sample.raw[MPU6050_AX], m_reader.config().accelScale, kAccelLsb[accelRange]);
+	_value[1] = rescale(sample.raw[MPU6050_AY], m_reader.config().accelScale, kAccelLsb[accelRange]);
+	_value[2] = rescale(sample.raw[MPU6050_AZ], m_reader.config().accelScale, kAccelLsb[accelRange]);
+	_value[3] = sample.raw[MPU6050_TEMP];
+	_value[4] = rescale(sample.raw[MPU6050_GX], m_reader.config().gyroScale, kGyroLsb[gyroRange]);
+	_value[5] = rescale(sample.raw[MPU6050_GY], m_reader.config().gyroScale, kGyroLsb[gyroRange]);
+	_value[6] = rescale(sample.raw[MPU6050_GZ], m_reader.config().gyroScale, kGyroLsb[gyroRange]);
+	m_captureTimestamp = sample.timestamp;
+	m_replayed++;
+
+	// the frame of this sample (if the FIFO takes one) starts at the next byte pushed. A sample that pushed
+	// nothing leaves its entry at the same position and is replaced.
+	while (m_fifoStamps.size() > 1U && m_fifoStamps[1].first <= getFIFORemoved()) m_fifoStamps.pop_front();
+	if (!m_fifoStamps.empty() && m_fifoStamps.back().first == getFIFOWritten())
+		m_fifoStamps.back().second = sample.timestamp;
+	else
+		m_fifoStamps.emplace_back(getFIFOWritten(), sample.timestamp);
+	return true;
+}
+
+unsigned char MPU6050_ReplayModel::readRegister(unsigned char _register)
+{
+	uint64_t position;
+
+	if (_register >= MPU6050_RA_ACCEL_XOUT_H && _register <= MPU6050_RA_GYRO_ZOUT_L) m_consumed = true;
+	if (_register == MPU6050_RA_FIFO_R_W && getFIFOCount() > 0)
+	{
+		// the first byte of a frame records the frame's timestamp
+		position = getFIFORemoved();
+		while (m_fifoStamps.size() > 1U && m_fifoStamps[1].first <= position) m_fifoStamps.pop_front();
+		if (!m_fifoStamps.empty() && m_fifoStamps.front().first == position)
+		{
+			if (m_readStamps.size() == MPU6050_FIFO_SIZE) m_readStamps.pop_front();
+			m_readStamps.push_back(m_fifoStamps.front().second);
+		}
+	}
+	return MPU6050_Model::readRegister(_register);
+}
+
+unsigned int MPU6050_ReplayModel::takeFIFOTimestamps(uint64_t* _timestamps, unsigned int _count)
+{
+	unsigned int known = (unsigned int)(m_readStamps.size() < _count ? m_readStamps.size() : _count);
+
+	for (unsigned int i = 0; i < known; i++)
+		_timestamps[_count - known + i] = m_readStamps[m_readStamps.size() - known + i];
+	m_readStamps.clear();
+	return known;
+}
+
+/*
+* As many whole frames as the FIFO has room for. The frame size is learnt from the first sample pushed.
+*/
+void MPU6050_ReplayModel::topUpFIFO(void)
+{
+	unsigned int before;
+	uint64_t replayed;
+
+	while (!finished())
+	{
+		before = getFIFOCount();
+		if (m_fifoFrameBytes != 0 && before + m_fifoFrameBytes > MPU6050_FIFO_SIZE) return;
+		replayed = m_replayed;
+		step(1);
+		if (m_replayed == replayed) return;
+		m_fifoFrameBytes = getFIFOCount() - before;
+		if (m_fifoFrameBytes == 0) return;
+	}
+}
+
+void MPU6050_ReplayModel::advance(uint64_t _now_ns)
+{
+	uint64_t elapsed, replayed;
+	unsigned char userControl;
+
+	// a sleeping device produces nothing, the clock starts (again) at the next sample once it is awake
+	if (registerValue(MPU6050_RA_PWR_MGMT_1) & (1U << MPU6050_PWR1_SLEEP_BIT))
+	{
+		m_start_ns = 0;
+		return;
+	}
+
+	if (m_speed <= 0.0)
+	{
+		userControl = registerValue(MPU6050_RA_USER_CTRL);
+		if ((userControl & (1U << MPU6050_USERCTRL_FIFO_EN_BIT))
+			&& (registerValue(MPU6050_RA_FIFO_EN) != 0 || (userControl & (1U << MPU6050_USERCTRL_DMP_EN_BIT))))
+		{
+			// a sample generated for the data registers but never read goes to the FIFO first
+			if (!m_consumed)
+			{
+				m_cursor--;
+				m_replayed--;
+				m_consumed = true;
+			}
+			topUpFIFO();
+			return;
+		}
+		m_fifoFrameBytes = 0;
+		if (m_consumed && !finished())
+		{
+			step(1);
+			m_consumed = false;
+		}
+		return;
+	}
+
+	if (m_start_ns == 0)
+	{
+		m_start_ns = _now_ns;
+		m_startCapture_ns = nextCaptureTime();
+		if (m_startCapture_ns == UINT64_MAX) return;
+	}
+	elapsed = m_startCapture_ns + (uint64_t)((double)(_now_ns - m_start_ns) * m_speed);
+	while (nextCaptureTime() <= elapsed)
+	{
+		replayed = m_replayed;
+		step(1);
+		if (m_replayed == replayed) break;
+	}
+}
+
+void MPU6050_ReplayModel::setSpeed(double _speed)
+{
+	m_speed = _speed;
+	m_start_ns = 0;
+}
+
+void MPU6050_ReplayModel::rewind(void)
+{
+	m_cursor = 0;
+	m_passOffset_ns = 0;
+	m_start_ns = 0;
+	m_fifoFrameBytes = 0;
+	m_consumed = true;
+}
+
+/*
+* The FIFO frames of one read are the last ones to come out of FIFO_R_W, a frame whose sample is not known
+* (written before the replay started) keeps the host time.
+*/
+void MPU6050_Replay::stampSamples(MPU6050_Sample* _samples, unsigned int _count, bool _fifo)
+{
+	uint64_t timestamps[MPU6050_FIFO_SIZE];
+	unsigned int known;
+
+	if (!_fifo)
+	{
+		if (m_model.getReplayed() > 0) _samples[0].timestamp = m_model.getCaptureTimestamp();
+		return;
+	}
+	if (_count > MPU6050_FIFO_SIZE) _count = MPU6050_FIFO_SIZE;
+	known = m_model.takeFIFOTimestamps(timestamps, _count);
+	for (unsigned int i = _count - known; i < _count; i++) _samples[i].timestamp = timestamps[i];
+}
@@ -0,0 +1,139 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: MPU6050 that plays back a capture file through the unmodified MPU6050_RaspbPi driver
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Capture timed replay at real time, N times real time or as fast as the driver reads
+* Rev 2: Replayed samples carry their recorded timestamps
+*/
+
+
+#pragma once
+#include "MPU6050_Simulated.h"
+#include "MPU6050_Capture.h"
+#include <deque>
+#include <utility>
+
+#define MPU6050_REPLAY_REAL_TIME	1.0
+#define MPU6050_REPLAY_MAX_SPEED	0.0
+
+/*
+* Register model whose data registers come from a capture file instead of the synthetic motion.
+*
+* Timed replay (_speed > 0): the recorded sample k becomes visible when (timestamp k - timestamp 0) / _speed has
+* passed since the first transaction with the device awake. The driver sees the recorded sample spacing and
+* jitter, and a reader that falls behind overflows the FIFO like on the real bus. As on the real part, samples
+* produced before the FIFO is enabled do not end up in it.
+* Max speed (MPU6050_REPLAY_MAX_SPEED): every read of the data registers is answered with the next sample, and
+* an enabled FIFO is topped up to as many whole frames as fit before every transaction. No sample is skipped or
+* repeated, so a run over the same file is deterministic whatever the reader's timing.
+*
+* Samples are replayed with the full scale ranges the driver has programmed; when they differ from the ranges of
+* the recording the raw values are rescaled (and saturated) so the driver's conversions still give the recorded
+* g and deg/s. With matching ranges the raw values are passed on unchanged.
+*
+* Every sample keeps its recorded timestamp: getCaptureTimestamp() is the one in the data registers and
+* takeFIFOTimestamps() gives the ones of the frames just read from FIFO_R_W.
+*/
+class MPU6050_ReplayModel : public MPU6050_Model
+{
+private:
+	MPU6050_CaptureReader m_reader;
+	double m_speed;
+	bool m_loop;
+	uint64_t m_cursor;				// next record
+	uint64_t m_replayed;			// records replayed, all passes
+	uint64_t m_passOffset_ns;		// capture time added by the passes of a looped replay
+	uint64_t m_start_ns;			// CLOCK_MONOTONIC when the clock (re)started, 0 while stopped
+	uint64_t m_startCapture_ns;		// capture time reached at m_start_ns
+	uint64_t m_captureTimestamp;	// timestamp of the sample in the data registers
+	unsigned int m_fifoFrameBytes;	// FIFO growth of the last sample, 0 when not known yet
+	bool m_consumed;				// data registers read since the last sample
+	std::deque<std::pair<uint64_t, uint64_t>> m_fifoStamps;	// FIFO byte position of a sample's frame, its timestamp
+	std::deque<uint64_t> m_readStamps;		// timestamps of the frames read from FIFO_R_W, oldest first
+
+	uint64_t passLength(void) const;
+	uint64_t nextCaptureTime(void) const;
+	void topUpFIFO(void);
+
+protected:
+	bool generate(signed short* _value) override;
+
+public:
+	/*
+	* Throws std::runtime_error when _path is not a capture file (see MPU6050_CaptureReader)
+	*/
+	MPU6050_ReplayModel(const char* _path, double _speed = MPU6050_REPLAY_REAL_TIME, bool _loop = false) noexcept(false);
+
+	unsigned char readRegister(unsigned char _register) override;
+	void advance(uint64_t _now_ns) override;
+
+	/*
+	* Speed factor, MPU6050_REPLAY_MAX_SPEED for max speed. Changing it restarts the clock at the current record.
+	*/
+	void setSpeed(double _speed);
+	void setLoop(bool _loop) { m_loop = _loop; }
+	void rewind(void);
+
+	bool finished(void) const { return !m_loop && m_cursor >= m_reader.getRecords(); }
+	uint64_t getReplayed(void) const { return m_replayed; }
+	uint64_t getCaptureTimestamp(void) const { return m_captureTimestamp; }
+	/*
+	* Recorded timestamps of the last _count frames read from the FIFO, in read order. Returns how many were
+	* known (at the end of _timestamps) and forgets all frames read so far.
+	*/
+	unsigned int takeFIFOTimestamps(uint64_t* _timestamps, unsigned int _count);
+	const MPU6050_CaptureReader& reader(void) const { return m_reader; }
+};
+
+/*
+* Transport and replay model, constructed before the driver borrows the transport (see MPU6050_SimulatedBus)
+*/
+struct MPU6050_ReplayBus
+{
+	UNR_SimTransport m_transport;
+	MPU6050_ReplayModel m_model;
+	MPU6050_ReplayBus(const char* _path, double _speed, bool _loop, unsigned char _devAddress) noexcept(false) : m_model(_path, _speed, _loop)
+	{
+		m_transport.attach(_devAddress, &m_model);
+	}
+};
+
+/*
+* Drop in replacement for a physical sensor: the whole MPU6050_RaspbPi interface (getSensorValues(),
+* getDoubleSensorValues(), getSample(), the FIFO and batch reads) runs against the recording.
+* Every MPU6050_Sample read carries the timestamp it was recorded with instead of the host time of the read.
+*/
+class MPU6050_Replay : private MPU6050_ReplayBus, public MPU6050_RaspbPi
+{
+public:
+	MPU6050_Replay(const char* _path, double _speed = MPU6050_REPLAY_REAL_TIME, bool _loop = false,
+					unsigned char _devAddress = MPU6050_DEVICE_ADDRESS) noexcept(false)
+		: MPU6050_ReplayBus(_path, _speed, _loop, _devAddress)
+		, MPU6050_RaspbPi(m_transport, _devAddress)
+	{
+	}
+	~MPU6050_Replay(void) {}
+
+	bool finished(void) const { return m_model.finished(); }
+	uint64_t getReplayed(void) const { return m_model.getReplayed(); }
+	uint64_t getCaptureTimestamp(void) const { return m_model.getCaptureTimestamp(); }
+
+	MPU6050_ReplayModel& model(void) { return m_model; }
+	UNR_SimTransport& transport(void) { return m_transport; }
+
+protected:
+	void stampSamples(MPU6050_Sample* _samples, unsigned int _count, bool _fifo) override;
+};
@@ -0,0 +1,308 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Simulated MPU6050 which runs the MPU6050_RaspbPi driver without the I2C peripheral.
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Register file, synthetic motion data and FIFO model
+* Rev 2: Combined I2C_RDWR style transfers
+* Rev 3: Register map model on a UNR_SimTransport, optional real time sample clock
+* Rev 4: Gyro output rates shared with the driver
+* Rev 5: Auxiliary I2C master slave reads into EXT_SENS_DATA and the FIFO
+* Rev 6: DMP memory and quaternion packets
+* Rev 7: Sample source split out of step() for replayed data
+* Rev 8: 12 bank DMP memory
+* Rev 9: Running FIFO byte positions
+*/
+
+
+#include "MPU6050_Simulated.h"
+#include <cmath>
+
+MPU6050_Model::MPU6050_Model(void) : m_fifoHead(0)
+									, m_fifoCount(0)
+									, m_fifoWritten(0)
+									, m_fifoRemoved(0)
+									, m_sampleIndex(0)
+									, m_realTime(false)
+									, m_lastAdvance_ns(0)
+									, m_pending_ns(0)
+									, m_auxBus(nullptr)
+									, m_dmpAddress(0)
+									, m_dmpPacketBytes(MPU6050_DMP_MOTIONAPPS20_PACKET_SIZE)
+{
+	memset(m_dmpMemory, 0x00, MPU6050_DMP_MEMORY_SIZE);
+	resetRegisters();
+}
+
+/*
+* Power on register values as given in the register map document
+*/
+void MPU6050_Model::resetRegisters(void)
+{
+	memset(m_registers, 0x00, MPU6050_SIM_REGISTER_COUNT);
+	m_registers[MPU6050_RA_PWR_MGMT_1] = (1U << MPU6050_PWR1_SLEEP_BIT);
+	m_registers[MPU6050_RA_WHO_AM_I] = MPU6050_ADDRESS_AD0_LOW;
+	m_fifoRemoved += m_fifoCount;
+	m_fifoHead = 0;
+	m_fifoCount = 0;
+}
+
+void MPU6050_Model::pushFIFO(const unsigned char* _data, unsigned int _numBytes)
+{
+	for (unsigned int i = 0; i < _numBytes; i++)
+	{
+		if (m_fifoCount == MPU6050_FIFO_SIZE)
+		{
+			// full: the oldest byte is lost
+			m_fifoHead = (m_fifoHead + 1) % MPU6050_FIFO_SIZE;
+			m_fifoCount--;
+			m_fifoRemoved++;
+			m_registers[MPU6050_RA_INT_STATUS] |= (1U << MPU6050_INTERRUPT_FIFO_OFLOW_BIT);
+		}
+		m_fifo[(m_fifoHead + m_fifoCount) % MPU6050_FIFO_SIZE] = _data[i];
+		m_fifoCount++;
+		m_fifoWritten++;
+	}
+}
+
+unsigned char MPU6050_Model::popFIFO(void)
+{
+	unsigned char value;
+	if (m_fifoCount == 0) return 0xFF;
+	value = m_fifo[m_fifoHead];
+	m_fifoHead = (m_fifoHead + 1) % MPU6050_FIFO_SIZE;
+	m_fifoCount--;
+	m_fifoRemoved++;
+	return value;
+}
+
+unsigned char MPU6050_Model::readRegister(unsigned char _register)
+{
+	unsigned char value;
+	switch (_register)
+	{
+	case MPU6050_RA_FIFO_R_W: return popFIFO();
+	case MPU6050_RA_MEM_R_W:
+		value = m_dmpMemory[m_dmpAddress % MPU6050_DMP_MEMORY_SIZE];
+		m_dmpAddress = (unsigned short)((m_dmpAddress & 0xFF00) | ((m_dmpAddress + 1U) & 0xFF));
+		return value;
+	case MPU6050_RA_FIFO_COUNTH: return (unsigned char)(m_fifoCount >> 8);
+	case MPU6050_RA_FIFO_COUNTL: return (unsigned char)(m_fifoCount & 0xFF);
+	case MPU6050_RA_INT_STATUS:
+		value = m_registers[MPU6050_RA_INT_STATUS];
+		m_registers[MPU6050_RA_INT_STATUS] = 0x00;		// cleared on read
+		return value;
+	default:
+		return m_registers[_register % MPU6050_SIM_REGISTER_COUNT];
+	}
+}
+
+void MPU6050_Model::writeRegister(unsigned char _register, unsigned char _value)
+{
+	switch (_register)
+	{
+	case MPU6050_RA_FIFO_R_W: pushFIFO(&_value, 1U); break;
+	case MPU6050_RA_BANK_SEL:
+		m_registers[_register] = _value;
+		m_dmpAddress = (unsigned short)((_value << 8) | (m_dmpAddress & 0xFF));
+		break;
+	case MPU6050_RA_MEM_START_ADDR:
+		m_registers[_register] = _value;
+		m_dmpAddress = (unsigned short)((m_dmpAddress & 0xFF00) | _value);
+		break;
+	case MPU6050_RA_MEM_R_W:
+		m_dmpMemory[m_dmpAddress % MPU6050_DMP_MEMORY_SIZE] = _value;
+		m_dmpAddress = (unsigned short)((m_dmpAddress & 0xFF00) | ((m_dmpAddress + 1U) & 0xFF));
+		break;
+	case MPU6050_RA_WHO_AM_I:
+	case MPU6050_RA_INT_STATUS:
+	case MPU6050_RA_FIFO_COUNTH:
+	case MPU6050_RA_FIFO_COUNTL:
+		break;	// read only
+	case MPU6050_RA_USER_CTRL:
+		if (_value & (1U << MPU6050_USERCTRL_FIFO_RESET_BIT))
+		{
+			m_fifoRemoved += m_fifoCount;
+			m_fifoHead = 0;
+			m_fifoCount = 0;
+		}
+		// reset bits are self clearing
+		m_registers[_register] = _value & ~((1U << MPU6050_USERCTRL_DMP_RESET_BIT) | (1U << MPU6050_USERCTRL_FIFO_RESET_BIT)
+											| (1U << MPU6050_USERCTRL_I2C_MST_RESET_BIT) | (1U << MPU6050_USERCTRL_SIG_COND_RESET_BIT));
+		break;
+	case MPU6050_RA_PWR_MGMT_1:
+		if (_value & (1U << MPU6050_PWR1_DEVICE_RESET_BIT))
+		{
+			resetRegisters();
+			break;
+		}
+		m_registers[_register] = _value;
+		break;
+	default:
+		m_registers[_register % MPU6050_SIM_REGISTER_COUNT] = _value;
+		break;
+	}
+}
+
+uint64_t MPU6050_Model::samplePeriodNs(void) const
+{
+	unsigned char dlpf = m_registers[MPU6050_RA_CONFIG] & 0x07;
+	uint64_t gyroRate = (dlpf == 0 || dlpf == 7) ? MPU6050_GYRO_RATE_DLPF_OFF : MPU6050_GYRO_RATE_DLPF_ON;
+	return (1000000000ULL * (1U + m_registers[MPU6050_RA_SMPLRT_DIV])) / gyroRate;
+}
+
+void MPU6050_Model::advance(uint64_t _now_ns)
+{
+	uint64_t period;
+	if (!m_realTime) return;
+	if (m_lastAdvance_ns == 0 || _now_ns < m_lastAdvance_ns)
+	{
+		m_lastAdvance_ns = _now_ns;
+		return;
+	}
+	m_pending_ns += _now_ns - m_lastAdvance_ns;
+	m_lastAdvance_ns = _now_ns;
+	period = samplePeriodNs();
+	if (m_pending_ns < period) return;
+	// more than a full FIFO behind only overwrites frames, cap the work at one FIFO worth of samples
+	uint64_t due = m_pending_ns / period;
+	m_pending_ns -= due * period;
+	if (due > MPU6050_FIFO_SIZE) due = MPU6050_FIFO_SIZE;
+	step((unsigned int)due);
+}
+
+/*
+* One round of the I2C master: every enabled read slave in order, data packed into EXT_SENS_DATA.
+* Returns the number of EXT_SENS_DATA bytes filled.
+*/
+unsigned int MPU6050_Model::readAuxSlaves(void)
+{
+	struct i2c_msg msgs[2];
+	unsigned char reg;
+	unsigned int filled = 0, length;
+
+	if (m_auxBus == nullptr || !(m_registers[MPU6050_RA_USER_CTRL] & (1U << MPU6050_USERCTRL_I2C_MST_EN_BIT))) return 0;
+	for (unsigned int s = 0; s < 4U; s++)
+	{
+		unsigned char address = m_registers[MPU6050_RA_I2C_SLV0_ADDR + 3U * s];
+		unsigned char control = m_registers[MPU6050_RA_I2C_SLV0_CTRL + 3U * s];
+		if (!(control & (1U << MPU6050_I2C_SLV_EN_BIT)) || !(address & (1U << MPU6050_I2C_SLV_RW_BIT))) continue;
+		length = control & 0x0F;
+		if (filled + length > 24U) break;
+		reg = m_registers[MPU6050_RA_I2C_SLV0_REG + 3U * s];
+		msgs[0].addr = address & 0x7F;
+		msgs[0].flags = 0;
+		msgs[0].len = 1U;
+		msgs[0].buf = &reg;
+		msgs[1].addr = address & 0x7F;
+		msgs[1].flags = I2C_M_RD;
+		msgs[1].len = (unsigned short)length;
+		msgs[1].buf = &m_registers[MPU6050_RA_EXT_SENS_DATA_00 + filled];
+		// a NACK sets the slave's I2C_MST_STATUS bit and leaves the old data
+		if (m_auxBus->transfer(msgs, 2U) < 0)
+			m_registers[MPU6050_RA_I2C_MST_STATUS] |= (unsigned char)(1U << s);
+		filled += length;
+	}
+	return filled;
+}
+
+void MPU6050_Model::pushDMPPacket(double _angle)
+{
+	unsigned char packet[MPU6050_FIFO_SIZE] = {};
+	int32_t quaternion[4];
+	unsigned int length = m_dmpPacketBytes < MPU6050_FIFO_SIZE ? m_dmpPacketBytes : MPU6050_FIFO_SIZE;
+
+	// rotation by _angle about Z, Q30
+	quaternion[0] = (int32_t)(cos(_angle * 0.5) * 1073741823.0);
+	quaternion[1] = 0;
+	quaternion[2] = 0;
+	quaternion[3] = (int32_t)(sin(_angle * 0.5) * 1073741823.0);
+	for (unsigned int i = 0; i < 4 && 4 * i + 3 < length; i++)
+	{
+		packet[4 * i] = (unsigned char)((uint32_t)quaternion[i] >> 24);
+		packet[4 * i + 1] = (unsigned char)((uint32_t)quaternion[i] >> 16);
+		packet[4 * i + 2] = (unsigned char)((uint32_t)quaternion[i] >> 8);
+		packet[4 * i + 3] = (unsigned char)((uint32_t)quaternion[i]);
+	}
+	pushFIFO(packet, length);
+}
+
+/*
+* Slow rotation about Z with gravity on the Z axis, deterministic so captured runs can be compared
+*/
+bool MPU6050_Model::generate(signed short* _value)
+{
+	double phase = (double)m_sampleIndex * 0.01;
+	_value[0] = (signed short)(2000.0 * sin(phase));
+	_value[1] = (signed short)(2000.0 * cos(phase));
+	_value[2] = (signed short)16384;
+	_value[3] = (signed short)((25.0 - 36.53) * 340.0);
+	_value[4] = (signed short)(500.0 * sin(phase * 0.5));
+	_value[5] = (signed short)(-500.0 * sin(phase * 0.5));
+	_value[6] = (signed short)1310;
+	return true;
+}
+
+void MPU6050_Model::step(unsigned int _samples)
+{
+	unsigned char frame[MPU6050_FIFO_FRAME_SIZE];
+	unsigned char fifoEnable;
+	unsigned int offset;
+	bool routed;
+	signed short value[7];
+
+	for (unsigned int s = 0; s < _samples; s++)
+	{
+		if (m_registers[MPU6050_RA_PWR_MGMT_1] & (1U << MPU6050_PWR1_SLEEP_BIT)) return;
+		if (!generate(value)) return;
+
+		for (unsigned int i = 0; i < 7; i++)
+		{
+			frame[2 * i] = (unsigned char)(((unsigned short)value[i]) >> 8);
+			frame[2 * i + 1] = (unsigned char)(((unsigned short)value[i]) & 0xFF);
+		}
+		memcpy(&m_registers[MPU6050_RA_ACCEL_XOUT_H], frame, MPU6050_FIFO_FRAME_SIZE);
+		readAuxSlaves();
+		m_registers[MPU6050_RA_INT_STATUS] |= (1U << MPU6050_INTERRUPT_DATA_RDY_BIT);
+
+		if ((m_registers[MPU6050_RA_USER_CTRL] & (1U << MPU6050_USERCTRL_DMP_EN_BIT))
+			&& (m_registers[MPU6050_RA_USER_CTRL] & (1U << MPU6050_USERCTRL_FIFO_EN_BIT)))
+			pushDMPPacket((double)m_sampleIndex * 0.01);	// the angle of the synthetic rotation
+
+		fifoEnable = m_registers[MPU6050_RA_FIFO_EN];
+		if ((m_registers[MPU6050_RA_USER_CTRL] & (1U << MPU6050_USERCTRL_FIFO_EN_BIT)) && fifoEnable)
+		{
+			// FIFO frames follow the register order: ACCEL, TEMP, GYRO X, GYRO Y, GYRO Z
+			if (fifoEnable & (1U << MPU6050_ACCEL_FIFO_EN_BIT)) pushFIFO(&frame[0], 6U);
+			if (fifoEnable & (1U << MPU6050_TEMP_FIFO_EN_BIT)) pushFIFO(&frame[6], 2U);
+			if (fifoEnable & (1U << MPU6050_XG_FIFO_EN_BIT)) pushFIFO(&frame[8], 2U);
+			if (fifoEnable & (1U << MPU6050_YG_FIFO_EN_BIT)) pushFIFO(&frame[10], 2U);
+			if (fifoEnable & (1U << MPU6050_ZG_FIFO_EN_BIT)) pushFIFO(&frame[12], 2U);
+			// then the routed slaves, each with its part of EXT_SENS_DATA
+			offset = 0;
+			for (unsigned int slave = 0; slave < 4U; slave++)
+			{
+				unsigned char control = m_registers[MPU6050_RA_I2C_SLV0_CTRL + 3U * slave];
+				if (!(control & (1U << MPU6050_I2C_SLV_EN_BIT))
+					|| !(m_registers[MPU6050_RA_I2C_SLV0_ADDR + 3U * slave] & (1U << MPU6050_I2C_SLV_RW_BIT))) continue;
+				routed = (slave < 3U) ? (fifoEnable & (1U << (MPU6050_SLV0_FIFO_EN_BIT + slave))) != 0
+									: (m_registers[MPU6050_RA_I2C_MST_CTRL] & (1U << MPU6050_SLV_3_FIFO_EN_BIT)) != 0;
+				if (routed && offset + (control & 0x0FU) <= 24U) pushFIFO(&m_registers[MPU6050_RA_EXT_SENS_DATA_00 + offset], control & 0x0FU);
+				offset += control & 0x0FU;
+			}
+		}
+		m_sampleIndex++;
+	}
+}
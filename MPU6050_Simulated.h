@@ -0,0 +1,158 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Simulated MPU6050 which runs the MPU6050_RaspbPi driver without the I2C peripheral.
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Register file, synthetic motion data and FIFO model
+* Rev 2: Combined I2C_RDWR style transfers
+* Rev 3: Register map model on a UNR_SimTransport, optional real time sample clock
+* Rev 4: Auxiliary I2C master reading slaves 0..3 from a second transport
+* Rev 5: DMP memory banks and quaternion packets
+* Rev 6: Overridable sample source
+* Rev 7: 12 bank DMP memory, MotionApps 2.0 packet size by default
+* Rev 8: Running FIFO byte positions
+*/
+
+
+#pragma once
+#include "MPU6050_RaspbPi.h"
+#include "UNR_SimTransport.h"
+
+#define MPU6050_SIM_REGISTER_COUNT	0x80
+
+/*
+* Register map of the chip. Attach it to a UNR_SimTransport at its address (I2C) or as the SPI device (MPU-6000
+* register protocol) and drive any number of drivers against it.
+*/
+class MPU6050_Model : public UNR_SimDevice
+{
+private:
+	unsigned char m_registers[MPU6050_SIM_REGISTER_COUNT];
+	unsigned char m_fifo[MPU6050_FIFO_SIZE];
+	unsigned int m_fifoHead;		// index of the oldest byte
+	unsigned int m_fifoCount;
+	uint64_t m_fifoWritten;			// bytes ever pushed
+	uint64_t m_fifoRemoved;			// bytes ever read, dropped on overflow or cleared by a reset
+	unsigned long m_sampleIndex;
+	bool m_realTime;
+	uint64_t m_lastAdvance_ns;
+	uint64_t m_pending_ns;			// time since the last generated sample
+	UNR_I2CTransport* m_auxBus;
+	unsigned char m_dmpMemory[MPU6050_DMP_MEMORY_SIZE];
+	unsigned short m_dmpAddress;		// BANK_SEL << 8 | MEM_START_ADDR, advanced by every MEM_R_W byte
+	unsigned short m_dmpPacketBytes;
+
+	unsigned int readAuxSlaves(void);
+	void pushDMPPacket(double _angle);
+
+	void resetRegisters(void);
+	void pushFIFO(const unsigned char* _data, unsigned int _numBytes);
+	unsigned char popFIFO(void);
+
+protected:
+	/*
+	* Source of the data registers: fills ACCEL_X .. GYRO_Z (7 values, register order) for the next sample.
+	* Returning false generates no sample (end of a replayed recording). The default is the synthetic motion.
+	*/
+	virtual bool generate(signed short* _value);
+	unsigned char registerValue(unsigned char _register) const { return m_registers[_register % MPU6050_SIM_REGISTER_COUNT]; }
+	/*
+	* Running positions in the FIFO byte stream: the next byte pushed is number getFIFOWritten(), the next one
+	* read is number getFIFORemoved(). A sample source uses them to tell which sample a FIFO byte belongs to.
+	*/
+	uint64_t getFIFOWritten(void) const { return m_fifoWritten; }
+	uint64_t getFIFORemoved(void) const { return m_fifoRemoved; }
+
+public:
+	MPU6050_Model(void);
+	virtual ~MPU6050_Model(void) {}
+
+	/*
+	* Register access as seen over the bus. MPU6050_RA_FIFO_R_W pops one FIFO byte per transferred byte and keeps
+	* the register pointer in place, INT_STATUS is cleared on read.
+	*/
+	unsigned char readRegister(unsigned char _register) override;
+	void writeRegister(unsigned char _register, unsigned char _value) override;
+	bool autoIncrement(unsigned char _register) const override { return _register != MPU6050_RA_FIFO_R_W && _register != MPU6050_RA_MEM_R_W; }
+
+	/*
+	* Advance the simulated sample clock by _samples output periods. Every period updates the data registers,
+	* raises DATA_RDY and, when enabled, appends one frame to the FIFO. When the FIFO is full the oldest bytes
+	* are dropped and MPU6050_INTERRUPT_FIFO_OFLOW_BIT is raised, like the real device does.
+	*/
+	void step(unsigned int _samples);
+
+	/*
+	* Real time mode: every transaction first generates the samples due since the previous one at the rate
+	* programmed in SMPLRT_DIV and CONFIG (8 kHz gyro output with DLPF_CFG 0 or 7, 1 kHz otherwise, / (1 + SMPLRT_DIV)).
+	* Off by default, tests call step() instead.
+	*/
+	void setRealTime(bool _enable) { m_realTime = _enable; m_lastAdvance_ns = 0; m_pending_ns = 0; }
+	void advance(uint64_t _now_ns) override;
+	uint64_t samplePeriodNs(void) const;
+
+	/*
+	* Bus on the AUX_DA / AUX_CL pins. With I2C_MST_EN set every sample reads the enabled slaves 0..3 from it into
+	* EXT_SENS_DATA and appends the routed ones to the FIFO frame. Use a transport without latency, the reads happen
+	* inside step().
+	*/
+	void attachAuxBus(UNR_I2CTransport* _bus) { m_auxBus = _bus; }
+
+	/*
+	* DMP stand in: the memory banks behave like the chip's (BANK_SEL, MEM_START_ADDR, MEM_R_W wrapping within a bank),
+	* the firmware is not executed. With DMP_EN and FIFO_EN set every sample appends a _packetBytes packet that starts
+	* with the Q30 quaternion of the synthetic rotation about Z (MPU6050_DMP_MOTIONAPPS20_PACKET_SIZE unless set).
+	*/
+	void setDMPPacketSize(unsigned short _packetBytes) { m_dmpPacketBytes = _packetBytes; }
+	const unsigned char* getDMPMemory(void) const { return m_dmpMemory; }
+
+	unsigned long getSampleIndex(void) const { return m_sampleIndex; }
+	unsigned int getFIFOCount(void) const { return m_fifoCount; }
+};
+
+/*
+* The transport and the model have to exist before MPU6050_RaspbPi borrows the transport, so they sit in a base
+* that is constructed first.
+*/
+struct MPU6050_SimulatedBus
+{
+	UNR_SimTransport m_transport;
+	MPU6050_Model m_model;
+	MPU6050_SimulatedBus(unsigned char _devAddress, const UNR_SimLatency& _latency) : m_transport(_latency)
+	{
+		m_transport.attach(_devAddress, &m_model);
+	}
+};
+
+/*
+* Driver, transport and model in one object for single sensor tests and benchmarks.
+*/
+class MPU6050_Simulated : private MPU6050_SimulatedBus, public MPU6050_RaspbPi
+{
+public:
+	MPU6050_Simulated(unsigned char _devAddress = MPU6050_DEVICE_ADDRESS, const UNR_SimLatency& _latency = UNR_SIM_LATENCY_NONE)
+		: MPU6050_SimulatedBus(_devAddress, _latency)
+		, MPU6050_RaspbPi(m_transport, _devAddress)
+	{
+	}
+	~MPU6050_Simulated(void) {}
+
+	void step(unsigned int _samples) { m_model.step(_samples); }
+	unsigned long getSampleIndex(void) const { return m_model.getSampleIndex(); }
+	unsigned int getSimulatedFIFOCount(void) const { return m_model.getFIFOCount(); }
+
+	MPU6050_Model& model(void) { return m_model; }
+	UNR_SimTransport& transport(void) { return m_transport; }
+};
@@ -0,0 +1,162 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Register backends behind UNR_GpioChip (hardware mapping, plain memory, simulator, trace)
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Mapped, memory, BCM2711 simulator and tracing backends
+*/
+
+
+#include "UNR_BCM2711_GpioBackend.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <time.h>
+#include <cstring>
+#include <string>
+
+/*
+* /dev/gpiomem needs no root and maps the page at offset 0, /dev/mem needs root and the peripheral address.
+* The file descriptor is not needed once the mapping exists.
+*/
+UNR_GpioMappedBackend::UNR_GpioMappedBackend(void) noexcept(false) : m_mapping(MAP_FAILED)
+{
+	int fd;
+	if ((fd = open("/dev/gpiomem", O_RDWR | O_SYNC | O_CLOEXEC)) >= 0)
+	{
+		m_mapping = mmap(nullptr, ARM_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+	}
+	if (m_mapping == MAP_FAILED && (fd = open("/dev/mem", O_RDWR | O_SYNC | O_CLOEXEC)) >= 0)
+	{
+		m_mapping = mmap(nullptr, ARM_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, UNR_BCM2711_GPIO_BASE_ADDR);
+		close(fd);
+	}
+	if (m_mapping == MAP_FAILED)
+		throw std::runtime_error(std::string("Error Mapping GPIO Registers"));
+}
+
+UNR_GpioMappedBackend::~UNR_GpioMappedBackend(void)
+{
+	munmap(m_mapping, ARM_BLOCK_SIZE);
+}
+
+UNR_GpioMemoryBackend::UNR_GpioMemoryBackend(void) noexcept(false)
+{
+	// anonymous mappings are page aligned and zero filled
+	m_mapping = mmap(nullptr, ARM_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (m_mapping == MAP_FAILED)
+		throw std::runtime_error(std::string("Error Allocating GPIO Register Page"));
+}
+
+UNR_GpioMemoryBackend::~UNR_GpioMemoryBackend(void)
+{
+	munmap(m_mapping, ARM_BLOCK_SIZE);
+}
+
+UNR_GpioSimBackend::UNR_GpioSimBackend(void)
+{
+	memset(m_registers, 0, sizeof(m_registers));
+	memset(m_outputLatch, 0, sizeof(m_outputLatch));
+	memset(m_driven, 0, sizeof(m_driven));
+	memset(m_drivenLevel, 0, sizeof(m_drivenLevel));
+}
+
+unsigned int UNR_GpioSimBackend::pinFunction(unsigned int _pin) const
+{
+	return (m_registers[UNR_FSEL_OFFSET + _pin / 10U] >> ((_pin % 10U) * 3U)) & 7U;
+}
+
+unsigned int UNR_GpioSimBackend::pinPull(unsigned int _pin) const
+{
+	return (m_registers[UNR_PULLUPDN_OFFSET_2711_0 + (_pin >> 4)] >> ((_pin & 0xFU) << 1)) & 3U;
+}
+
+uint32_t UNR_GpioSimBackend::level(unsigned int _bank) const
+{
+	uint32_t value = 0;
+	for (unsigned int bit = 0; bit < 32U; bit++)
+	{
+		unsigned int pin = _bank * 32U + bit;
+		uint32_t mask = 1U << bit;
+		bool high;
+		if (pin >= UNR_GPIO_PIN_COUNT) break;
+		if (pinFunction(pin) == 1U)
+			high = (m_outputLatch[_bank] & mask) != 0;
+		else if (m_driven[_bank] & mask)
+			high = (m_drivenLevel[_bank] & mask) != 0;
+		else
+			high = pinPull(pin) == 1U;	// 1 pull up, 2 pull down, 0 floating reads low
+		if (high) value |= mask;
+	}
+	return value;
+}
+
+uint32_t UNR_GpioSimBackend::read(unsigned int _offset)
+{
+	if (_offset >= UNR_SET_OFFSET && _offset < UNR_SET_OFFSET + UNR_GPIO_BANKS) return 0;
+	if (_offset >= UNR_CLR_OFFSET && _offset < UNR_CLR_OFFSET + UNR_GPIO_BANKS) return 0;
+	if (_offset >= UNR_PINLEVEL_OFFSET && _offset < UNR_PINLEVEL_OFFSET + UNR_GPIO_BANKS) return level(_offset - UNR_PINLEVEL_OFFSET);
+	if (_offset >= UNR_GPIO_REGISTER_WORDS) return 0;
+	return m_registers[_offset];
+}
+
+void UNR_GpioSimBackend::write(unsigned int _offset, uint32_t _value)
+{
+	if (_offset >= UNR_SET_OFFSET && _offset < UNR_SET_OFFSET + UNR_GPIO_BANKS)
+		m_outputLatch[_offset - UNR_SET_OFFSET] |= _value;
+	else if (_offset >= UNR_CLR_OFFSET && _offset < UNR_CLR_OFFSET + UNR_GPIO_BANKS)
+		m_outputLatch[_offset - UNR_CLR_OFFSET] &= ~_value;
+	else if (_offset >= UNR_PINLEVEL_OFFSET && _offset < UNR_PINLEVEL_OFFSET + UNR_GPIO_BANKS)
+		return;		// read only
+	else if (_offset < UNR_GPIO_REGISTER_WORDS)
+		m_registers[_offset] = _value;
+}
+
+void UNR_GpioSimBackend::driveInput(unsigned int _pin, bool _level)
+{
+	if (_pin >= UNR_GPIO_PIN_COUNT) return;
+	m_driven[_pin >> 5] |= 1U << (_pin & 31U);
+	if (_level)
+		m_drivenLevel[_pin >> 5] |= 1U << (_pin & 31U);
+	else
+		m_drivenLevel[_pin >> 5] &= ~(1U << (_pin & 31U));
+}
+
+void UNR_GpioSimBackend::releaseInput(unsigned int _pin)
+{
+	if (_pin >= UNR_GPIO_PIN_COUNT) return;
+	m_driven[_pin >> 5] &= ~(1U << (_pin & 31U));
+}
+
+UNR_GpioTraceBackend::UNR_GpioTraceBackend(UNR_GpioBackend* _target, unsigned int _capacity) noexcept(false) : m_target(_target)
+																											, m_capacity(_capacity)
+																											, m_dropped(0)
+{
+	if (m_target == nullptr)
+		throw std::runtime_error(std::string("GPIO Trace Needs A Target Backend"));
+	m_log.reserve(_capacity);
+}
+
+void UNR_GpioTraceBackend::write(unsigned int _offset, uint32_t _value)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	m_target->write(_offset, _value);
+	if (m_log.size() < m_capacity)
+		m_log.push_back({ (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec, _offset, _value });
+	else
+		m_dropped++;
+}
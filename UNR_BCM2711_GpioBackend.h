@@ -0,0 +1,153 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Register backends behind UNR_GpioChip (hardware mapping, plain memory, simulator, trace)
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Mapped, memory, BCM2711 simulator and tracing backends
+* Rev 2: Bank count taken from UNR_GPIO_BCM2711.h
+*/
+
+
+#pragma once
+#include <stdint.h>
+#include <stdexcept>
+#include <vector>
+#include "UNR_GPIO_BCM2711.h"
+
+constexpr unsigned int UNR_GPIO_PIN_COUNT = 58U;
+constexpr unsigned int UNR_GPIO_BANKS = UNR_GPIO_BANK_COUNT;
+constexpr unsigned int UNR_GPIO_REGISTER_WORDS = UNR_PULLUPDN_OFFSET_2711_3 + 1U;
+
+/*
+* Word addressed access to the GPIO register page, offsets as in UNR_GPIO_BCM2711.h.
+* Backends whose registers are plain memory return the page from directRegisters(); UNR_GpioChip and UNR_GpioPin
+* then store through the pointer and never call read() / write(). Backends that need to see every access
+* (models, tracing) return nullptr and are called through the virtual functions, pins on such a chip are
+* UNR_GpioIndirectPin.
+*/
+class UNR_GpioBackend
+{
+public:
+	virtual ~UNR_GpioBackend(void) {}
+	virtual volatile uint32_t* directRegisters(void) { return nullptr; }
+	virtual uint32_t read(unsigned int _offset) = 0;
+	virtual void write(unsigned int _offset, uint32_t _value) = 0;
+};
+
+/*
+* The peripheral: /dev/gpiomem, or /dev/mem at the BCM2711 GPIO address. Throws std::runtime_error when neither maps.
+*/
+class UNR_GpioMappedBackend : public UNR_GpioBackend
+{
+private:
+	void* m_mapping;
+
+public:
+	UNR_GpioMappedBackend(void) noexcept(false);
+	~UNR_GpioMappedBackend(void);
+	UNR_GpioMappedBackend(const UNR_GpioMappedBackend&) = delete;
+	UNR_GpioMappedBackend& operator = (const UNR_GpioMappedBackend&) = delete;
+
+	volatile uint32_t* directRegisters(void) override { return static_cast<volatile uint32_t*>(m_mapping); }
+	uint32_t read(unsigned int _offset) override { return directRegisters()[_offset]; }
+	void write(unsigned int _offset, uint32_t _value) override { directRegisters()[_offset] = _value; }
+};
+
+/*
+* Anonymous page with the register layout and no behaviour: stores land as is. Same cost as the hardware path,
+* used for throughput measurements off target.
+*/
+class UNR_GpioMemoryBackend : public UNR_GpioBackend
+{
+private:
+	void* m_mapping;
+
+public:
+	UNR_GpioMemoryBackend(void) noexcept(false);
+	~UNR_GpioMemoryBackend(void);
+	UNR_GpioMemoryBackend(const UNR_GpioMemoryBackend&) = delete;
+	UNR_GpioMemoryBackend& operator = (const UNR_GpioMemoryBackend&) = delete;
+
+	volatile uint32_t* directRegisters(void) override { return static_cast<volatile uint32_t*>(m_mapping); }
+	uint32_t read(unsigned int _offset) override { return directRegisters()[_offset]; }
+	void write(unsigned int _offset, uint32_t _value) override { directRegisters()[_offset] = _value; }
+};
+
+/*
+* Model of the BCM2711 GPIO block:
+*  - SET / CLR update the output latch and read back as 0 (write only).
+*  - LEV is computed: output pins (FSEL 001) show the latch, inputs show the level driven with driveInput(),
+*    undriven inputs follow their pull (up 1, down or none 0). Writes to LEV are ignored.
+*  - FSEL and the pull registers are plain storage.
+*/
+class UNR_GpioSimBackend : public UNR_GpioBackend
+{
+private:
+	uint32_t m_registers[UNR_GPIO_REGISTER_WORDS];
+	uint32_t m_outputLatch[UNR_GPIO_BANKS];
+	uint32_t m_driven[UNR_GPIO_BANKS];			// inputs driven from outside
+	uint32_t m_drivenLevel[UNR_GPIO_BANKS];
+
+	unsigned int pinFunction(unsigned int _pin) const;
+	unsigned int pinPull(unsigned int _pin) const;
+	uint32_t level(unsigned int _bank) const;
+
+public:
+	UNR_GpioSimBackend(void);
+
+	uint32_t read(unsigned int _offset) override;
+	void write(unsigned int _offset, uint32_t _value) override;
+
+	/*
+	* Outside world: drive an input pin to a level, or release it to its pull.
+	*/
+	void driveInput(unsigned int _pin, bool _level);
+	void releaseInput(unsigned int _pin);
+	uint32_t getOutputLatch(unsigned int _bank) const { return m_outputLatch[_bank]; }
+};
+
+struct UNR_GpioTraceEntry
+{
+	uint64_t timestamp;			// CLOCK_MONOTONIC, ns
+	uint32_t offset;
+	uint32_t value;
+};
+
+/*
+* Forwards every access to the wrapped backend (taken over by this object) and records each store with a timestamp.
+* The log is allocated up front; stores past _capacity are still forwarded but only counted.
+*/
+class UNR_GpioTraceBackend : public UNR_GpioBackend
+{
+private:
+	UNR_GpioBackend* m_target;
+	std::vector<UNR_GpioTraceEntry> m_log;
+	unsigned int m_capacity;
+	uint64_t m_dropped;
+
+public:
+	UNR_GpioTraceBackend(UNR_GpioBackend* _target, unsigned int _capacity) noexcept(false);
+	~UNR_GpioTraceBackend(void) { delete m_target; }
+	UNR_GpioTraceBackend(const UNR_GpioTraceBackend&) = delete;
+	UNR_GpioTraceBackend& operator = (const UNR_GpioTraceBackend&) = delete;
+
+	uint32_t read(unsigned int _offset) override { return m_target->read(_offset); }
+	void write(unsigned int _offset, uint32_t _value) override;
+
+	const std::vector<UNR_GpioTraceEntry>& getTrace(void) const { return m_log; }
+	uint64_t getDropped(void) const { return m_dropped; }
+	void clearTrace(void) { m_log.clear(); m_dropped = 0; }
+	UNR_GpioBackend& getTarget(void) { return *m_target; }
+};
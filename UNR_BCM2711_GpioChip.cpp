@@ -0,0 +1,55 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Class interface to the BCM2711 GPIO register page
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: RAII owner of the register mapping, compile time specialized pins
+* Rev 2: Pluggable register backend, direct stores whenever the backend is plain memory
+*/
+
+
+#include "UNR_BCM2711_GpioChip.h"
+#include <string>
+
+UNR_GpioChip::UNR_GpioChip(void) noexcept(false) : m_backend(new UNR_GpioMappedBackend())
+												, m_registers(m_backend->directRegisters())
+{
+}
+
+UNR_GpioChip::UNR_GpioChip(UNR_GpioMemoryBacked) noexcept(false) : m_backend(new UNR_GpioMemoryBackend())
+																, m_registers(m_backend->directRegisters())
+{
+}
+
+UNR_GpioChip::UNR_GpioChip(UNR_GpioBackend* _backend) noexcept(false) : m_backend(_backend)
+																	, m_registers(nullptr)
+{
+	if (m_backend == nullptr)
+		throw std::runtime_error(std::string("GPIO Chip Needs A Register Backend"));
+	m_registers = m_backend->directRegisters();
+}
+
+void UNR_GpioChip::setupPin(unsigned int _pin, int _direction, int _pud)
+{
+	unsigned int pullOffset = UNR_PULLUPDN_OFFSET_2711_0 + (_pin >> 4);
+	unsigned int pullShift = (_pin & 0xFU) << 1;
+	unsigned int fselOffset = UNR_FSEL_OFFSET + _pin / 10U;
+	unsigned int fselShift = (_pin % 10U) * 3U;
+	uint32_t pull = (_pud == PUD_UP) ? 1U : (_pud == PUD_DOWN) ? 2U : 0U;
+
+	if (_pin >= UNR_GPIO_PIN_COUNT) return;
+	store(pullOffset, (load(pullOffset) & ~(3U << pullShift)) | (pull << pullShift));
+	store(fselOffset, (load(fselOffset) & ~(7U << fselShift)) | ((_direction == OUTPUT ? 1U : 0U) << fselShift));
+}
@@ -0,0 +1,167 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Class interface to the BCM2711 GPIO register page
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: RAII owner of the register mapping, compile time specialized pins
+* Rev 2: Pluggable register backend, direct stores whenever the backend is plain memory
+* Rev 3: Pin access as a template parameter, direct pins carry no backend test
+* Rev 4: Bank wide access rejects banks other than 0 and 1
+*/
+
+
+#pragma once
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include "UNR_GPIO_BCM2711.h"
+#include "UNR_BCM2711_GpioBackend.h"
+
+// Tag for a chip backed by ordinary memory instead of the peripheral (same layout, no hardware access)
+struct UNR_GpioMemoryBacked {};
+
+/*
+* Owns the register backend for its lifetime. The default constructor maps the peripheral and throws
+* std::runtime_error when neither /dev/gpiomem nor /dev/mem can be mapped, so an existing object always has
+* working registers and nothing on the access path needs to check for setup.
+*
+* When the backend is plain memory (hardware or UNR_GpioMemoryBackend) registers() is its page and all
+* accesses are direct stores and loads. Otherwise registers() is nullptr and accesses go through the backend.
+*/
+class UNR_GpioChip
+{
+private:
+	UNR_GpioBackend* m_backend;
+	volatile uint32_t* m_registers;
+
+public:
+	UNR_GpioChip(void) noexcept(false);
+	explicit UNR_GpioChip(UNR_GpioMemoryBacked) noexcept(false);
+	explicit UNR_GpioChip(UNR_GpioBackend* _backend) noexcept(false);	// _backend is taken over by the chip
+	~UNR_GpioChip(void) { delete m_backend; }
+	UNR_GpioChip(const UNR_GpioChip&) = delete;
+	UNR_GpioChip& operator = (const UNR_GpioChip&) = delete;
+
+	volatile uint32_t* registers(void) const { return m_registers; }
+	UNR_GpioBackend& backend(void) const { return *m_backend; }
+
+	uint32_t load(unsigned int _offset) const { return m_registers ? m_registers[_offset] : m_backend->read(_offset); }
+	void store(unsigned int _offset, uint32_t _value) const
+	{
+		if (m_registers) m_registers[_offset] = _value;
+		else m_backend->write(_offset, _value);
+	}
+
+	/*
+	* Pin setup for pins only known at run time. Direction is INPUT / OUTPUT, pull is PUD_OFF / PUD_UP / PUD_DOWN.
+	*/
+	void setupPin(unsigned int _pin, int _direction, int _pud);
+
+	/*
+	* Bank wide access, same semantics as gpio_write_mask / gpio_write_value / gpio_read_bank: a bank other than
+	* 0 / 1 writes nothing and returns -1, reads as 0.
+	*/
+	int writeMask(unsigned int _bank, uint32_t _setMask, uint32_t _clrMask) const
+	{
+		if (_bank >= UNR_GPIO_BANKS) return -1;
+		if (_setMask) store(UNR_SET_OFFSET + _bank, _setMask);
+		if (_clrMask) store(UNR_CLR_OFFSET + _bank, _clrMask);
+		return 0;
+	}
+	int writeValue(unsigned int _bank, uint32_t _mask, uint32_t _value) const { return writeMask(_bank, _value & _mask, ~_value & _mask); }
+	uint32_t readBank(unsigned int _bank) const { return _bank < UNR_GPIO_BANKS ? load(UNR_PINLEVEL_OFFSET + _bank) : 0U; }
+};
+
+/*
+* Access policies of UNR_GpioPin.
+* UNR_GpioDirect keeps the register page of a plain memory chip (hardware or UNR_GpioMemoryBacked), every access is
+* one volatile store or load. Constructing it on a chip without direct registers throws std::runtime_error, so the
+* pin never has to check.
+* UNR_GpioIndirect calls the backend's read() / write() and works on any chip, e.g. one driving a
+* UNR_GpioSimBackend or UNR_GpioTraceBackend.
+*/
+struct UNR_GpioDirect
+{
+	volatile uint32_t* const m_registers;
+
+	explicit UNR_GpioDirect(const UNR_GpioChip& _chip) noexcept(false) : m_registers(_chip.registers())
+	{
+		if (m_registers == nullptr)
+			throw std::runtime_error(std::string("GPIO Backend Has No Direct Registers, Use UNR_GpioIndirect"));
+	}
+	uint32_t load(unsigned int _offset) const { return m_registers[_offset]; }
+	void store(unsigned int _offset, uint32_t _value) const { m_registers[_offset] = _value; }
+};
+
+struct UNR_GpioIndirect
+{
+	UNR_GpioBackend& m_backend;
+
+	explicit UNR_GpioIndirect(const UNR_GpioChip& _chip) : m_backend(_chip.backend()) {}
+	uint32_t load(unsigned int _offset) const { return m_backend.read(_offset); }
+	void store(unsigned int _offset, uint32_t _value) const { m_backend.write(_offset, _value); }
+};
+
+/*
+* A single pin with its register offsets and bit mask fixed at compile time. With the default UNR_GpioDirect access
+* set(), clear() and read() are one store or load through the register pointer captured at construction, no test
+* and no call. UNR_GpioIndirectPin goes through the backend instead.
+*/
+template<unsigned int Pin, typename Access = UNR_GpioDirect>
+class UNR_GpioPin
+{
+	static_assert(Pin < UNR_GPIO_PIN_COUNT, "UNR_GpioPin: the BCM2711 has GPIO 0-57");
+
+public:
+	static constexpr unsigned int kBank = Pin >> 5;
+	static constexpr uint32_t kMask = 1U << (Pin & 31U);
+	static constexpr unsigned int kSetOffset = UNR_SET_OFFSET + kBank;
+	static constexpr unsigned int kClrOffset = UNR_CLR_OFFSET + kBank;
+	static constexpr unsigned int kLevelOffset = UNR_PINLEVEL_OFFSET + kBank;
+	static constexpr unsigned int kFselOffset = UNR_FSEL_OFFSET + Pin / 10U;
+	static constexpr unsigned int kFselShift = (Pin % 10U) * 3U;
+	static constexpr unsigned int kPullOffset = UNR_PULLUPDN_OFFSET_2711_0 + (Pin >> 4);
+	static constexpr unsigned int kPullShift = (Pin & 0xFU) << 1;
+
+private:
+	const Access m_access;
+
+public:
+	explicit UNR_GpioPin(const UNR_GpioChip& _chip) noexcept(false) : m_access(_chip) {}
+	UNR_GpioPin(const UNR_GpioChip& _chip, int _direction, int _pud = PUD_OFF) noexcept(false) : m_access(_chip)
+	{
+		setup(_direction, _pud);
+	}
+
+	void setup(int _direction, int _pud = PUD_OFF) const
+	{
+		// BCM2711 pull encoding: 0 none, 1 up, 2 down
+		uint32_t pull = (_pud == PUD_UP) ? 1U : (_pud == PUD_DOWN) ? 2U : 0U;
+		m_access.store(kPullOffset, (m_access.load(kPullOffset) & ~(3U << kPullShift)) | (pull << kPullShift));
+		m_access.store(kFselOffset, (m_access.load(kFselOffset) & ~(7U << kFselShift)) | ((_direction == OUTPUT ? 1U : 0U) << kFselShift));
+	}
+
+	void set(void) const { m_access.store(kSetOffset, kMask); }
+	void clear(void) const { m_access.store(kClrOffset, kMask); }
+	void write(bool _value) const
+	{
+		if (_value) set();
+		else clear();
+	}
+	bool read(void) const { return (m_access.load(kLevelOffset) & kMask) != 0; }
+};
+
+template<unsigned int Pin>
+using UNR_GpioIndirectPin = UNR_GpioPin<Pin, UNR_GpioIndirect>;
@@ -0,0 +1,72 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Shared I2C adapter, one file descriptor for every device on the bus
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Per message addressing through I2C_RDWR, transfers serialized by a bus lock
+* Rev 2: Kernel backed UNR_I2CTransport
+* Rev 3: The bus lock can be put in front of another transport (simulated adapter)
+*/
+
+
+#include "UNR_BCM2711_I2CBus.h"
+#include "UNR_BCM2711_I2CHandle.h"
+
+/*
+* Opens /dev/i2c-<_instance> (0 or 1, anything else is /dev/i2c-1 like UNR_I2CHandle)
+*/
+UNR_I2CBus::UNR_I2CBus(unsigned char _instance) noexcept(false) : UNR_I2CBus(_instance == 0 ? RPI4_I2C_DEV_INSTANCE0 : RPI4_I2C_DEV_INSTANCE1)
+{
+}
+
+/*
+* Per message addressing needs plain I2C transfers, SMBus only adapters are rejected
+*/
+UNR_I2CBus::UNR_I2CBus(const char _charFD[]) noexcept(false) : m_intFile_descriptor(-1)
+															, m_u4Functions(0)
+															, m_adapter(nullptr)
+{
+	m_intFile_descriptor = open(_charFD, O_RDWR | O_CLOEXEC);
+	if (m_intFile_descriptor < 0)
+	{
+		throw std::runtime_error(std::string("Error Opening I2C Port"));
+	}
+	if (ioctl(m_intFile_descriptor, I2C_FUNCS, &m_u4Functions) == I2OCTRL_FAIL || !(m_u4Functions & I2C_FUNC_I2C))
+	{
+		close(m_intFile_descriptor);
+		throw std::runtime_error(std::string("I2C Adapter Does Not Support I2C_RDWR"));
+	}
+}
+
+UNR_I2CBus::UNR_I2CBus(UNR_I2CTransport& _adapter) noexcept : m_intFile_descriptor(-1)
+															, m_u4Functions(_adapter.functions() | I2C_FUNC_I2C)
+															, m_adapter(&_adapter)
+{
+}
+
+int UNR_I2CBus::transferLocked(struct i2c_msg* _msgs, unsigned int _count) noexcept
+{
+	struct i2c_rdwr_ioctl_data data;
+	if (m_adapter != nullptr) return m_adapter->transfer(_msgs, _count);
+	data.msgs = _msgs;
+	data.nmsgs = _count;
+	return ioctl(m_intFile_descriptor, I2C_RDWR, &data);
+}
+
+UNR_I2CBus::~UNR_I2CBus(void)
+{
+	if (m_intFile_descriptor >= 0) close(m_intFile_descriptor);
+	m_intFile_descriptor = -1;
+}
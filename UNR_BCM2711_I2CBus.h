@@ -0,0 +1,79 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Shared I2C adapter, one file descriptor for every device on the bus
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Per message addressing through I2C_RDWR, transfers serialized by a bus lock
+* Rev 2: Kernel backed UNR_I2CTransport
+* Rev 3: The bus lock can be put in front of another transport (simulated adapter)
+*/
+
+
+#pragma once
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "UNR_Transport.h"
+
+/*
+* Devices borrow the bus (see the UNR_I2CHandle bus constructor) and put their own address into every i2c_msg,
+* so no I2C_SLAVE address is pinned on the descriptor. transfer() holds the bus lock for exactly one kernel call;
+* a device that needs several calls back to back without another device in between takes the lock itself
+* through lock() / unlock() (or std::lock_guard, the bus is BasicLockable) and calls transferLocked().
+*
+* The bus must outlive every handle borrowing it.
+*/
+class UNR_I2CBus : public UNR_I2CTransport
+{
+private:
+	int m_intFile_descriptor;
+	unsigned long m_u4Functions;
+	std::mutex m_lock;
+	UNR_I2CTransport* m_adapter;	// borrowed adapter, nullptr when the bus owns its file descriptor
+
+public:
+	explicit UNR_I2CBus(unsigned char _instance) noexcept(false);
+	explicit UNR_I2CBus(const char _charFD[]) noexcept(false);
+	/*
+	* Shares a single threaded transport (UNR_SimTransport) between threads, every message goes to _adapter under the
+	* bus lock. _adapter must outlive the bus.
+	*/
+	explicit UNR_I2CBus(UNR_I2CTransport& _adapter) noexcept;
+	~UNR_I2CBus(void);
+	UNR_I2CBus() = delete;
+	UNR_I2CBus(const UNR_I2CBus&) = delete;
+	UNR_I2CBus& operator = (const UNR_I2CBus&) = delete;
+
+	/*
+	* One ioctl(I2C_RDWR) under the bus lock. Returns the number of messages transferred or -1.
+	*/
+	int transfer(struct i2c_msg* _msgs, unsigned int _count) noexcept override
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		return transferLocked(_msgs, _count);
+	}
+	int transferLocked(struct i2c_msg* _msgs, unsigned int _count) noexcept;
+
+	void lock(void) { m_lock.lock(); }
+	void unlock(void) { m_lock.unlock(); }
+	bool try_lock(void) { return m_lock.try_lock(); }
+
+	unsigned long functions(void) const noexcept override { return m_u4Functions; }
+};
@@ -21,6 +21,13 @@
 * Rev 2: Took the buffer dependency out of the system for write/read operations. 
 *		 Reading process for I2C did not yield good results for more than 70 odd bytes at a time. One can read in blocks of 50bytes at a time for now.
 * Rev 3: Reverting back on the I2C databuffers on write operation. Write does now work without the buffers.
+* Rev 4: Register read / write functions are virtual and a detached constructor is available so that simulated devices can stand in for the bus.
+* Rev 5: Transaction batches through ioctl(I2C_RDWR). Register reads use one combined transfer with a repeated START when the adapter supports it.
+* Rev 6: Handles can borrow a shared UNR_I2CBus and address every message instead of owning a file descriptor.
+* Rev 7: Chunked bulk register read / write of any length. Register writes longer than the internal buffer use it instead of overrunning it.
+* Rev 8: Handles borrow any UNR_I2CTransport (shared bus, simulated bus); the detached constructor is gone.
+* Rev 9: Bulk access falls back to chunked write() / read() on adapters without I2C_RDWR, register range checked.
+* Rev 10: Long register writes pass the auto increment mode on to the chunked write.
 */
 
 
@@ -67,7 +74,12 @@ UNR_I2CHandle::UNR_I2CHandle(unsigned char _instance,
 							unsigned char _dev_address,
 							unsigned short int _u1Mode) noexcept(false) : m_intFile_descriptor(0)
 												      , m_ucDecive_Address(_dev_address)
+												      , m_u4Functions(0)
+												      , m_segmentCount(0)
+												      , m_transport(nullptr)
+												      , m_chunkBytes(0)
 {
+	i2c_setChunkSize(UNR_I2C_DEFAULT_CHUNK_BYTES);
 	memset((void*)m_tempBuffer, 0x00, UNR_I2C_MAX_BYTES);
 
 	switch (_instance)
@@ -113,6 +125,27 @@ UNR_I2CHandle::UNR_I2CHandle(unsigned char _instance,
 	{
 		throw(e.what());
 	}
+	// Plain I2C functionality is required for I2C_RDWR, SMBus only adapters fall back to separate write / read calls
+	if (ioctl(m_intFile_descriptor, I2C_FUNCS, &m_u4Functions) == I2OCTRL_FAIL)
+		m_u4Functions = 0;
+#ifdef DEBUG
+	m_s4Return_in = 0;
+	m_s4Return_out = 0;
+#endif
+}
+
+/*
+* Transport constructor. Transports move addressed I2C_RDWR style messages, so every access below is one of those.
+*/
+UNR_I2CHandle::UNR_I2CHandle(UNR_I2CTransport& _transport, unsigned char _dev_address) noexcept : m_intFile_descriptor(0)
+																				, m_ucDecive_Address(_dev_address)
+																				, m_u4Functions(_transport.functions() | I2C_FUNC_I2C)
+																				, m_segmentCount(0)
+																				, m_transport(&_transport)
+																				, m_chunkBytes(0)
+{
+	i2c_setChunkSize(UNR_I2C_DEFAULT_CHUNK_BYTES);
+	memset((void*)m_tempBuffer, 0x00, UNR_I2C_MAX_BYTES);
 #ifdef DEBUG
 	m_s4Return_in = 0;
 	m_s4Return_out = 0;
@@ -121,17 +154,31 @@ UNR_I2CHandle::UNR_I2CHandle(unsigned char _instance,
 
 /*
 * Write function for traditional I2C protocol writes which are directed towards a particular register
-* Inputs are 1. Starting address of the buffer to write, 2. Register address to write, 3. Number of bytes to write
+* Inputs are 1. Starting address of the buffer to write, 2. Register address to write, 3. Number of bytes to write,
+* 4. false for data port registers (FIFO_R_W, MEM_R_W) whose pointer does not advance
 * Output: In debug mode, the errors will be thrown on screen with a return value of -1, 
 * in non debug mode,  returns -1 for failed write transactions and returns number of bytes for successful writes 
 */
-int UNR_I2CHandle::i2c_writeReg(unsigned char& _buffer, unsigned char& register_address, const unsigned short& numBytes) noexcept(false)
+int UNR_I2CHandle::i2c_writeReg(unsigned char& _buffer, unsigned char& register_address, const unsigned short& numBytes, bool _autoIncrement) noexcept(false)
 {
+	// longer writes do not fit the register address + data buffer, they go out in chunks each addressed on its own
+	if (numBytes + 1U > UNR_I2C_MAX_BYTES)
+		return i2c_writeBulk(&_buffer, register_address, numBytes, _autoIncrement);
+
 	// the write buffer needs to be preloaded with the register address.
 	memset((void *)m_tempBuffer, 0x00, UNR_I2C_MAX_BYTES);
 	m_tempBuffer[0] = register_address;
 	memcpy((void *)&m_tempBuffer[1], (const void*)&_buffer, numBytes);
-	
+
+	if (m_transport != nullptr)
+	{
+		struct i2c_msg msg;
+		msg.addr = m_ucDecive_Address;
+		msg.flags = 0;
+		msg.len = (unsigned short)(numBytes + 1U);
+		msg.buf = m_tempBuffer;
+		return i2c_transfer(&msg, 1U) < 0 ? -1 : numBytes;
+	}
 #ifdef DEBUG
 	m_s4Return_in = write(m_intFile_descriptor, (void*)(&m_tempBuffer), static_cast<size_t>(numBytes+1));
 	if (m_s4Return_in < 0)
@@ -157,6 +204,20 @@ int UNR_I2CHandle::i2c_writeReg(unsigned char& _buffer, unsigned char& register_
 */
 int UNR_I2CHandle::i2c_readReg(unsigned char& buffer, unsigned char& register_address, const unsigned short& numBytes) noexcept(false) 
 {
+	if (m_u4Functions & I2C_FUNC_I2C)
+	{
+		// register pointer write and data read in one kernel call, repeated START instead of STOP in between
+		struct i2c_msg msgs[2];
+		msgs[0].addr = m_ucDecive_Address;
+		msgs[0].flags = 0;
+		msgs[0].len = 1U;
+		msgs[0].buf = &register_address;
+		msgs[1].addr = m_ucDecive_Address;
+		msgs[1].flags = I2C_M_RD;
+		msgs[1].len = numBytes;
+		msgs[1].buf = &buffer;
+		return i2c_transfer(msgs, 2U) < 0 ? -1 : numBytes;
+	}
 #ifdef DEBUG
 	m_s4Return_in = write(m_intFile_descriptor, (const void*)&register_address, 1U);
 	if (m_s4Return_in < 0)
@@ -167,8 +228,6 @@ int UNR_I2CHandle::i2c_readReg(unsigned char& buffer, unsigned char& register_ad
 		if (ec != ok) puts(ec.message().c_str());
 		throw std::runtime_error(std::string("I2C Could not handle write Operation"));
 	}
-	return m_s4Return_in;
-	m_s4Return_in = write(m_intFile_descriptor, (const void*)&register_address, 1U);  // this line needs to be here so that the debug process can happen on this read function
 	m_s4Return_in = read(m_intFile_descriptor, (void*)(&buffer), static_cast<size_t>(numBytes));
 	if (m_s4Return_in < 0)
 	{
@@ -192,6 +251,201 @@ int UNR_I2CHandle::i2c_readReg(unsigned char& buffer, unsigned char& register_ad
 #endif
 }
 
+/*
+* Submits _count messages in one ioctl(I2C_RDWR) call.
+* Output: number of messages transferred, or -1 on failure (in debug mode the error is printed and an exception thrown)
+*/
+int UNR_I2CHandle::i2c_transfer(struct i2c_msg* _msgs, unsigned int _count) noexcept(false)
+{
+	struct i2c_rdwr_ioctl_data data;
+	data.msgs = _msgs;
+	data.nmsgs = _count;
+#ifdef DEBUG
+	m_s4Return_in = (m_transport != nullptr) ? m_transport->transfer(_msgs, _count) : ioctl(m_intFile_descriptor, I2C_RDWR, &data);
+	if (m_s4Return_in < 0)
+	{
+		std::error_code ec(errno, std::generic_category());
+		std::error_condition ok;
+		std::string msg = ec.message();
+		if (ec != ok) puts(ec.message().c_str());
+		throw std::runtime_error(std::string("I2C Could not handle Combined Transfer"));
+	}
+	return m_s4Return_in;
+#else
+	return (m_transport != nullptr) ? m_transport->transfer(_msgs, _count) : ioctl(m_intFile_descriptor, I2C_RDWR, &data);
+#endif
+}
+
+void UNR_I2CHandle::i2c_setChunkSize(unsigned short _chunkBytes)
+{
+	if (_chunkBytes == 0) _chunkBytes = 1U;
+	m_chunkBytes = _chunkBytes;
+	m_bulkStaging.resize(UNR_I2C_MAX_SEGMENTS * ((size_t)_chunkBytes + 1U));
+}
+
+/*
+* Chunked register read. With auto increment every chunk is a (register pointer write, read) pair, so a failed or
+* split call never leaves the device pointer somewhere unexpected. Without it the pointer is written once per call
+* and followed by plain reads.
+* Adapters without plain I2C (SMBus only, see I2C_FUNCS) get one write() of the register pointer and one read() per chunk.
+*/
+int UNR_I2CHandle::i2c_readBulk(unsigned char* buffer, unsigned char register_address, unsigned int numBytes, bool _autoIncrement) noexcept(false)
+{
+	struct i2c_msg msgs[UNR_I2C_MAX_SEGMENTS];
+	unsigned char registers[UNR_I2C_MAX_SEGMENTS];
+	unsigned int done = 0, count, queued, length;
+
+	// the register pointer is 8 bits, an auto incremented access past 0xFF would wrap around to register 0
+	if (_autoIncrement && register_address + numBytes > 0x100U) return -1;
+
+	if (!(m_u4Functions & I2C_FUNC_I2C))
+	{
+		while (done < numBytes)
+		{
+			length = (numBytes - done > m_chunkBytes) ? m_chunkBytes : numBytes - done;
+			registers[0] = _autoIncrement ? (unsigned char)(register_address + done) : register_address;
+			if (write(m_intFile_descriptor, (const void*)&registers[0], 1U) != 1) return -1;
+			if (read(m_intFile_descriptor, (void*)&buffer[done], static_cast<size_t>(length)) != (ssize_t)length) return -1;
+			done += length;
+		}
+		return (int)numBytes;
+	}
+
+	while (done < numBytes)
+	{
+		count = 0;
+		queued = done;
+		if (!_autoIncrement)
+		{
+			registers[0] = register_address;
+			msgs[count++] = { m_ucDecive_Address, 0, 1U, &registers[0] };
+		}
+		while (queued < numBytes && count + (_autoIncrement ? 2U : 1U) <= UNR_I2C_MAX_SEGMENTS)
+		{
+			length = (numBytes - queued > m_chunkBytes) ? m_chunkBytes : numBytes - queued;
+			if (_autoIncrement)
+			{
+				registers[count] = (unsigned char)(register_address + queued);
+				msgs[count] = { m_ucDecive_Address, 0, 1U, &registers[count] };
+				count++;
+			}
+			msgs[count++] = { m_ucDecive_Address, I2C_M_RD, (unsigned short)length, &buffer[queued] };
+			queued += length;
+		}
+		if (i2c_transfer(msgs, count) < 0) return -1;
+		done = queued;
+	}
+	return (int)numBytes;
+}
+
+/*
+* Chunked register write. Every message carries its own register byte, the data is staged behind it.
+* Adapters without plain I2C (SMBus only, see I2C_FUNCS) get one write() per chunk.
+*/
+int UNR_I2CHandle::i2c_writeBulk(const unsigned char* buffer, unsigned char register_address, unsigned int numBytes, bool _autoIncrement) noexcept(false)
+{
+	struct i2c_msg msgs[UNR_I2C_MAX_SEGMENTS];
+	unsigned char* staging;
+	unsigned int done = 0, count, length;
+
+	if (_autoIncrement && register_address + numBytes > 0x100U) return -1;
+
+	if (!(m_u4Functions & I2C_FUNC_I2C))
+	{
+		staging = m_bulkStaging.data();
+		while (done < numBytes)
+		{
+			length = (numBytes - done > m_chunkBytes) ? m_chunkBytes : numBytes - done;
+			staging[0] = _autoIncrement ? (unsigned char)(register_address + done) : register_address;
+			memcpy(&staging[1], &buffer[done], length);
+			if (write(m_intFile_descriptor, (const void*)staging, static_cast<size_t>(length + 1U)) != (ssize_t)(length + 1U)) return -1;
+			done += length;
+		}
+		return (int)numBytes;
+	}
+
+	while (done < numBytes)
+	{
+		count = 0;
+		staging = m_bulkStaging.data();
+		while (done < numBytes && count < UNR_I2C_MAX_SEGMENTS)
+		{
+			length = (numBytes - done > m_chunkBytes) ? m_chunkBytes : numBytes - done;
+			staging[0] = _autoIncrement ? (unsigned char)(register_address + done) : register_address;
+			memcpy(&staging[1], &buffer[done], length);
+			msgs[count++] = { m_ucDecive_Address, 0, (unsigned short)(length + 1U), staging };
+			staging += length + 1U;
+			done += length;
+		}
+		if (i2c_transfer(msgs, count) < 0) return -1;
+	}
+	return (int)numBytes;
+}
+
+/*
+* Queue a write segment. Returns the segment index, or -1 if UNR_I2C_MAX_SEGMENTS segments are already queued.
+*/
+int UNR_I2CHandle::i2c_queueWrite(unsigned char& buffer, const unsigned short& numBytes) noexcept
+{
+	if (m_segmentCount >= UNR_I2C_MAX_SEGMENTS) return -1;
+	m_segments[m_segmentCount].addr = m_ucDecive_Address;
+	m_segments[m_segmentCount].flags = 0;
+	m_segments[m_segmentCount].len = numBytes;
+	m_segments[m_segmentCount].buf = &buffer;
+	m_segmentResults[m_segmentCount] = 0;
+	return (int)(m_segmentCount++);
+}
+
+/*
+* Queue a read segment. Returns the segment index, or -1 if UNR_I2C_MAX_SEGMENTS segments are already queued.
+*/
+int UNR_I2CHandle::i2c_queueRead(unsigned char& buffer, const unsigned short& numBytes) noexcept
+{
+	if (m_segmentCount >= UNR_I2C_MAX_SEGMENTS) return -1;
+	m_segments[m_segmentCount].addr = m_ucDecive_Address;
+	m_segments[m_segmentCount].flags = I2C_M_RD;
+	m_segments[m_segmentCount].len = numBytes;
+	m_segments[m_segmentCount].buf = &buffer;
+	m_segmentResults[m_segmentCount] = 0;
+	return (int)(m_segmentCount++);
+}
+
+/*
+* Queue a register read (register pointer write followed by a read). Returns the index of the read segment, or -1 if there is no room for both.
+*/
+int UNR_I2CHandle::i2c_queueReadReg(unsigned char& buffer, unsigned char& register_address, const unsigned short& numBytes) noexcept
+{
+	if (m_segmentCount + 2U > UNR_I2C_MAX_SEGMENTS) return -1;
+	i2c_queueWrite(register_address, 1U);
+	return i2c_queueRead(buffer, numBytes);
+}
+
+/*
+* Submit every queued segment in one kernel crossing and empty the queue.
+* The kernel completes a batch as a whole, so each segment result is either its byte count or -1.
+* Output: number of segments transferred, or -1 on failure
+*/
+int UNR_I2CHandle::i2c_submit(void) noexcept(false)
+{
+	int _s4Return;
+	unsigned int count = m_segmentCount;
+
+	if (count == 0) return 0;
+	m_segmentCount = 0;
+	_s4Return = i2c_transfer(m_segments, count);
+	for (unsigned int i = 0; i < count; i++)
+		m_segmentResults[i] = (_s4Return < 0) ? -1 : (int)m_segments[i].len;
+	return (_s4Return < 0) ? -1 : (int)count;
+}
+
+/*
+* Result of a segment of the last submitted batch: number of bytes transferred, -1 on failure, 0 if not submitted yet
+*/
+int UNR_I2CHandle::i2c_segmentResult(unsigned int _segment) const noexcept
+{
+	return (_segment < UNR_I2C_MAX_SEGMENTS) ? m_segmentResults[_segment] : -1;
+}
+
 /*
 * ****** IMP ******** Not Sure this will work for I2C ics which have specific register read / writes. Can be used for DIGI pots I guess
 * This function is a simple write function to write to slave devices which does not have specific registers to write.
@@ -200,6 +454,11 @@ int UNR_I2CHandle::i2c_readReg(unsigned char& buffer, unsigned char& register_ad
 */
 int UNR_I2CHandle::i2c_write_simple(unsigned char& _buffer, const unsigned short& numBytes) noexcept(false)
 {
+	if (m_transport != nullptr)
+	{
+		struct i2c_msg msg = { m_ucDecive_Address, 0, numBytes, &_buffer };
+		return i2c_transfer(&msg, 1U) < 0 ? -1 : numBytes;
+	}
 #ifdef DEBUG
 	m_s4Return_out = write(m_intFile_descriptor, (void*)(&_buffer), static_cast<size_t>(numBytes));
 	if (m_s4Return_out < 0)
@@ -225,6 +484,11 @@ int UNR_I2CHandle::i2c_write_simple(unsigned char& _buffer, const unsigned short
 */
 int UNR_I2CHandle::i2c_read_simple(unsigned char& buffer, const unsigned short& numBytes) noexcept(false)
 {
+	if (m_transport != nullptr)
+	{
+		struct i2c_msg msg = { m_ucDecive_Address, I2C_M_RD, numBytes, &buffer };
+		return i2c_transfer(&msg, 1U) < 0 ? -1 : numBytes;
+	}
 #ifdef DEBUG
 
 	m_s4Return_in = read(m_intFile_descriptor, (void*)(&buffer), static_cast<size_t>(numBytes));
@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <linux/i2c-dev.h>
+#include <linux/i2c.h>
 #include <exception>
 #include <sys/ioctl.h>
 #include <fcntl.h>
@@ -12,6 +13,8 @@
 #include <inttypes.h>
 #include <cerrno>         // errno
 #include <system_error>   // std::error_code, std::generic_category
+#include <vector>
+#include "UNR_Transport.h"
 // std::error_condition
 //# define DEBUG 1 // use only when debugging on screen
 
@@ -22,11 +25,21 @@ constexpr char RPI4_I2C_DEV_INSTANCE1[] = "/dev/i2c-1";
 constexpr signed int I2OCTRL_FAIL = -1;
 constexpr unsigned int UNR_I2C_MAX_BYTES = 16U;
 
+constexpr unsigned int UNR_I2C_MAX_SEGMENTS = I2C_RDWR_IOCTL_MAX_MSGS;  // kernel limit of messages per I2C_RDWR call
+constexpr unsigned short UNR_I2C_DEFAULT_CHUNK_BYTES = 32U;  // bulk transfer chunk, well below the ~70 byte reads that failed on the BCM2711 adapter
+
 class UNR_I2CHandle {
 private:
 	int m_intFile_descriptor;
 	unsigned char m_ucDecive_Address;
 	unsigned char m_tempBuffer[UNR_I2C_MAX_BYTES];
+	unsigned long m_u4Functions;
+	struct i2c_msg m_segments[UNR_I2C_MAX_SEGMENTS];
+	int m_segmentResults[UNR_I2C_MAX_SEGMENTS];
+	unsigned int m_segmentCount;
+	UNR_I2CTransport* m_transport;	// shared bus or simulated transport when borrowed, nullptr when this handle owns its file descriptor
+	unsigned short m_chunkBytes;
+	std::vector<unsigned char> m_bulkStaging;	// register byte + chunk for every write message of one I2C_RDWR call
 	void init_file_descriptor(const char _charFD[]) noexcept(false);
 	void set_device_mode(unsigned int _u1Mode) const noexcept(false);
 	
@@ -36,6 +49,11 @@ private:
 #endif
 public:
 	UNR_I2CHandle(unsigned char _instance, unsigned char _dev_address, unsigned short int _u1Mode) noexcept(false);
+	/*
+	* Device on a transport (UNR_I2CBus, UNR_SimTransport): no file descriptor of its own, every message carries
+	* _dev_address. A handle is used from one thread at a time, a UNR_I2CBus may be shared by any number of threads.
+	*/
+	UNR_I2CHandle(UNR_I2CTransport& _transport, unsigned char _dev_address) noexcept;
 	~UNR_I2CHandle();
 	UNR_I2CHandle() = delete;
 	UNR_I2CHandle(const UNR_I2CHandle&) = delete;
@@ -44,9 +62,47 @@ public:
 //protected:
 	int i2c_write_simple(unsigned char& _buffer, const unsigned short& numByte) noexcept(false);
 	int i2c_read_simple(unsigned char& buffer, const unsigned short& numBytes) noexcept(false);
-	int i2c_writeReg(unsigned char& buffer, unsigned char& register_address  , const unsigned short& numBytes) noexcept(false);
+	/*
+	* Writes longer than UNR_I2C_MAX_BYTES - 1 are split like i2c_writeBulk(). _autoIncrement false keeps every chunk
+	* on register_address (data ports such as FIFO_R_W and MEM_R_W), otherwise chunk n goes to register_address + offset.
+	*/
+	int i2c_writeReg(unsigned char& buffer, unsigned char& register_address  , const unsigned short& numBytes, bool _autoIncrement = true) noexcept(false);
 	int i2c_readReg(unsigned char& buffer, unsigned char& register_address  , const unsigned short& numBytes) noexcept(false);
 
+	/*
+	* Transaction batches. Segments are queued and submitted to the kernel in a single ioctl(I2C_RDWR) with a repeated START
+	* between segments and one STOP at the end. Buffers (and register addresses) must stay valid until i2c_submit() returns.
+	*/
+	int i2c_queueWrite(unsigned char& buffer, const unsigned short& numBytes) noexcept;
+	int i2c_queueRead(unsigned char& buffer, const unsigned short& numBytes) noexcept;
+	int i2c_queueReadReg(unsigned char& buffer, unsigned char& register_address, const unsigned short& numBytes) noexcept;
+	int i2c_submit(void) noexcept(false);
+	int i2c_segmentResult(unsigned int _segment) const noexcept;
+	void i2c_clearQueue(void) noexcept { m_segmentCount = 0; }
+	unsigned int i2c_queuedSegments(void) const noexcept { return m_segmentCount; }
+
+	/*
+	* Bulk register access of any length. The data is split into chunks of i2c_chunkSize() bytes and the chunks are
+	* sent as consecutive messages, UNR_I2C_MAX_SEGMENTS per I2C_RDWR call. Adapters without I2C_FUNC_I2C (SMBus only)
+	* fall back to one write() (and read()) per chunk.
+	* _autoIncrement: the register pointer advances with every byte, each chunk is addressed at register_address + offset.
+	* Without it (FIFO data registers) every chunk targets register_address.
+	* Output: number of bytes transferred, or -1 on failure or when an auto incremented access runs past register 0xFF
+	*/
+	int i2c_readBulk(unsigned char* buffer, unsigned char register_address, unsigned int numBytes, bool _autoIncrement = true) noexcept(false);
+	int i2c_writeBulk(const unsigned char* buffer, unsigned char register_address, unsigned int numBytes, bool _autoIncrement = true) noexcept(false);
+	/*
+	* Largest data length of a single message. Adapters with a known safe size can raise it, the default is UNR_I2C_DEFAULT_CHUNK_BYTES.
+	*/
+	void i2c_setChunkSize(unsigned short _chunkBytes);
+	unsigned short i2c_chunkSize(void) const noexcept { return m_chunkBytes; }
+	unsigned char i2c_address(void) const noexcept { return m_ucDecive_Address; }
+
+	/*
+	* Raw combined transfer used by the batch and register read functions.
+	*/
+	int i2c_transfer(struct i2c_msg* _msgs, unsigned int _count) noexcept(false);
+
 };
 
 //#endif // UNR_BCM2711_I2CHANDLE_H_
@@ -0,0 +1,71 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Shared SPI bus for several devices with their own mode / word size / clock
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Lazily opened chip selects, per transfer clock and word size
+*/
+
+#include "UNR_BCM2711_SPIBus.h"
+
+
+	UNR_SPIBus::UNR_SPIBus(unsigned int _u4Bus) noexcept(false) : m_bus(_u4Bus)
+	{
+		if (_u4Bus >= UNR_SPI_BUS_COUNT)
+		{
+			throw std::runtime_error(std::string("SPI bus out of range"));
+		}
+		for (unsigned int i = 0; i < UNR_SPI_CHIP_SELECTS; i++)
+			m_handles[i] = nullptr;
+	}
+
+	UNR_SPIHandle& UNR_SPIBus::select(const UNR_SPIDeviceConfig& _device) noexcept(false)
+	{
+		UNR_SPIHandle* handle;
+		if (_device.chipSelect >= UNR_SPI_CHIP_SELECTS)
+		{
+			throw std::runtime_error(std::string("SPI chip select out of range"));
+		}
+
+		handle = m_handles[_device.chipSelect];
+		if (handle == nullptr)
+		{
+			handle = new UNR_SPIHandle(m_bus, _device.chipSelect, _device.mode, _device.bits, _device.speedHz);
+			m_handles[_device.chipSelect] = handle;
+		}
+		else
+		{
+			// word size and clock are overridden per transfer, keeping the defaults avoids two ioctls per switch
+			handle->spi_configure(_device.mode, handle->spi_bits(), handle->spi_frequency());
+		}
+		return *handle;
+	}
+
+	int UNR_SPIBus::transfer(const UNR_SPIDeviceConfig& _device, const unsigned char* _tx, unsigned char* _rx, unsigned int _u4Size) noexcept(false)
+	{
+		UNR_SPIHandle& handle = select(_device);
+		handle.spi_clearQueue();
+		handle.spi_queueTransfer(_tx, _rx, _u4Size, _device.speedHz, 0, false, _device.bits);
+		return handle.spi_submit();
+	}
+
+	UNR_SPIBus::~UNR_SPIBus(void)
+	{
+		for (unsigned int i = 0; i < UNR_SPI_CHIP_SELECTS; i++)
+		{
+			delete m_handles[i];
+			m_handles[i] = nullptr;
+		}
+	}
@@ -0,0 +1,64 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Shared SPI bus for several devices with their own mode / word size / clock
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Lazily opened chip selects, per transfer clock and word size
+*/
+
+
+#pragma once
+#include "UNR_BCM2711_SPIHandle.h"
+
+	struct UNR_SPIDeviceConfig
+	{
+		unsigned int chipSelect;
+		unsigned char mode;			// SPI_MODE_0 .. SPI_MODE_3 plus SPI_CS_HIGH / SPI_LSB_FIRST ...
+		unsigned char bits;			// bits per word
+		unsigned int speedHz;
+	};
+
+	/*
+	* One object per bus. Each chip select is opened the first time a device on it is used and kept open.
+	* Clock and word size travel in the spi_ioc_transfer of every transfer, so devices with different clocks can
+	* share one chip select without any ioctl on a switch. Only the mode is a device setting; it is written when
+	* it differs from what the chip select was last set to.
+	*/
+	class UNR_SPIBus
+	{
+	private:
+		unsigned int m_bus;
+		UNR_SPIHandle* m_handles[UNR_SPI_CHIP_SELECTS];
+
+	public:
+		explicit UNR_SPIBus(unsigned int _u4Bus) noexcept(false);
+		~UNR_SPIBus(void);
+		UNR_SPIBus() = delete;
+		UNR_SPIBus(const UNR_SPIBus&) = delete;
+		UNR_SPIBus & operator = (const UNR_SPIBus&) = delete;
+
+		/*
+		* Handle of the device's chip select with the device's mode applied, for batches and streams.
+		* Transfers queued on it should pass _device.speedHz and _device.bits per segment.
+		*/
+		UNR_SPIHandle& select(const UNR_SPIDeviceConfig& _device) noexcept(false);
+
+		/*
+		* One full duplex transfer for _device, returns the number of bytes transferred
+		*/
+		int transfer(const UNR_SPIDeviceConfig& _device, const unsigned char* _tx, unsigned char* _rx, unsigned int _u4Size) noexcept(false);
+
+		unsigned int bus(void) const noexcept { return m_bus; }
+	};
@@ -16,9 +16,16 @@
 *					Make sure the /dev/spidev0.X (X=0 or 1) file is present in the system 
 * Unauthorized Distrubution is strictly prohibited.
 * Rev 1: First revision. Seems to run without bugs. Will do more testing 
+* Rev 2: Full duplex transaction batches through ioctl(SPI_IOC_MESSAGE(n))
+* Rev 3: Streaming of arbitrary lengths in spidev bufsiz chunks
+* Rev 4: Any /dev/spidevB.C, settings cached so unchanged values are not written again
+* Rev 5: UNR_SPITransport implementation
+* Rev 6: Handles can borrow a UNR_SPITransport (simulated bus) instead of owning a file descriptor
+* Rev 7: Per stream speed and word size overrides in spi_stream
 */
 
 #include "UNR_BCM2711_SPIHandle.h"
+#include <cstdio>
 
 
 	void UNR_SPIHandle::init_file_descriptor(const char _charFD[]) noexcept(false)
@@ -30,50 +37,83 @@
 		}
 	}
 
+	/*
+	* The SPI_IOC_RD_* requests read the setting back into the argument, only the SPI_IOC_WR_* requests are needed to apply it
+	*/
 	void UNR_SPIHandle::set_spi_mode(const unsigned char &_u1MODE) noexcept(false)
 	{
-		if ((ioctl(m_intFile_descriptor, SPI_IOC_WR_MODE, &_u1MODE)) == OV_IOCTRL_FAIL)
+		if (m_configured && _u1MODE == m_mode) return;
+		if (m_transport == nullptr && (ioctl(m_intFile_descriptor, SPI_IOC_WR_MODE, &_u1MODE)) == UNR_IOCTRL_FAIL)
 		{
 			throw std::runtime_error(std::string("Error Setting SPI Write Mode"));
 		}
-
-		if ((ioctl(m_intFile_descriptor, SPI_IOC_RD_MODE, &_u1MODE)) == OV_IOCTRL_FAIL)
-		{
-			throw std::runtime_error(std::string("Error Setting SPI Read Mode"));
-		}
+		m_mode = _u1MODE;
 	}
 
 	void UNR_SPIHandle::set_spi_databits(const unsigned char &_u1BITS) noexcept(false)
 	{
-		if ((ioctl(m_intFile_descriptor, SPI_IOC_WR_BITS_PER_WORD, &_u1BITS)) == OV_IOCTRL_FAIL)
+		if (m_configured && _u1BITS == m_bits) return;
+		if (m_transport == nullptr && (ioctl(m_intFile_descriptor, SPI_IOC_WR_BITS_PER_WORD, &_u1BITS)) == UNR_IOCTRL_FAIL)
 		{
 			throw std::runtime_error(std::string("Error in setting Write Bits per word"));
 		}
+		m_bits = _u1BITS;
+	}
 
-		if ((ioctl(m_intFile_descriptor, SPI_IOC_RD_BITS_PER_WORD, &_u1BITS)) == OV_IOCTRL_FAIL)
+	void UNR_SPIHandle::set_spi_frequency(const unsigned int &_u4FREQ) noexcept(false)
+	{
+		if (m_configured && _u4FREQ == m_spifrequency) return;
+		if (m_transport == nullptr && (ioctl(m_intFile_descriptor, SPI_IOC_WR_MAX_SPEED_HZ, &_u4FREQ)) == UNR_IOCTRL_FAIL)
 		{
-			throw std::runtime_error(std::string("Error in setting Read Bits per word"));
+			throw std::runtime_error(std::string("Error Setting Write Speed"));
 		}
+		m_spifrequency = _u4FREQ;
 	}
 
-	void UNR_SPIHandle::set_spi_frequency(const unsigned int &_u4FREQ) noexcept(false)
+	void UNR_SPIHandle::spi_configure(unsigned char _u1Mode, unsigned char _u1Bits, unsigned int _u4Freq) noexcept(false)
 	{
+		set_spi_mode(_u1Mode);
+		set_spi_databits(_u1Bits);
+		set_spi_frequency(_u4Freq);
+		m_configured = true;
+	}
 
-		if ((ioctl(m_intFile_descriptor, SPI_IOC_WR_MAX_SPEED_HZ, &_u4FREQ)) == OV_IOCTRL_FAIL)
+	/*
+	* Settings applied once at construction. The kernel keeps them per chip select, so they are written unconditionally here.
+	*/
+	void UNR_SPIHandle::init_settings(unsigned char _u1Mode, unsigned char _u1Bits, unsigned int _u4Freq) noexcept(false)
+	{
+		m_configured = false;
+		try {
+			spi_configure(_u1Mode, _u1Bits, _u4Freq);
+		}
+		catch (std::exception& e)
 		{
-			throw std::runtime_error(std::string("Error Setting Write Speed"));
+			close(m_intFile_descriptor);
+			throw std::runtime_error(e.what());
 		}
+		m_s4Return_in = 0;
+		m_s4Return_out = 0;
+	}
 
-		if ((ioctl(m_intFile_descriptor, SPI_IOC_RD_MAX_SPEED_HZ, &_u4FREQ)) == OV_IOCTRL_FAIL)
+	/*Funct: read_bufsiz returns the spidev per message limit, the module default if the parameter can not be read*/
+	unsigned int UNR_SPIHandle::read_bufsiz(void) noexcept
+	{
+		unsigned int bufsiz = 0;
+		FILE* parameter = fopen(UNR_SPI_BUFSIZ_PARAMETER, "r");
+		if (parameter != nullptr)
 		{
-			throw std::runtime_error(std::string("Error Setting Read Speed"));
+			if (fscanf(parameter, "%u", &bufsiz) != 1) bufsiz = 0;
+			fclose(parameter);
 		}
+		return bufsiz ? bufsiz : UNR_SPI_DEFAULT_BUFSIZ;
 	}
 
 	UNR_SPIHandle::UNR_SPIHandle(unsigned int _u4SPI_instance,
 		unsigned char _u1Mode,
 		unsigned char _u1Bits,
-		unsigned int _u4Freq) noexcept(false) : m_intFile_descriptor(0) , m_spifrequency(0)
+		unsigned int _u4Freq) noexcept(false) : m_intFile_descriptor(0) , m_spifrequency(0) , m_mode(0) , m_bits(0) , m_configured(false)
+		, m_segmentCount(0) , m_bufsiz(read_bufsiz()) , m_transport(nullptr)
 	{
 		switch (_u4SPI_instance)
 		{
@@ -101,42 +141,58 @@
 			break;
 		}
 		default:
-			break;
+			throw std::runtime_error(std::string("Unknown SPI instance, use the bus / chip select constructor"));
 		}
 
-		try {
-			set_spi_mode(_u1Mode);
-		}
-		catch (std::exception& e)
-		{
-			throw std::runtime_error(e.what());
-		}
+		init_settings(_u1Mode, _u1Bits, _u4Freq);
+	}
 
-		try {
-			set_spi_databits(_u1Bits);
-		}
-		catch (std::exception& e)
+	UNR_SPIHandle::UNR_SPIHandle(unsigned int _u4Bus,
+		unsigned int _u4ChipSelect,
+		unsigned char _u1Mode,
+		unsigned char _u1Bits,
+		unsigned int _u4Freq) noexcept(false) : m_intFile_descriptor(0) , m_spifrequency(0) , m_mode(0) , m_bits(0) , m_configured(false)
+		, m_segmentCount(0) , m_bufsiz(read_bufsiz()) , m_transport(nullptr)
+	{
+		char device[32];
+		if (_u4Bus >= UNR_SPI_BUS_COUNT || _u4ChipSelect >= UNR_SPI_CHIP_SELECTS)
 		{
-			throw std::runtime_error(e.what());
+			throw std::runtime_error(std::string("SPI bus or chip select out of range"));
 		}
+		snprintf(device, sizeof(device), "/dev/spidev%u.%u", _u4Bus, _u4ChipSelect);
+		init_file_descriptor(device);
+		init_settings(_u1Mode, _u1Bits, _u4Freq);
+	}
 
-		try {
-			set_spi_frequency(_u4Freq);
-			m_spifrequency = _u4Freq;
-		}
-		catch (std::exception& e)
-		{
-			throw std::runtime_error(e.what());
-		}
-		m_s4Return_in = 0;
-		m_s4Return_out = 0;
+	/*
+	* Transport constructor. Transports only move spi_ioc_transfer messages, so spi_write() / spi_read() become
+	* single segment messages and the spidev per message limit is kept for spi_stream().
+	*/
+	UNR_SPIHandle::UNR_SPIHandle(UNR_SPITransport& _transport,
+		unsigned char _u1Mode,
+		unsigned char _u1Bits,
+		unsigned int _u4Freq) noexcept : m_intFile_descriptor(-1) , m_spifrequency(_u4Freq) , m_mode(_u1Mode) , m_bits(_u1Bits)
+		, m_configured(true) , m_segmentCount(0) , m_bufsiz(UNR_SPI_DEFAULT_BUFSIZ) , m_s4Return_in(0) , m_s4Return_out(0)
+		, m_transport(&_transport)
+	{
 	}
 
 	/*Funct: spi_write returns write number or -1 for error*/
 	int UNR_SPIHandle::spi_write(const unsigned char &_u1TX, const unsigned int &_u4Size) noexcept(false)
 	{
-		m_s4Return_in = write(m_intFile_descriptor, (void*)(&_u1TX), _u4Size);
-		if (m_s4Return_in == OV_IOCTRL_FAIL)
+		struct spi_ioc_transfer segment;
+		if (m_transport != nullptr)
+		{
+			memset(&segment, 0, sizeof(segment));
+			segment.tx_buf = (unsigned long)&_u1TX;
+			segment.len = _u4Size;
+			m_s4Return_in = m_transport->transfer(&segment, 1U);
+		}
+		else
+		{
+			m_s4Return_in = write(m_intFile_descriptor, (void*)(&_u1TX), _u4Size);
+		}
+		if (m_s4Return_in == UNR_IOCTRL_FAIL)
 		{
 			std::error_code ec(errno, std::generic_category());
 			std::error_condition ok;
@@ -150,8 +206,19 @@
 	/*Funct: spi_read returns read number or -1 for error*/
 	int UNR_SPIHandle::spi_read(unsigned char &_u1RX, const unsigned int &_u4Size) noexcept(false)
 	{
-		m_s4Return_out = read(m_intFile_descriptor, (void*)(&_u1RX), _u4Size);
-		if (m_s4Return_out == OV_IOCTRL_FAIL)
+		struct spi_ioc_transfer segment;
+		if (m_transport != nullptr)
+		{
+			memset(&segment, 0, sizeof(segment));
+			segment.rx_buf = (unsigned long)&_u1RX;
+			segment.len = _u4Size;
+			m_s4Return_out = m_transport->transfer(&segment, 1U);
+		}
+		else
+		{
+			m_s4Return_out = read(m_intFile_descriptor, (void*)(&_u1RX), _u4Size);
+		}
+		if (m_s4Return_out == UNR_IOCTRL_FAIL)
 		{
 			std::error_code ec(errno, std::generic_category());
 			std::error_condition ok;
@@ -162,9 +229,91 @@
 		return m_s4Return_out;
 	}
 
+	/*Funct: spi_queueTransfer returns the segment index or -1 when the queue is full*/
+	int UNR_SPIHandle::spi_queueTransfer(const unsigned char* _tx, unsigned char* _rx, unsigned int _u4Size,
+		unsigned int _speedHz, unsigned short _delayUsecs, bool _csChange, unsigned char _bitsPerWord) noexcept
+	{
+		struct spi_ioc_transfer* segment;
+		if (m_segmentCount >= UNR_SPI_MAX_SEGMENTS) return UNR_IOCTRL_FAIL;
+
+		segment = &m_segments[m_segmentCount];
+		memset(segment, 0, sizeof(*segment));
+		segment->tx_buf = (unsigned long)_tx;
+		segment->rx_buf = (unsigned long)_rx;
+		segment->len = _u4Size;
+		segment->speed_hz = _speedHz;
+		segment->delay_usecs = _delayUsecs;
+		segment->cs_change = _csChange ? 1 : 0;
+		segment->bits_per_word = _bitsPerWord;
+		return (int)(m_segmentCount++);
+	}
+
+	/*Funct: spi_submit returns the number of bytes transferred. The queue is empty afterwards, also on error*/
+	int UNR_SPIHandle::spi_submit(void) noexcept(false)
+	{
+		unsigned int count = m_segmentCount;
+		if (count == 0) return 0;
+		m_segmentCount = 0;
+
+		m_s4Return_in = transfer(m_segments, count);
+		if (m_s4Return_in == UNR_IOCTRL_FAIL)
+		{
+			std::error_code ec(errno, std::generic_category());
+			std::error_condition ok;
+			if (ec != ok) puts(ec.message().c_str());
+			throw std::runtime_error(std::string("SPI Message Transfer Error"));
+		}
+		return m_s4Return_in;
+	}
+
+	int UNR_SPIHandle::transfer(struct spi_ioc_transfer* _segments, unsigned int _count) noexcept
+	{
+		if (m_transport != nullptr) return m_transport->transfer(_segments, _count);
+		// SPI_IOC_MESSAGE(N) needs a constant N, the request code is built from SPI_MSGSIZE for a run time count
+		return ioctl(m_intFile_descriptor, _IOC(_IOC_WRITE, SPI_IOC_MAGIC, 0, SPI_MSGSIZE(_count)), _segments);
+	}
+
+	/*Funct: spi_transfer returns transferred number of bytes, single full duplex segment*/
+	int UNR_SPIHandle::spi_transfer(const unsigned char* _tx, unsigned char* _rx, unsigned int _u4Size) noexcept(false)
+	{
+		spi_clearQueue();
+		spi_queueTransfer(_tx, _rx, _u4Size);
+		return spi_submit();
+	}
+
+	/*Funct: spi_stream returns transferred number of bytes*/
+	long UNR_SPIHandle::spi_stream(const unsigned char* _tx, unsigned char* _rx, unsigned long _size,
+		unsigned int _speedHz, unsigned char _bitsPerWord) noexcept(false)
+	{
+		struct spi_ioc_transfer chunk;
+		unsigned long done = 0;
+		unsigned int length;
+
+		while (done < _size)
+		{
+			length = (_size - done > m_bufsiz) ? m_bufsiz : (unsigned int)(_size - done);
+			memset(&chunk, 0, sizeof(chunk));
+			chunk.tx_buf = _tx ? (unsigned long)(_tx + done) : 0;
+			chunk.rx_buf = _rx ? (unsigned long)(_rx + done) : 0;
+			chunk.len = length;
+			chunk.speed_hz = _speedHz;
+			chunk.bits_per_word = _bitsPerWord;
+			m_s4Return_in = transfer(&chunk, 1U);
+			if (m_s4Return_in == UNR_IOCTRL_FAIL)
+			{
+				std::error_code ec(errno, std::generic_category());
+				std::error_condition ok;
+				if (ec != ok) puts(ec.message().c_str());
+				throw std::runtime_error(std::string("SPI Stream Transfer Error"));
+			}
+			done += length;
+		}
+		return (long)done;
+	}
+
 	UNR_SPIHandle::~UNR_SPIHandle(void)
 	{
-		close(m_intFile_descriptor);
+		if (m_transport == nullptr) close(m_intFile_descriptor);
 		m_intFile_descriptor = 0;
 		m_spifrequency = 0;
 	}
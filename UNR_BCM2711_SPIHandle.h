@@ -28,31 +28,63 @@
 #include <cerrno>         // errno
 #include <system_error>   // std::error_code, std::generic_category
 						// std::error_condition
+#include <cstring>
+#include "UNR_Transport.h"
 
 constexpr unsigned int RPI3_SPI_INSTANCE0            = 0;
 constexpr unsigned int RPI3_SPI_INSTANCE1            = 1;
 constexpr char RPI3_SPI_DEV_INSTANCE0[]              = "/dev/spidev0.0";
 constexpr char RPI3_SPI_DEV_INSTANCE1[]              = "/dev/spidev0.1";
 constexpr signed int UNR_IOCTRL_FAIL                 = -1;
+constexpr unsigned int UNR_SPI_BUS_COUNT             = 7;    // BCM2711 SPI0 - SPI6
+constexpr unsigned int UNR_SPI_CHIP_SELECTS          = 4;    // highest spidevB.C chip select handled + 1
+constexpr unsigned int UNR_SPI_MAX_SEGMENTS          = 64;   // spi_ioc_transfer entries per SPI_IOC_MESSAGE call
+constexpr unsigned int UNR_SPI_DEFAULT_BUFSIZ        = 4096; // spidev default when the module parameter can not be read
+constexpr char UNR_SPI_BUFSIZ_PARAMETER[]            = "/sys/module/spidev/parameters/bufsiz";
 
 
-	class UNR_SPIHandle
+	class UNR_SPIHandle : public UNR_SPITransport
 	{
 	private:
 		int m_intFile_descriptor;
 		unsigned int m_spifrequency;
+		unsigned char m_mode;
+		unsigned char m_bits;
+		bool m_configured;			// m_mode / m_bits / m_spifrequency hold what the kernel has
+		struct spi_ioc_transfer m_segments[UNR_SPI_MAX_SEGMENTS];
+		unsigned int m_segmentCount;
+		unsigned int m_bufsiz;
 		ssize_t m_s4Return_in;
 		ssize_t m_s4Return_out;
+		UNR_SPITransport* m_transport;	// simulated or other transport when borrowed, nullptr when this handle owns its file descriptor
 		void init_file_descriptor(const char _charFD[]) noexcept(false);
+		void init_settings(unsigned char _u1Mode, unsigned char _u1Bits, unsigned int _u4Freq) noexcept(false);
 		void set_spi_mode(const unsigned char &_u1MODE) noexcept(false);
 		void set_spi_databits(const unsigned char &_u1BITS) noexcept(false);
 		void set_spi_frequency(const unsigned int &_u4FREQ) noexcept(false);
+		static unsigned int read_bufsiz(void) noexcept;
 	
 	public:
 		UNR_SPIHandle(unsigned int _u4SPI_instance,
 			unsigned char _u1Mode,
 			unsigned char _u1Bits,
 			unsigned int _u4Freq) noexcept(false);
+		/*
+		* Any bus / chip select pair, opens /dev/spidev<_u4Bus>.<_u4ChipSelect>
+		*/
+		UNR_SPIHandle(unsigned int _u4Bus,
+			unsigned int _u4ChipSelect,
+			unsigned char _u1Mode,
+			unsigned char _u1Bits,
+			unsigned int _u4Freq) noexcept(false);
+		/*
+		* Device on a transport (UNR_SimTransport): no file descriptor of its own, every access is a UNR_SPITransport
+		* message and the settings are only recorded.
+		*/
+		UNR_SPIHandle(UNR_SPITransport& _transport,
+			unsigned char _u1Mode,
+			unsigned char _u1Bits,
+			unsigned int _u4Freq) noexcept;
 		~UNR_SPIHandle(void);
 		UNR_SPIHandle() = delete;
 		UNR_SPIHandle(const UNR_SPIHandle&) = delete;
@@ -60,8 +92,48 @@ constexpr signed int UNR_IOCTRL_FAIL                 = -1;
 		UNR_SPIHandle & operator = (const UNR_SPIHandle&) = delete;
 		UNR_SPIHandle & operator = (const UNR_SPIHandle&&) = delete;
 	//protected:
+		/*
+		* Device settings. Only a value that differs from the one last applied costs an ioctl.
+		*/
+		void spi_configure(unsigned char _u1Mode, unsigned char _u1Bits, unsigned int _u4Freq) noexcept(false);
+		unsigned char spi_mode(void) const noexcept { return m_mode; }
+		unsigned char spi_bits(void) const noexcept { return m_bits; }
+		unsigned int spi_frequency(void) const noexcept { return m_spifrequency; }
+
 		int spi_write(const unsigned char &_u1TX, const unsigned int &_u4Size) noexcept(false);
 		int spi_read(unsigned char&_u1RX, const unsigned int &_u4Size) noexcept(false);
+
+		/*
+		* Full duplex transaction batches. Segments are queued and submitted in a single ioctl(SPI_IOC_MESSAGE(n)),
+		* chip select stays asserted across segments unless _csChange is set. Either buffer may be nullptr
+		* (tx nullptr shifts out zeros, rx nullptr discards). _speedHz and _bitsPerWord of 0 use the handle settings.
+		* Buffers must stay valid until spi_submit() returns.
+		*/
+		int spi_queueTransfer(const unsigned char* _tx, unsigned char* _rx, unsigned int _u4Size,
+							unsigned int _speedHz = 0, unsigned short _delayUsecs = 0,
+							bool _csChange = false, unsigned char _bitsPerWord = 0) noexcept;
+		int spi_submit(void) noexcept(false);
+
+		/*
+		* Kernel backed UNR_SPITransport, one ioctl(SPI_IOC_MESSAGE(n)). Returns bytes transferred or -1.
+		*/
+		int transfer(struct spi_ioc_transfer* _segments, unsigned int _count) noexcept override;
+		void spi_clearQueue(void) noexcept { m_segmentCount = 0; }
+		unsigned int spi_queuedSegments(void) const noexcept { return m_segmentCount; }
+
+		/*
+		* One full duplex segment, e.g. a register read with the command in _tx and the answer clocked into _rx.
+		*/
+		int spi_transfer(const unsigned char* _tx, unsigned char* _rx, unsigned int _u4Size) noexcept(false);
+
+		/*
+		* Transfers of any length. spidev rejects a message with more than bufsiz bytes in total, so the buffers are
+		* sent as consecutive bufsiz sized messages. Chip select is released between messages.
+		* The queued segments of spi_queueTransfer() are not touched. _speedHz and _bitsPerWord of 0 use the handle settings.
+		*/
+		long spi_stream(const unsigned char* _tx, unsigned char* _rx, unsigned long _size,
+						unsigned int _speedHz = 0, unsigned char _bitsPerWord = 0) noexcept(false);
+		unsigned int spi_bufsiz(void) const noexcept { return m_bufsiz; }
 		
 	};
 #endif // __UNR_BCM2711_SPIHANDLE_H__
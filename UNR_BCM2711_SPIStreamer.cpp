@@ -0,0 +1,129 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Double buffered SPI stream (displays, DACs, ADC streaming)
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Two blocks, one being filled by the caller while the other is on the wire
+* Rev 2: Full duplex mode, the received block is handed to a callback
+* Rev 3: Stream speed and word size independent of the handle settings
+*/
+
+#include "UNR_BCM2711_SPIStreamer.h"
+
+
+	UNR_SPIStreamer::UNR_SPIStreamer(UNR_SPIHandle& _spi, unsigned long _blockSize, ReceiveCallback _onReceive,
+									void* _context, unsigned int _speedHz, unsigned char _bitsPerWord) noexcept(false) : m_spi(_spi)
+		, m_onReceive(_onReceive)
+		, m_context(_context)
+		, m_speedHz(_speedHz)
+		, m_bitsPerWord(_bitsPerWord)
+		, m_fillIndex(0)
+		, m_sendIndex(0)
+		, m_running(true)
+		, m_bytesSent(0)
+		, m_errors(0)
+	{
+		if (_blockSize == 0)
+		{
+			throw std::runtime_error(std::string("SPI Stream Block Size Is Zero"));
+		}
+		for (unsigned int i = 0; i < 2; i++)
+		{
+			m_blocks[i].resize(_blockSize);
+			if (m_onReceive) m_rxBlocks[i].resize(_blockSize);
+			m_lengths[i] = 0;
+			m_pending[i] = false;
+		}
+		m_worker = std::thread(&UNR_SPIStreamer::run, this);
+	}
+
+	/*Funct: nextBuffer returns the block to fill next, waits while it is still queued for the bus*/
+	unsigned char* UNR_SPIStreamer::nextBuffer(void)
+	{
+		std::unique_lock<std::mutex> guard(m_lock);
+		m_changed.wait(guard, [this] { return !m_pending[m_fillIndex]; });
+		return m_blocks[m_fillIndex].data();
+	}
+
+	/*Funct: submit queues the first _length bytes of the block returned by nextBuffer*/
+	void UNR_SPIStreamer::submit(unsigned long _length)
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			if (m_pending[m_fillIndex]) return;		// nextBuffer() was not called for this block
+			m_lengths[m_fillIndex] = (_length > m_blocks[m_fillIndex].size()) ? m_blocks[m_fillIndex].size() : _length;
+			m_pending[m_fillIndex] = true;
+			m_fillIndex ^= 1U;
+		}
+		m_changed.notify_all();
+	}
+
+	void UNR_SPIStreamer::flush(void)
+	{
+		std::unique_lock<std::mutex> guard(m_lock);
+		m_changed.wait(guard, [this] { return !m_pending[0] && !m_pending[1]; });
+	}
+
+	/*
+	* Worker: blocks are sent in submission order, the lock is not held while the bus is busy
+	*/
+	void UNR_SPIStreamer::run(void)
+	{
+		unsigned long length;
+		unsigned char* block;
+		unsigned char* rxBlock;
+		bool received;
+
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> guard(m_lock);
+				m_changed.wait(guard, [this] { return m_pending[m_sendIndex] || !m_running; });
+				if (!m_pending[m_sendIndex]) return;		// stopped and drained
+				block = m_blocks[m_sendIndex].data();
+				length = m_lengths[m_sendIndex];
+				rxBlock = m_onReceive ? m_rxBlocks[m_sendIndex].data() : nullptr;
+			}
+
+			received = false;
+			try {
+				m_bytesSent.fetch_add((uint64_t)m_spi.spi_stream(block, rxBlock, length, m_speedHz, m_bitsPerWord), std::memory_order_relaxed);
+				received = true;
+			}
+			catch (std::exception&)
+			{
+				m_errors.fetch_add(1, std::memory_order_relaxed);
+			}
+			// a failed block is counted in getErrors() and not handed on, its receive data is incomplete
+			if (received && m_onReceive) m_onReceive(m_context, rxBlock, length);
+
+			{
+				std::lock_guard<std::mutex> guard(m_lock);
+				m_pending[m_sendIndex] = false;
+				m_sendIndex ^= 1U;
+			}
+			m_changed.notify_all();
+		}
+	}
+
+	UNR_SPIStreamer::~UNR_SPIStreamer(void)
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_running = false;
+		}
+		m_changed.notify_all();
+		if (m_worker.joinable()) m_worker.join();
+	}
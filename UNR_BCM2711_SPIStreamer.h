@@ -0,0 +1,88 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Double buffered SPI stream (displays, DACs, ADC streaming)
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Two blocks, one being filled by the caller while the other is on the wire
+* Rev 2: Full duplex mode, the received block is handed to a callback
+* Rev 3: Stream speed and word size independent of the handle settings
+*/
+
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "UNR_BCM2711_SPIHandle.h"
+
+	/*
+	* The caller fills the block returned by nextBuffer() and hands it over with submit(). A worker thread sends
+	* it with UNR_SPIHandle::spi_stream() while the caller fills the other block. nextBuffer() blocks only when
+	* both blocks are still waiting for the bus.
+	* The handle belongs to the worker thread while the streamer exists, nothing else may use it meanwhile.
+	*
+	* With a ReceiveCallback the stream is full duplex: every block is clocked out with a receive block of the same
+	* length, and once the transfer is done the callback gets the received bytes, on the worker thread and in
+	* submission order. The received data is only valid during the call, the next block reuses the buffer. An ADC
+	* stream submits its command / dummy bytes and takes the conversions from the callback. Without a callback
+	* only the transmit side is used.
+	* _speedHz and _bitsPerWord go to every spi_stream() call, 0 keeps the handle settings.
+	*/
+	class UNR_SPIStreamer
+	{
+	public:
+		typedef void (*ReceiveCallback)(void* _context, const unsigned char* _rx, unsigned long _length);
+
+	private:
+		UNR_SPIHandle& m_spi;
+		std::vector<unsigned char> m_blocks[2];
+		std::vector<unsigned char> m_rxBlocks[2];	// empty when transmit only
+		ReceiveCallback m_onReceive;
+		void* m_context;
+		unsigned int m_speedHz;
+		unsigned char m_bitsPerWord;
+		unsigned long m_lengths[2];
+		bool m_pending[2];
+		unsigned int m_fillIndex;		// caller side
+		unsigned int m_sendIndex;		// worker side
+		bool m_running;
+		std::mutex m_lock;
+		std::condition_variable m_changed;
+		std::thread m_worker;
+		std::atomic<uint64_t> m_bytesSent;
+		std::atomic<uint64_t> m_errors;
+
+		void run(void);
+
+	public:
+		UNR_SPIStreamer(UNR_SPIHandle& _spi, unsigned long _blockSize, ReceiveCallback _onReceive = nullptr,
+						void* _context = nullptr, unsigned int _speedHz = 0, unsigned char _bitsPerWord = 0) noexcept(false);
+		~UNR_SPIStreamer(void);		// sends what was submitted, then stops
+		UNR_SPIStreamer() = delete;
+		UNR_SPIStreamer(const UNR_SPIStreamer&) = delete;
+		UNR_SPIStreamer & operator = (const UNR_SPIStreamer&) = delete;
+
+		unsigned char* nextBuffer(void);
+		void submit(unsigned long _length);
+		void flush(void);		// waits until every submitted block is sent (and its receive callback returned)
+
+		unsigned long blockSize(void) const { return (unsigned long)m_blocks[0].size(); }
+		bool isFullDuplex(void) const { return m_onReceive != nullptr; }
+		uint64_t getBytesSent(void) const { return m_bytesSent.load(std::memory_order_relaxed); }
+		uint64_t getErrors(void) const { return m_errors.load(std::memory_order_relaxed); }
+	};
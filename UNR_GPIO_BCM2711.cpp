@@ -26,6 +26,10 @@
 
 * Unauthorized Distrubution is strictly prohibited.
 * Rev 1: GPIO support added  // TODO: Make class
+* Rev 2: Edge events through the GPIO character device (/dev/gpiochipN line events)
+* Rev 3: Bank wide SET / CLR / LEV access, memory backed register page for running without hardware
+* Rev 4: Register layout moved to the header for UNR_GpioChip / UNR_GpioPin
+* Rev 5: Bank wide access rejects banks other than 0 and 1
 */
 
 //Basic Includes
@@ -35,35 +39,19 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
 //Driver header
 #include "UNR_GPIO_BCM2711.h"
 
 
-//Defines based off of BCM2711 Datasheet. (https://datasheets.raspberrypi.com/bcm2711/bcm2711-peripherals.pdf)
-#define UNR_BCM2711_GPIO_BASE_ADDR  0x7E200000
-
-// GPIO Register Assignments
-#define UNR_FSEL_OFFSET                 0   // 0x0000
-#define UNR_SET_OFFSET                  7   // 0x001c / 4   // 4 bytes each 
-#define UNR_CLR_OFFSET                  10  // 0x0028 / 4
-#define UNR_PINLEVEL_OFFSET             13  // 0x0034 / 4
-#define UNR_PINEVT_OFFSET               16  // 0x0040 / 4
-#define UNR_PINRISING_OFFSET            19  // 0x004C / 4
-// TODO : Add rest of the rising - falling edge, Async, Low detect high detect registers // Not important for Rev 1 implementation
-// TODO : Setup Clock registers
-// TODO : Setup PWM registers
-
-#define UNR_PULLUPDN_OFFSET_2711_0      57  // 0x00e4 / 4
-#define UNR_PULLUPDN_OFFSET_2711_1      58
-#define UNR_PULLUPDN_OFFSET_2711_2      59
-#define UNR_PULLUPDN_OFFSET_2711_3      60
-
-#define ARM_PAGE_SIZE  (4*1024)                     // Must check BCM2835 driver class for accuracy
-#define ARM_BLOCK_SIZE (4*1024)
-
 volatile uint32_t* gpio_map;
 int piGPIOSetup = 0;
 int piMemSetup = 0;
+static uint32_t* fake_page = NULL;          // register page of setup_fake(), NULL when the hardware is mapped
 
 /*
 * Function map_gpio_mem 
@@ -79,8 +67,8 @@ int map_gpio_mem(int mem_fd, uint32_t gpio_base) {
         return SETUP_MALLOC_FAIL;
 
     // if gpio mem allocation is not a multiple of page size, then and then only reformat
-    if ((uint32_t)gpio_mem % (uint32_t)ARM_PAGE_SIZE)
-        gpio_mem += ARM_PAGE_SIZE - (uint32_t)gpio_mem % ARM_PAGE_SIZE;
+    if ((uintptr_t)gpio_mem % (uintptr_t)ARM_PAGE_SIZE)
+        gpio_mem += ARM_PAGE_SIZE - (uintptr_t)gpio_mem % ARM_PAGE_SIZE;
 
     //finally map the allocated memory using the mmap function
     if ((gpio_map = (uint32_t*)mmap(
@@ -121,6 +109,25 @@ int setup(void) {
     return SETUP_OK;
 }
 
+/* Function Setup without hardware
+*  Points the driver at a zeroed, page aligned block of ordinary memory laid out like the GPIO register page,
+*  so the API can be exercised and timed on any machine. Writes to SET / CLR are stored as is, they are not
+*  reflected in the level registers.
+* Input to function: none
+* Output: 0 if successful, SETUP_MALLOC_FAIL otherwise
+*/
+int setup_fake(void) {
+    if (piGPIOSetup)
+        return SETUP_OK; // already initialized
+
+    if (posix_memalign((void**)&fake_page, ARM_PAGE_SIZE, ARM_BLOCK_SIZE) != 0)
+        return SETUP_MALLOC_FAIL;
+    memset(fake_page, 0, ARM_BLOCK_SIZE);
+    gpio_map = fake_page;
+    piGPIOSetup = 1;
+    return SETUP_OK;
+}
+
 /* Function to check if the GPIO memory map is already setted up or not
 * input : none
 * output : none (except the print statement of the standard error)
@@ -145,10 +152,10 @@ static void set_pullupdn(int gpio, int pud)
     int pullshift = (gpio & 0xf) << 1;
     unsigned int pullbits;
     unsigned int pull = 0;
-    switch (pud) {     // values from page 101 of https://www.raspberrypi.org/app/uploads/2012/02/BCM2835-ARM-Peripherals.pdf
+    switch (pud) {     // GPIO_PUP_PDN_CNTRL values from the BCM2711 datasheet (the BCM2835 GPPUD register used 1 = down, 2 = up)
     case PUD_OFF:    pull = 0; break;
-    case PUD_DOWN:   pull = 1; break;
-    case PUD_UP:     pull = 2; break;
+    case PUD_UP:     pull = 1; break;
+    case PUD_DOWN:   pull = 2; break;
     default:         pull = 0; // switch PUD to OFF for other values
     }
     pullbits = *(gpio_map + pullreg);
@@ -197,11 +204,11 @@ void output_gpio(int gpio, int value) {
 
     setupCheck(); // sanity check
     if (value) // value == HIGH
-        offset = UNR_SET_OFFSET + (gpio / 32);
+        offset = UNR_SET_OFFSET + (gpio >> 5);
     else // value == LOW
-        offset = UNR_CLR_OFFSET + (gpio / 32);
+        offset = UNR_CLR_OFFSET + (gpio >> 5);
 
-    shift = (gpio % 32);
+    shift = (gpio & 31);
 
     *(gpio_map + offset) = 1 << shift;
 }
@@ -214,18 +221,134 @@ int input_gpio(int gpio) {
     unsigned int offset, value, mask;
 
     setupCheck();
-    offset = UNR_PINLEVEL_OFFSET + (gpio / 32);
-    mask = (1 << gpio % 32);
+    offset = UNR_PINLEVEL_OFFSET + (gpio >> 5);
+    mask = (1 << (gpio & 31));
     value = *(gpio_map + offset) & mask;
     return value ? 1 : 0;
 }
 
+/* Bank wide access. Bank 0 is GPIO 0-31 (all header pins), bank 1 is GPIO 32-57.
+*  A set of pins is changed with at most one store to SET and one store to CLR, a bank is read with one load of LEV.
+*  Pins in both masks end up low, since CLR is written last.
+*  Any other bank would address a reserved word or a different register (FSEL for a negative bank), so it is rejected
+*  before anything is stored.
+*/
+
+/*  Function to drive the pins of set_mask high and the pins of clr_mask low
+* input : bank, mask of pins to set, mask of pins to clear
+* output : 0, or -1 for a bank other than 0 / 1
+*/
+int gpio_write_mask(int bank, uint32_t set_mask, uint32_t clr_mask) {
+    setupCheck();
+    if ((unsigned int)bank >= UNR_GPIO_BANK_COUNT)
+        return -1;
+    if (set_mask)
+        *(gpio_map + UNR_SET_OFFSET + bank) = set_mask;
+    if (clr_mask)
+        *(gpio_map + UNR_CLR_OFFSET + bank) = clr_mask;
+    return 0;
+}
+
+/*  Function to drive the pins of mask to the matching bits of value, e.g. an 8 bit parallel bus on GPIO 4-11
+*   is written with gpio_write_value(0, 0xFF << 4, byte << 4)
+* input : bank, mask of pins to update, new pin levels (bits outside of mask are ignored)
+* output : 0, or -1 for a bank other than 0 / 1
+*/
+int gpio_write_value(int bank, uint32_t mask, uint32_t value) {
+    return gpio_write_mask(bank, value & mask, ~value & mask);
+}
+
+/*  Function to read the level of all pins of a bank
+* input : bank
+* output : level register, bit n is GPIO (bank * 32 + n). 0 for a bank other than 0 / 1
+*/
+uint32_t gpio_read_bank(int bank) {
+    setupCheck();
+    if ((unsigned int)bank >= UNR_GPIO_BANK_COUNT)
+        return 0;
+    return *(gpio_map + UNR_PINLEVEL_OFFSET + bank);
+}
+
 // deallocate the memory when done. Always run this function at the end of your implementation
 void cleanup(void) 
 {
-    if (piGPIOSetup)
+    if (fake_page) {
+        free(fake_page);
+        fake_page = NULL;
+        gpio_map = NULL;
+        piGPIOSetup = 0;
+    }
+    else if (piGPIOSetup)
         //munmap((void*)gpio_map, ARM_BLOCK_SIZE);
         munmap((void*)gpio_map, (ARM_BLOCK_SIZE + (ARM_PAGE_SIZE - 1)));
 }
 
+/* Function to request edge events on a GPIO line through the GPIO character device.
+*  The kernel timestamps every edge and queues it, so no edge is lost between two waits.
+*  input : gpiochip number (0 for /dev/gpiochip0, the BCM2711 header pins), GPIO line, GPIO_EDGE_RISING / FALLING / BOTH
+*  output : event file descriptor to pass to gpio_wait_edge, or -1 on failure
+*/
+int gpio_request_edge(int chip, int gpio, int edge)
+{
+    char path[32];
+    int chip_fd;
+    struct gpioevent_request req;
+
+    snprintf(path, sizeof(path), "/dev/gpiochip%d", chip);
+    if ((chip_fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+        return -1;
+
+    memset(&req, 0, sizeof(req));
+    req.lineoffset = (uint32_t)gpio;
+    req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    switch (edge) {
+    case GPIO_EDGE_FALLING: req.eventflags = GPIOEVENT_REQUEST_FALLING_EDGE; break;
+    case GPIO_EDGE_BOTH:    req.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES; break;
+    default:                req.eventflags = GPIOEVENT_REQUEST_RISING_EDGE; break;
+    }
+    strncpy(req.consumer_label, "UNR_BCM2711", sizeof(req.consumer_label) - 1);
+
+    if (ioctl(chip_fd, GPIO_GET_LINEEVENT_IOCTL, &req) < 0) {
+        close(chip_fd);
+        return -1;
+    }
+    close(chip_fd); // the line stays requested through the event fd
+    return req.fd;
+}
+
+/* Function to block until the next edge event.
+*  Any file descriptor delivering struct gpioevent_data records works, so a pipe can stand in for the chip in tests.
+*  input : event fd, timeout in ms (-1 waits forever), optional pointer for the kernel timestamp of the edge
+*          (CLOCK_MONOTONIC on kernels >= 5.7)
+*  output : 1 for an event, 0 on timeout, -1 on error
+*/
+int gpio_wait_edge(int event_fd, int timeout_ms, uint64_t* timestamp_ns)
+{
+    struct pollfd pfd;
+    struct gpioevent_data event;
+    int ret;
+
+    pfd.fd = event_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    do {
+        ret = poll(&pfd, 1, timeout_ms);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0)
+        return ret;
+
+    if (read(event_fd, &event, sizeof(event)) != (ssize_t)sizeof(event))
+        return -1;
+    if (timestamp_ns)
+        *timestamp_ns = event.timestamp;
+    return 1;
+}
+
+// release a line requested by gpio_request_edge
+void gpio_release_edge(int event_fd)
+{
+    if (event_fd >= 0)
+        close(event_fd);
+}
+
 // -----------------------------
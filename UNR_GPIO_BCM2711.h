@@ -1,4 +1,29 @@
 #pragma once
+#include <stdint.h>
+
+//Defines based off of BCM2711 Datasheet. (https://datasheets.raspberrypi.com/bcm2711/bcm2711-peripherals.pdf)
+#define UNR_BCM2711_GPIO_BASE_ADDR  0x7E200000
+
+// GPIO Register Assignments
+#define UNR_FSEL_OFFSET                 0   // 0x0000
+#define UNR_SET_OFFSET                  7   // 0x001c / 4   // 4 bytes each 
+#define UNR_CLR_OFFSET                  10  // 0x0028 / 4
+#define UNR_PINLEVEL_OFFSET             13  // 0x0034 / 4
+#define UNR_PINEVT_OFFSET               16  // 0x0040 / 4
+#define UNR_PINRISING_OFFSET            19  // 0x004C / 4
+// TODO : Add rest of the rising - falling edge, Async, Low detect high detect registers // Not important for Rev 1 implementation
+// TODO : Setup Clock registers
+// TODO : Setup PWM registers
+
+#define UNR_PULLUPDN_OFFSET_2711_0      57  // 0x00e4 / 4
+#define UNR_PULLUPDN_OFFSET_2711_1      58
+#define UNR_PULLUPDN_OFFSET_2711_2      59
+#define UNR_PULLUPDN_OFFSET_2711_3      60
+
+#define UNR_GPIO_BANK_COUNT             2   // SET, CLR and LEV have one word per bank
+
+#define ARM_PAGE_SIZE  (4*1024)                     // Must check BCM2835 driver class for accuracy
+#define ARM_BLOCK_SIZE (4*1024)
 
 #define SETUP_OK           0
 #define SETUP_MALLOC_FAIL  1
@@ -14,10 +39,24 @@
 #define PUD_DOWN 2
 #define PUD_UP   1
 
+#define GPIO_EDGE_RISING   1
+#define GPIO_EDGE_FALLING  2
+#define GPIO_EDGE_BOTH     3
+
 int setup(void);
+int setup_fake(void);   // memory backed register page, no hardware access
 void cleanup(void);
 void setup_gpio(int gpio, int direction, int pud);
 void output_gpio(int gpio, int value);
 int input_gpio(int gpio);
 int get_pullupdn(int gpio);
 
+// Bank wide access, bank 0 is GPIO 0-31 and bank 1 is GPIO 32-57. Other banks are rejected (-1, nothing written)
+int gpio_write_mask(int bank, uint32_t set_mask, uint32_t clr_mask);
+int gpio_write_value(int bank, uint32_t mask, uint32_t value);
+uint32_t gpio_read_bank(int bank);
+
+// Edge events through the GPIO character device (/dev/gpiochipN)
+int gpio_request_edge(int chip, int gpio, int edge);
+int gpio_wait_edge(int event_fd, int timeout_ms, uint64_t* timestamp_ns);
+void gpio_release_edge(int event_fd);
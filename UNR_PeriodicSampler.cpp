@@ -0,0 +1,203 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Deadline driven periodic scheduler with wake up latency and jitter statistics
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: clock_nanosleep(TIMER_ABSTIME) loop, SCHED_FIFO / affinity / mlockall options, runtime queryable histograms
+* Rev 2: Scheduling options available to other threads through UNR_applyThreadConfig
+*/
+
+
+#include "UNR_PeriodicSampler.h"
+#include <stdexcept>
+#include <string>
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+void UNR_SamplerHistogram::reset(void)
+{
+	for (unsigned int i = 0; i < UNR_SAMPLER_HIST_BINS; i++)
+		m_bins[i].store(0, std::memory_order_relaxed);
+	m_count.store(0, std::memory_order_relaxed);
+	m_min.store(UINT64_MAX, std::memory_order_relaxed);
+	m_max.store(0, std::memory_order_relaxed);
+}
+
+void UNR_SamplerHistogram::record(uint64_t _ns)
+{
+	uint64_t bin = _ns / 1000U;
+	if (bin >= UNR_SAMPLER_HIST_BINS) bin = UNR_SAMPLER_HIST_BINS - 1;
+	m_bins[bin].store(m_bins[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	if (_ns < m_min.load(std::memory_order_relaxed)) m_min.store(_ns, std::memory_order_relaxed);
+	if (_ns > m_max.load(std::memory_order_relaxed)) m_max.store(_ns, std::memory_order_relaxed);
+	m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+UNR_SamplerHistogramStats UNR_SamplerHistogram::snapshot(void) const
+{
+	UNR_SamplerHistogramStats stats = {};
+	uint32_t bins[UNR_SAMPLER_HIST_BINS];
+	uint64_t total = 0, running = 0;
+	bool have50 = false;
+
+	for (unsigned int i = 0; i < UNR_SAMPLER_HIST_BINS; i++)
+	{
+		bins[i] = m_bins[i].load(std::memory_order_relaxed);
+		total += bins[i];
+	}
+	stats.count = total;
+	if (total == 0) return stats;
+	stats.min_ns = m_min.load(std::memory_order_relaxed);
+	stats.max_ns = m_max.load(std::memory_order_relaxed);
+
+	for (unsigned int i = 0; i < UNR_SAMPLER_HIST_BINS; i++)
+	{
+		running += bins[i];
+		if (!have50 && running * 2 >= total)
+		{
+			stats.p50_ns = (uint64_t)(i + 1) * 1000U;
+			have50 = true;
+		}
+		if (running * 100 >= total * 99)
+		{
+			stats.p99_ns = (uint64_t)(i + 1) * 1000U;
+			break;
+		}
+	}
+	// the upper edge of a bin can overshoot the true maximum
+	if (stats.p50_ns > stats.max_ns) stats.p50_ns = stats.max_ns;
+	if (stats.p99_ns > stats.max_ns) stats.p99_ns = stats.max_ns;
+	return stats;
+}
+
+int UNR_applyThreadConfig(std::thread& _thread, const UNR_SamplerConfig& _config)
+{
+	if (_config.priority > 0)
+	{
+		struct sched_param param;
+		param.sched_priority = _config.priority;
+		if (pthread_setschedparam(_thread.native_handle(), SCHED_FIFO, &param) != 0) return -1;
+	}
+	if (_config.cpu >= 0)
+	{
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		CPU_SET(_config.cpu, &cpuset);
+		if (pthread_setaffinity_np(_thread.native_handle(), sizeof(cpu_set_t), &cpuset) != 0) return -1;
+	}
+	return 1;
+}
+
+UNR_PeriodicSampler::UNR_PeriodicSampler(const UNR_SamplerConfig& _config) noexcept(false) : m_config(_config)
+																							, m_periodNs(0)
+																							, m_running(false)
+																							, m_periods(0)
+																							, m_missed(0)
+{
+	if (_config.rateHz < UNR_SAMPLER_MIN_RATE_HZ || _config.rateHz > UNR_SAMPLER_MAX_RATE_HZ)
+	{
+		throw std::runtime_error(std::string("Sampler rate out of range"));
+	}
+	m_periodNs = 1000000000ULL / _config.rateHz;
+}
+
+int UNR_PeriodicSampler::start(Callback _callback, void* _context)
+{
+	if (m_running.load()) return -1;
+	if (m_config.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) return -1;
+
+	m_running.store(true);
+	m_thread = std::thread(&UNR_PeriodicSampler::run, this, _callback, _context);
+	if (UNR_applyThreadConfig(m_thread, m_config) < 0)
+	{
+		stop();
+		return -1;
+	}
+	return 1;
+}
+
+void UNR_PeriodicSampler::stop(void)
+{
+	m_running.store(false);
+	if (m_thread.joinable()) m_thread.join();
+}
+
+/*
+* Sampler loop. Deadlines are absolute, so the time spent in the callback never accumulates into drift.
+* When a callback runs past the next deadline the missed periods are skipped instead of being run back to back.
+*/
+void UNR_PeriodicSampler::run(Callback _callback, void* _context)
+{
+	struct timespec ts;
+	uint64_t deadline = UNR_monotonicNs() + m_periodNs;
+	uint64_t wake, end, lastWake = 0, interval, late;
+
+	while (m_running.load(std::memory_order_relaxed))
+	{
+		ts.tv_sec = (time_t)(deadline / 1000000000ULL);
+		ts.tv_nsec = (long)(deadline % 1000000000ULL);
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+
+		wake = UNR_monotonicNs();
+		m_latency.record(wake > deadline ? wake - deadline : 0);
+		if (lastWake != 0)
+		{
+			interval = wake - lastWake;
+			m_jitter.record(interval > m_periodNs ? interval - m_periodNs : m_periodNs - interval);
+		}
+		lastWake = wake;
+
+		_callback(_context, deadline);
+		m_periods.store(m_periods.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+		deadline += m_periodNs;
+		end = UNR_monotonicNs();
+		if (end > deadline)
+		{
+			late = (end - deadline) / m_periodNs + 1;
+			m_missed.store(m_missed.load(std::memory_order_relaxed) + late, std::memory_order_relaxed);
+			deadline += late * m_periodNs;
+			lastWake = 0;	// the skipped periods are counted as missed, not as jitter
+		}
+	}
+}
+
+UNR_SamplerStats UNR_PeriodicSampler::getStats(void) const
+{
+	UNR_SamplerStats stats;
+	stats.periods = m_periods.load(std::memory_order_relaxed);
+	stats.missed = m_missed.load(std::memory_order_relaxed);
+	stats.latency = m_latency.snapshot();
+	stats.jitter = m_jitter.snapshot();
+	return stats;
+}
+
+/*
+* Not synchronized with the sampler thread, a few records around the reset may land in either side
+*/
+void UNR_PeriodicSampler::resetStats(void)
+{
+	m_periods.store(0, std::memory_order_relaxed);
+	m_missed.store(0, std::memory_order_relaxed);
+	m_latency.reset();
+	m_jitter.reset();
+}
+
+UNR_PeriodicSampler::~UNR_PeriodicSampler(void)
+{
+	stop();
+}
@@ -0,0 +1,125 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Deadline driven periodic scheduler with wake up latency and jitter statistics
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: clock_nanosleep(TIMER_ABSTIME) loop, SCHED_FIFO / affinity / mlockall options, runtime queryable histograms
+* Rev 2: Scheduling options available to other threads through UNR_applyThreadConfig
+*/
+
+
+#pragma once
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+#include <time.h>
+
+#define UNR_SAMPLER_MIN_RATE_HZ		100U
+#define UNR_SAMPLER_MAX_RATE_HZ		4000U
+#define UNR_SAMPLER_HIST_BINS		1024U		// 1 us per bin, the last bin collects everything above
+
+struct UNR_SamplerConfig
+{
+	unsigned int rateHz;		// UNR_SAMPLER_MIN_RATE_HZ .. UNR_SAMPLER_MAX_RATE_HZ
+	int priority;				// SCHED_FIFO priority (1..99), 0 keeps the default scheduler
+	int cpu;					// CPU to pin the sampler thread to, -1 for no affinity
+	bool lockMemory;			// mlockall(MCL_CURRENT | MCL_FUTURE) before starting
+};
+
+struct UNR_SamplerHistogramStats
+{
+	uint64_t count;
+	uint64_t min_ns;
+	uint64_t p50_ns;			// percentiles are resolved to the 1 us histogram bin
+	uint64_t p99_ns;
+	uint64_t max_ns;
+};
+
+struct UNR_SamplerStats
+{
+	uint64_t periods;					// callbacks executed
+	uint64_t missed;					// periods skipped because a callback ran past the next deadline
+	UNR_SamplerHistogramStats latency;	// wake up time - deadline
+	UNR_SamplerHistogramStats jitter;	// |wake up interval - period|
+};
+
+/*
+* Histogram written by the sampler thread only and read by anyone. Counters are relaxed atomics that the
+* single writer updates with plain load / store, so recording costs no locked instruction.
+*/
+class UNR_SamplerHistogram
+{
+private:
+	std::atomic<uint32_t> m_bins[UNR_SAMPLER_HIST_BINS];
+	std::atomic<uint64_t> m_count;
+	std::atomic<uint64_t> m_min;
+	std::atomic<uint64_t> m_max;
+
+public:
+	UNR_SamplerHistogram(void) { reset(); }
+	void reset(void);
+	void record(uint64_t _ns);
+	UNR_SamplerHistogramStats snapshot(void) const;
+};
+
+class UNR_PeriodicSampler
+{
+public:
+	typedef void (*Callback)(void* _context, uint64_t _deadline_ns);
+
+private:
+	UNR_SamplerConfig m_config;
+	uint64_t m_periodNs;
+	std::thread m_thread;
+	std::atomic<bool> m_running;
+	std::atomic<uint64_t> m_periods;
+	std::atomic<uint64_t> m_missed;
+	UNR_SamplerHistogram m_latency;
+	UNR_SamplerHistogram m_jitter;
+
+	void run(Callback _callback, void* _context);
+
+public:
+	UNR_PeriodicSampler(const UNR_SamplerConfig& _config) noexcept(false);
+	~UNR_PeriodicSampler(void);
+	UNR_PeriodicSampler() = delete;
+	UNR_PeriodicSampler(const UNR_PeriodicSampler&) = delete;
+	UNR_PeriodicSampler& operator = (const UNR_PeriodicSampler&) = delete;
+
+	/*
+	* Starts the sampler thread which calls _callback once per period with the absolute deadline (CLOCK_MONOTONIC ns).
+	* Returns 1 on success, -1 if already running or if memory locking, priority or affinity could not be applied
+	* (the thread is stopped again in that case).
+	*/
+	int start(Callback _callback, void* _context);
+	void stop(void);
+	bool isRunning(void) const { return m_running.load(std::memory_order_relaxed); }
+
+	UNR_SamplerStats getStats(void) const;
+	void resetStats(void);
+	uint64_t getPeriodNs(void) const { return m_periodNs; }
+};
+
+/*
+* Applies priority and affinity of _config to a running thread. Returns 1 on success, -1 on failure.
+*/
+int UNR_applyThreadConfig(std::thread& _thread, const UNR_SamplerConfig& _config);
+
+static inline uint64_t UNR_monotonicNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,138 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Lock free single producer / single consumer ring buffer
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Power of two ring with cache line padded indices, batch pop and drop oldest / drop newest overrun policy
+* Rev 2: size() loads tail before head and is clamped to the capacity
+*/
+
+
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+#define UNR_CACHE_LINE_SIZE		64
+
+enum UNR_RingPolicy
+{
+	UNR_RING_DROP_NEWEST = 0,	// a full ring rejects the new element
+	UNR_RING_DROP_OLDEST = 1	// a full ring discards its oldest element to make room
+};
+
+/*
+* Head and tail are free running 64 bit counters, the slot is (counter & (Capacity - 1)).
+* Each index sits on its own cache line so producer and consumer never write the same line.
+*
+* Drop oldest: the producer may advance the tail itself when the ring is full. The consumer therefore
+* copies the slot first and then claims it with a compare-exchange on the tail. If the producer got there
+* first the copy is thrown away and the consumer retries, so a slot being overwritten is never returned.
+* T must be trivially copyable.
+*/
+template<typename T, unsigned int Capacity>
+class UNR_SPSCRing
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "UNR_SPSCRing capacity must be a power of two");
+
+private:
+	alignas(UNR_CACHE_LINE_SIZE) std::atomic<uint64_t> m_head;		// next slot to write, producer only
+	alignas(UNR_CACHE_LINE_SIZE) std::atomic<uint64_t> m_tail;		// next slot to read
+	alignas(UNR_CACHE_LINE_SIZE) std::atomic<uint64_t> m_overruns;	// elements lost to a full ring
+	UNR_RingPolicy m_policy;
+	alignas(UNR_CACHE_LINE_SIZE) T m_slots[Capacity];
+
+public:
+	explicit UNR_SPSCRing(UNR_RingPolicy _policy = UNR_RING_DROP_NEWEST) : m_head(0), m_tail(0), m_overruns(0), m_policy(_policy) {}
+	UNR_SPSCRing(const UNR_SPSCRing&) = delete;
+	UNR_SPSCRing& operator = (const UNR_SPSCRing&) = delete;
+
+	/*
+	* Producer side. Returns false if the element (drop newest) or the oldest element (drop oldest) was lost.
+	*/
+	bool push(const T& _item)
+	{
+		const uint64_t head = m_head.load(std::memory_order_relaxed);
+		uint64_t tail = m_tail.load(std::memory_order_acquire);
+		bool lost = false;
+
+		while (head - tail >= Capacity)
+		{
+			if (m_policy == UNR_RING_DROP_NEWEST)
+			{
+				m_overruns.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			// a failed exchange means the consumer freed a slot meanwhile, tail is reloaded and checked again
+			if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				m_overruns.fetch_add(1, std::memory_order_relaxed);
+				lost = true;
+				break;
+			}
+		}
+		m_slots[head & (Capacity - 1)] = _item;
+		m_head.store(head + 1, std::memory_order_release);
+		return !lost;
+	}
+
+	/*
+	* Consumer side. Returns false if the ring is empty.
+	*/
+	bool pop(T& _item)
+	{
+		uint64_t tail = m_tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			if (m_head.load(std::memory_order_acquire) == tail) return false;
+			_item = m_slots[tail & (Capacity - 1)];
+			if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+				return true;
+		}
+	}
+
+	/*
+	* Consumer side. Copies up to _max elements in order and returns how many were taken.
+	*/
+	unsigned int popBatch(T* _items, unsigned int _max)
+	{
+		uint64_t tail = m_tail.load(std::memory_order_relaxed);
+		uint64_t available;
+		for (;;)
+		{
+			available = m_head.load(std::memory_order_acquire) - tail;
+			if (available == 0 || _max == 0) return 0;
+			if (available > _max) available = _max;
+			for (uint64_t i = 0; i < available; i++)
+				_items[i] = m_slots[(tail + i) & (Capacity - 1)];
+			if (m_tail.compare_exchange_weak(tail, tail + available, std::memory_order_acq_rel, std::memory_order_relaxed))
+				return (unsigned int)available;
+		}
+	}
+
+	/*
+	* Approximate while the other side is running. The tail is loaded before the head, so head >= tail even when the
+	* producer advances both in between (drop oldest); the difference can then exceed Capacity and is clamped.
+	*/
+	unsigned int size(void) const
+	{
+		const uint64_t tail = m_tail.load(std::memory_order_acquire);
+		const uint64_t head = m_head.load(std::memory_order_acquire);
+		return head - tail > Capacity ? Capacity : (unsigned int)(head - tail);
+	}
+	bool empty(void) const { return size() == 0; }
+	static constexpr unsigned int capacity(void) { return Capacity; }
+	uint64_t overruns(void) const { return m_overruns.load(std::memory_order_relaxed); }
+	UNR_RingPolicy policy(void) const { return m_policy; }
+};
@@ -0,0 +1,154 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: In process bus with register map device models, stands in for /dev/i2c-X and /dev/spidevB.C
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: I2C and SPI register protocols, device models by address / chip select, bus latency model
+* Rev 2: SPI command parsed once per chip select assertion, split command / data segments
+*/
+
+
+#include "UNR_SimTransport.h"
+#include <cerrno>
+#include <time.h>
+
+static inline uint64_t simNowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+UNR_SimTransport::UNR_SimTransport(const UNR_SimLatency& _latency) : m_spiDevice(nullptr)
+																	, m_latency(_latency)
+																	, m_transfers(0)
+																	, m_bytes(0)
+{
+	for (unsigned int i = 0; i < UNR_SIM_I2C_ADDRESSES; i++)
+	{
+		m_i2cDevices[i] = nullptr;
+		m_pointers[i] = 0;
+	}
+}
+
+void UNR_SimTransport::accessBytes(UNR_SimDevice* _device, unsigned char& _pointer, unsigned char* _data, unsigned int _len, bool _read)
+{
+	for (unsigned int i = 0; i < _len; i++)
+	{
+		if (_read)
+			_data[i] = _device->readRegister(_pointer);
+		else
+			_device->writeRegister(_pointer, _data[i]);
+		if (_device->autoIncrement(_pointer)) _pointer++;
+	}
+}
+
+/*
+* Sleeps until the modelled end of the transaction. Absolute deadline, so the time spent in the models counts.
+*/
+void UNR_SimTransport::wait(uint64_t _start_ns, uint64_t _bytes)
+{
+	uint64_t deadline = _start_ns + m_latency.perTransfer_ns + m_latency.perByte_ns * _bytes;
+	struct timespec ts;
+	if (deadline == _start_ns) return;
+	ts.tv_sec = (time_t)(deadline / 1000000000ULL);
+	ts.tv_nsec = (long)(deadline % 1000000000ULL);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+int UNR_SimTransport::transfer(struct i2c_msg* _msgs, unsigned int _count) noexcept
+{
+	uint64_t start = simNowNs();
+	uint64_t bytes = 0;
+	UNR_SimDevice* device;
+	unsigned char address;
+
+	for (unsigned int i = 0; i < _count; i++)
+	{
+		address = (unsigned char)(_msgs[i].addr % UNR_SIM_I2C_ADDRESSES);
+		device = m_i2cDevices[address];
+		if (device == nullptr)
+		{
+			wait(start, bytes);
+			errno = ENXIO;
+			return -1;
+		}
+		device->advance(start);
+		bytes += _msgs[i].len + 1U;		// address byte
+		if (_msgs[i].flags & I2C_M_RD)
+			accessBytes(device, m_pointers[address], _msgs[i].buf, _msgs[i].len, true);
+		else if (_msgs[i].len > 0)
+		{
+			m_pointers[address] = _msgs[i].buf[0];
+			accessBytes(device, m_pointers[address], &_msgs[i].buf[1], _msgs[i].len - 1U, false);
+		}
+	}
+	wait(start, bytes);
+	m_transfers.fetch_add(1, std::memory_order_relaxed);
+	m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	return (int)_count;
+}
+
+int UNR_SimTransport::transfer(struct spi_ioc_transfer* _segments, unsigned int _count) noexcept
+{
+	uint64_t start = simNowNs();
+	uint64_t bytes = 0;
+	const unsigned char* tx;
+	unsigned char* rx;
+	unsigned char pointer = 0, value;
+	bool read = false;
+	bool selected = false;		// command byte of this chip select assertion seen
+
+	if (m_spiDevice == nullptr)
+	{
+		errno = ENODEV;
+		return -1;
+	}
+	m_spiDevice->advance(start);
+	for (unsigned int i = 0; i < _count; i++)
+	{
+		tx = (const unsigned char*)(uintptr_t)_segments[i].tx_buf;
+		rx = (unsigned char*)(uintptr_t)_segments[i].rx_buf;
+		bytes += _segments[i].len;
+		for (unsigned int b = 0; b < _segments[i].len; b++)
+		{
+			if (!selected)
+			{
+				value = tx ? tx[b] : 0x00;
+				read = (value & UNR_SIM_SPI_READ_FLAG) != 0;
+				pointer = (unsigned char)(value & ~UNR_SIM_SPI_READ_FLAG);
+				if (rx) rx[b] = 0x00;
+				selected = true;
+				continue;
+			}
+			if (read)
+			{
+				value = m_spiDevice->readRegister(pointer);
+				if (rx) rx[b] = value;
+			}
+			else
+			{
+				m_spiDevice->writeRegister(pointer, tx ? tx[b] : 0x00);
+				if (rx) rx[b] = 0x00;
+			}
+			if (m_spiDevice->autoIncrement(pointer)) pointer++;
+		}
+		if (_segments[i].cs_change) selected = false;
+	}
+	wait(start, bytes);
+	m_transfers.fetch_add(1, std::memory_order_relaxed);
+	m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	return (int)bytes;
+}
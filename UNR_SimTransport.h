@@ -0,0 +1,99 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: In process bus with register map device models, stands in for /dev/i2c-X and /dev/spidevB.C
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: I2C and SPI register protocols, device models by address / chip select, bus latency model
+* Rev 2: SPI command parsed once per chip select assertion, split command / data segments
+*/
+
+
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "UNR_Transport.h"
+
+constexpr unsigned int UNR_SIM_I2C_ADDRESSES = 128U;
+constexpr unsigned char UNR_SIM_SPI_READ_FLAG = 0x80;	// first byte of an SPI segment: register | 0x80 to read
+
+/*
+* Register map device. The transport keeps the register pointer and calls these once per byte.
+*/
+class UNR_SimDevice
+{
+public:
+	virtual ~UNR_SimDevice(void) {}
+	virtual unsigned char readRegister(unsigned char _register) = 0;
+	virtual void writeRegister(unsigned char _register, unsigned char _value) = 0;
+	// false for data port registers (FIFOs) which keep the pointer in place
+	virtual bool autoIncrement(unsigned char _register) const { (void)_register; return true; }
+	// called with CLOCK_MONOTONIC before every transaction that addresses the device
+	virtual void advance(uint64_t _now_ns) { (void)_now_ns; }
+};
+
+/*
+* Time a transaction takes on the wire: perTransfer_ns once per call (START, addressing, driver overhead),
+* perByte_ns for every data byte. The calling thread sleeps for that long, as it would inside the kernel driver.
+*/
+struct UNR_SimLatency
+{
+	uint64_t perTransfer_ns;
+	uint64_t perByte_ns;
+};
+
+constexpr UNR_SimLatency UNR_SIM_LATENCY_NONE = { 0U, 0U };
+constexpr UNR_SimLatency UNR_SIM_LATENCY_I2C_100K = { 60000U, 90000U };		// 9 clocks per byte at 100 kHz
+constexpr UNR_SimLatency UNR_SIM_LATENCY_I2C_400K = { 30000U, 22500U };		// 9 clocks per byte at 400 kHz
+constexpr UNR_SimLatency UNR_SIM_LATENCY_SPI_1M = { 10000U, 8000U };
+
+/*
+* I2C: a write message sets the register pointer of the addressed device with its first byte and writes the rest,
+* a read message reads from the pointer. Unknown addresses NACK (-1, errno ENXIO).
+* SPI: every chip select assertion starts with (register | UNR_SIM_SPI_READ_FLAG) for a read or the register for a
+* write, the remaining bytes are read into rx_buf or written from tx_buf (MPU-6000 / most sensor SPI register
+* protocols). As with spidev chip select stays asserted across the segments of one call, so the command and the data
+* may be separate segments (tx_buf nullptr for the data); a segment with cs_change set ends the frame and the next
+* byte is a new command.
+* The SPI side is a single chip select with the device of attachSPI().
+* Devices are not owned and must outlive the transport. One thread at a time per transport.
+*/
+class UNR_SimTransport : public UNR_I2CTransport, public UNR_SPITransport
+{
+private:
+	UNR_SimDevice* m_i2cDevices[UNR_SIM_I2C_ADDRESSES];
+	unsigned char m_pointers[UNR_SIM_I2C_ADDRESSES];
+	UNR_SimDevice* m_spiDevice;
+	UNR_SimLatency m_latency;
+	std::atomic<uint64_t> m_transfers;
+	std::atomic<uint64_t> m_bytes;
+
+	void accessBytes(UNR_SimDevice* _device, unsigned char& _pointer, unsigned char* _data, unsigned int _len, bool _read);
+	void wait(uint64_t _start_ns, uint64_t _bytes);
+
+public:
+	explicit UNR_SimTransport(const UNR_SimLatency& _latency = UNR_SIM_LATENCY_NONE);
+	UNR_SimTransport(const UNR_SimTransport&) = delete;
+	UNR_SimTransport& operator = (const UNR_SimTransport&) = delete;
+
+	void attach(unsigned char _address, UNR_SimDevice* _device) { m_i2cDevices[_address % UNR_SIM_I2C_ADDRESSES] = _device; }
+	void attachSPI(UNR_SimDevice* _device) { m_spiDevice = _device; }
+	void setLatency(const UNR_SimLatency& _latency) { m_latency = _latency; }
+
+	int transfer(struct i2c_msg* _msgs, unsigned int _count) noexcept override;
+	int transfer(struct spi_ioc_transfer* _segments, unsigned int _count) noexcept override;
+
+	uint64_t getTransfers(void) const { return m_transfers.load(std::memory_order_relaxed); }
+	uint64_t getBytes(void) const { return m_bytes.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,48 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Bus transports the device drivers are written against
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: I2C and SPI message transports (kernel backed: UNR_I2CBus, UNR_SPIHandle; simulated: UNR_SimTransport)
+*/
+
+
+#pragma once
+#include <linux/i2c.h>
+#include <linux/spi/spidev.h>
+
+/*
+* One call moves a whole combined transaction, with the semantics of ioctl(I2C_RDWR): messages carry their own
+* slave address, a repeated START separates them and one STOP ends the call.
+* Returns the number of messages transferred or -1 (errno set).
+*/
+class UNR_I2CTransport
+{
+public:
+	virtual ~UNR_I2CTransport(void) {}
+	virtual int transfer(struct i2c_msg* _msgs, unsigned int _count) noexcept = 0;
+	virtual unsigned long functions(void) const noexcept { return I2C_FUNC_I2C; }	// I2C_FUNCS bits of the adapter
+};
+
+/*
+* One call moves a whole SPI message, with the semantics of ioctl(SPI_IOC_MESSAGE(n)) on the transport's chip select.
+* Returns the number of bytes transferred or -1 (errno set).
+*/
+class UNR_SPITransport
+{
+public:
+	virtual ~UNR_SPITransport(void) {}
+	virtual int transfer(struct spi_ioc_transfer* _segments, unsigned int _count) noexcept = 0;
+};
@@ -4,11 +4,11 @@ int main(void)
 {
 	printf("MPU6050 Driver Starting\n");
 
-	MPU6050_RaspbPi* mpu = new MPU6050_RaspbPi(MPU6050_DEVICE_ADDRESS);
-	MPU6050_RaspbPi* obj = mpu; 
-	double* accelerometer = new double[3];
-	double* gyrometer = new double[3];
-	double* temperature = new double[1];
+	MPU6050_RaspbPi mpu(MPU6050_DEVICE_ADDRESS);
+	MPU6050_RaspbPi* obj = &mpu; 
+	double accelerometer[3];
+	double gyrometer[3];
+	double temperature[1];
 	
 	if (obj->initialize() < 0) return -1;
 
@@ -29,9 +29,5 @@ int main(void)
 		}
 	}
 
-	delete mpu;
-	delete accelerometer;
-	delete gyrometer;
-
 	return 0;
-}
\ No newline at end of file
+}
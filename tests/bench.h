@@ -0,0 +1,87 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Timing loop and report line shared by the benchmarks
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Wall and process CPU time over a fixed time budget
+* Rev 2: Time per operation in ns, the decode loops run at a few ns per sample
+*/
+
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_MS	300U		// time per measurement, BENCH_MS in the environment overrides it
+
+struct BenchResult
+{
+	uint64_t ops;
+	uint64_t elapsed_ns;
+	uint64_t cpu_ns;		// CPU time of the whole process, all threads
+};
+
+static inline uint64_t benchClock(clockid_t _clock)
+{
+	struct timespec ts;
+	clock_gettime(_clock, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t benchBudget_ns(void)
+{
+	const char* ms = getenv("BENCH_MS");
+	unsigned long value = ms ? strtoul(ms, nullptr, 10) : 0UL;
+	return (uint64_t)(value ? value : BENCH_DEFAULT_MS) * 1000000ULL;
+}
+
+/*
+* Calls _body() once to warm up, then until the time budget is used. _body() returns the operations it did.
+*/
+template<typename Body>
+static BenchResult benchRun(Body _body)
+{
+	BenchResult result = { 0, 0, 0 };
+	uint64_t budget = benchBudget_ns(), start, cpuStart;
+
+	_body();
+	start = benchClock(CLOCK_MONOTONIC);
+	cpuStart = benchClock(CLOCK_PROCESS_CPUTIME_ID);
+	do
+	{
+		result.ops += _body();
+		result.elapsed_ns = benchClock(CLOCK_MONOTONIC) - start;
+	} while (result.elapsed_ns < budget);
+	result.cpu_ns = benchClock(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+	return result;
+}
+
+/*
+* One line per measurement: rate, time per operation, CPU load and, when _perOpUnit is given, a counter per operation
+*/
+static inline void benchReport(const char* _name, const BenchResult& _result, const char* _unit,
+								double _perOp = 0.0, const char* _perOpUnit = nullptr)
+{
+	double seconds = (double)_result.elapsed_ns * 1e-9;
+	double rate = _result.ops / seconds;
+
+	printf("%-44s %14.1f %s/s %12.2f ns/%s  cpu %5.1f %%", _name, rate, _unit,
+			_result.ops ? (double)_result.elapsed_ns / (double)_result.ops : 0.0, _unit,
+			100.0 * (double)_result.cpu_ns / (double)_result.elapsed_ns);
+	if (_perOpUnit != nullptr) printf("  %.2f %s", _perOp, _perOpUnit);
+	printf("\n");
+}
@@ -0,0 +1,70 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Samples per second of MPU6050_decodeBlock() against the scalar reference
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: One FIFO drain and one large block, per compiled path
+*/
+
+
+#include "bench.h"
+#include "MPU6050_BulkDecoder.h"
+#include "MPU6050_RegisterMap.h"
+#include <vector>
+
+#define FIFO_DRAIN_RECORDS	(1024U / MPU6050_RECORD_SIZE)		// a full sensor FIFO
+#define LARGE_BLOCK_RECORDS	4096U
+
+static void run(unsigned int _count)
+{
+	std::vector<unsigned char> records(_count * MPU6050_RECORD_SIZE);
+	std::vector<float> data(7U * _count);
+	MPU6050_SoA soa = { &data[0], &data[_count], &data[2U * _count], &data[3U * _count], &data[4U * _count],
+						&data[5U * _count], &data[6U * _count] };
+	const float accelScaleInv = 1.0f / MPU6050_ACCEL_FS_2_SCALE, gyroScaleInv = 1.0f / MPU6050_GYRO_FS_250_SCALE;
+	char name[64];
+	BenchResult result;
+
+	srand(6050U);
+	for (unsigned char& byte : records) byte = (unsigned char)rand();
+
+	result = benchRun([&]() {
+		MPU6050_decodeBlockScalar(records.data(), _count, soa, accelScaleInv, gyroScaleInv);
+		return _count;
+	});
+	snprintf(name, sizeof(name), "%u records, scalar", _count);
+	benchReport(name, result, "sample");
+
+	result = benchRun([&]() {
+		MPU6050_decodeBlock(records.data(), _count, soa, accelScaleInv, gyroScaleInv);
+		return _count;
+	});
+	snprintf(name, sizeof(name), "%u records, %s", _count, MPU6050_decodeBlockPath());
+	benchReport(name, result, "sample");
+}
+
+int main(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__AVX2__)
+	if (!__builtin_cpu_supports("avx2")) { printf("SKIP: %s build on a CPU without AVX2\n", MPU6050_decodeBlockPath()); return 0; }
+#elif defined(__SSSE3__)
+	if (!__builtin_cpu_supports("ssse3")) { printf("SKIP: %s build on a CPU without SSSE3\n", MPU6050_decodeBlockPath()); return 0; }
+#endif
+#endif
+	run(FIFO_DRAIN_RECORDS);
+	run(LARGE_BLOCK_RECORDS);
+	return 0;
+}
@@ -0,0 +1,118 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Capture file writer and reader throughput, against formatted text logging
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Records and MB per second written, sequential reads and time range seeks
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Capture.h"
+#include <random>
+#include <vector>
+
+#define CAPTURE_PATH		"bench_capture.cap"
+#define CAPTURE_RECORDS		(256U * 1024U)		// one 8 MiB recording per measured operation
+#define CAPTURE_BATCH		256U				// records per append(), a ring drain
+#define CAPTURE_PERIOD_NS	1000000ULL			// 1 kHz
+#define CAPTURE_SEEKS		1024U
+
+static void report(const char* _name, const BenchResult& _result, double _bytesPerRecord)
+{
+	benchReport(_name, _result, "record", (double)_result.ops * _bytesPerRecord / ((double)_result.elapsed_ns * 1e-3), "MB/s");
+}
+
+int main(void)
+{
+	std::vector<MPU6050_Sample> samples(CAPTURE_RECORDS);
+	MPU6050_CaptureConfig config = { MPU6050_ACCEL_FS_2_SCALE, MPU6050_GYRO_FS_250_SCALE, 1000U, MPU6050_DEVICE_ADDRESS, { 0, 0, 0 } };
+	std::vector<uint64_t> seeks(CAPTURE_SEEKS);
+	std::mt19937_64 generator(6050U);
+	char name[64];
+	uint64_t textBytes = 0, sink = 0;
+	BenchResult result;
+
+	for (unsigned int i = 0; i < CAPTURE_RECORDS; i++)
+	{
+		for (unsigned int c = 0; c < MPU6050_CHANNELS; c++) samples[i].raw[c] = (int16_t)(i * 7U + c * 1000U);
+		samples[i].reserved = 0;
+		samples[i].timestamp = (uint64_t)(i + 1U) * CAPTURE_PERIOD_NS;
+		samples[i].sequence = i;
+	}
+
+	// what main.cpp does per sample, formatting alone (to /dev/null, no disk involved)
+	FILE* text = fopen("/dev/null", "w");
+	if (text == nullptr) return 1;
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < CAPTURE_BATCH; i++)
+		{
+			const MPU6050_Sample& s = samples[i];
+			int written = fprintf(text, "Ax : %.2f | Ay : %.2f\t| Az : %.2f\t| Tp : %.2f\t| Gx : %.2f\t| Gy : %.2f\t| Gz: %.2f\t\n",
+								s.raw[0] / config.accelScale, s.raw[1] / config.accelScale, s.raw[2] / config.accelScale,
+								s.raw[3] / 340.0 + 36.53, s.raw[4] / config.gyroScale, s.raw[5] / config.gyroScale, s.raw[6] / config.gyroScale);
+			textBytes += written > 0 ? (uint64_t)written : 0U;
+		}
+		return CAPTURE_BATCH;
+	});
+	fclose(text);
+	report("text, fprintf", result, (double)textBytes / (double)(result.ops + CAPTURE_BATCH));
+
+	for (bool direct : { true, false })
+	{
+		bool isDirect = false;
+		result = benchRun([&]() {
+			MPU6050_CaptureWriter writer(CAPTURE_PATH, config, MPU6050_CAPTURE_BLOCK_SIZE, direct);
+			isDirect = writer.isDirect();
+			for (unsigned int i = 0; i < CAPTURE_RECORDS; i += CAPTURE_BATCH) writer.append(&samples[i], CAPTURE_BATCH);
+			writer.close();
+			return CAPTURE_RECORDS;
+		});
+		snprintf(name, sizeof(name), "writer, %s", isDirect ? "O_DIRECT" : "buffered");
+		report(name, result, (double)sizeof(MPU6050_Sample));
+	}
+
+	MPU6050_CaptureReader reader(CAPTURE_PATH);
+
+	result = benchRun([&]() {
+		uint64_t index = 0;
+		unsigned int contiguous;
+		const MPU6050_Sample* run;
+		while ((run = reader.records(index, contiguous)) != nullptr)
+		{
+			for (unsigned int i = 0; i < contiguous; i++) sink += (uint64_t)run[i].raw[MPU6050_GZ];
+			index += contiguous;
+		}
+		return (unsigned int)index;
+	});
+	report("reader, sequential", result, (double)sizeof(MPU6050_Sample));
+
+	for (unsigned int i = 0; i < CAPTURE_SEEKS; i++) seeks[i] = generator() % ((uint64_t)CAPTURE_RECORDS * CAPTURE_PERIOD_NS);
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < CAPTURE_SEEKS; i++) sink += reader.find(seeks[i]);
+		return CAPTURE_SEEKS;
+	});
+	benchReport("reader, find", result, "seek");
+
+	result = benchRun([&]() {
+		uint64_t first;
+		for (unsigned int i = 0; i < CAPTURE_SEEKS; i++) sink += reader.findRange(seeks[i], seeks[i] + 100U * CAPTURE_PERIOD_NS, first) + first;
+		return CAPTURE_SEEKS;
+	});
+	benchReport("reader, findRange (100 records)", result, "seek");
+
+	remove(CAPTURE_PATH);
+	return sink == 12345U ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: DMP firmware upload time, bank sized bursts against 16 byte writes
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Uploads per second and kernel crossings per upload on the simulated bus
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Simulated.h"
+#include <vector>
+
+#define DMP_SMALL_CHUNK		16U		// the block size of the usual MotionApps loaders
+
+/*
+* The image contents do not matter to the simulated DMP, only the size and start address of the real images do
+*/
+static void run(const char* _bus, const UNR_SimLatency& _latency, const char* _image, unsigned int _size, unsigned short _startAddress)
+{
+	MPU6050_Simulated device;
+	std::vector<unsigned char> image(_size);
+	char name[64];
+	uint64_t transfers;
+	BenchResult result;
+	// the warm up call of benchRun() is not in result.ops but went over the bus
+	auto crossings = [&]() { return (double)(device.transport().getTransfers() - transfers) / (double)(result.ops + 1U); };
+
+	for (unsigned int i = 0; i < _size; i++) image[i] = (unsigned char)(i * 13U + 7U);
+	device.initialize();
+	device.transport().setLatency(_latency);
+
+	transfers = device.transport().getTransfers();
+	result = benchRun([&]() {
+		return device.loadDMPFirmware(image.data(), _size, _startAddress) == 1 ? 1U : 0U;
+	});
+	snprintf(name, sizeof(name), "%s: %s, load + verify", _bus, _image);
+	benchReport(name, result, "upload", crossings(), "crossings/upload");
+
+	transfers = device.transport().getTransfers();
+	result = benchRun([&]() {
+		return device.writeDMPMemory(image.data(), _size) == 1 ? 1U : 0U;
+	});
+	snprintf(name, sizeof(name), "%s: %s, bank bursts", _bus, _image);
+	benchReport(name, result, "upload", crossings(), "crossings/upload");
+
+	transfers = device.transport().getTransfers();
+	result = benchRun([&]() {
+		for (unsigned int done = 0; done < _size; done += DMP_SMALL_CHUNK)
+		{
+			unsigned int length = (_size - done > DMP_SMALL_CHUNK) ? DMP_SMALL_CHUNK : _size - done;
+			if (device.writeDMPMemory(&image[done], length, (unsigned short)done) != 1) return 0U;
+		}
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: %s, %u byte writes", _bus, _image, DMP_SMALL_CHUNK);
+	benchReport(name, result, "upload", crossings(), "crossings/upload");
+}
+
+int main(void)
+{
+	run("no latency", UNR_SIM_LATENCY_NONE, "MotionApps 2.0", MPU6050_DMP_MOTIONAPPS20_SIZE, MPU6050_DMP_MOTIONAPPS20_START_ADDRESS);
+	run("no latency", UNR_SIM_LATENCY_NONE, "MotionApps 6.12", MPU6050_DMP_MOTIONAPPS612_SIZE, MPU6050_DMP_MOTIONAPPS612_START_ADDRESS);
+	run("400 kHz", UNR_SIM_LATENCY_I2C_400K, "MotionApps 2.0", MPU6050_DMP_MOTIONAPPS20_SIZE, MPU6050_DMP_MOTIONAPPS20_START_ADDRESS);
+	run("400 kHz", UNR_SIM_LATENCY_I2C_400K, "MotionApps 6.12", MPU6050_DMP_MOTIONAPPS612_SIZE, MPU6050_DMP_MOTIONAPPS612_START_ADDRESS);
+	return 0;
+}
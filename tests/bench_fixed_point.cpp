@@ -0,0 +1,115 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Fixed point conversion (Q15, Q16.16) against the double conversion
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Time per sample of the conversion alone and of the whole read on the simulated bus
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Simulated.h"
+#include <vector>
+
+#define CONVERT_SAMPLES		1024U
+
+/*
+* The conversion of getDoubleSensorValues() before the multiply only path: three divides and a temperature divide
+*/
+static void divideDouble(const MPU6050_Sample& _sample, double* accel, double* gyro, double* temperature, double _accelScale, double _gyroScale)
+{
+	accel[0] = (double)_sample.raw[MPU6050_AX] / _accelScale;
+	accel[1] = (double)_sample.raw[MPU6050_AY] / _accelScale;
+	accel[2] = (double)_sample.raw[MPU6050_AZ] / _accelScale;
+	temperature[0] = (double)_sample.raw[MPU6050_TEMP] / 340.00 + 36.53;
+	gyro[0] = (double)_sample.raw[MPU6050_GX] / _gyroScale;
+	gyro[1] = (double)_sample.raw[MPU6050_GY] / _gyroScale;
+	gyro[2] = (double)_sample.raw[MPU6050_GZ] / _gyroScale;
+}
+
+int main(void)
+{
+	MPU6050_Simulated device;
+	std::vector<MPU6050_Sample> samples(CONVERT_SAMPLES);
+	double accel[3], gyro[3], temperature, sink = 0.0;
+	int32_t accelQ16[3], gyroQ16[3], temperatureQ16;
+	int16_t accelQ15[3], gyroQ15[3], temperatureQ15;
+	int64_t fixedSink = 0;
+	BenchResult result;
+
+	device.initialize();
+	for (unsigned int i = 0; i < CONVERT_SAMPLES; i++)
+	{
+		device.step(1);
+		device.getSample(samples[i]);
+	}
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < CONVERT_SAMPLES; i++)
+		{
+			divideDouble(samples[i], accel, gyro, &temperature, device.getAccelScale(), device.getGyroScale());
+			sink += accel[0] + gyro[2] + temperature;
+		}
+		return CONVERT_SAMPLES;
+	});
+	benchReport("double, divide", result, "sample");
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < CONVERT_SAMPLES; i++)
+		{
+			device.toDouble(samples[i], accel, gyro, &temperature);
+			sink += accel[0] + gyro[2] + temperature;
+		}
+		return CONVERT_SAMPLES;
+	});
+	benchReport("double, toDouble", result, "sample");
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < CONVERT_SAMPLES; i++)
+		{
+			device.toFixed<MPU6050_Q16_16>(samples[i], accelQ16, gyroQ16, &temperatureQ16);
+			fixedSink += accelQ16[0] + gyroQ16[2] + temperatureQ16;
+		}
+		return CONVERT_SAMPLES;
+	});
+	benchReport("Q16.16, toFixed", result, "sample");
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < CONVERT_SAMPLES; i++)
+		{
+			device.toFixed<MPU6050_Q15>(samples[i], accelQ15, gyroQ15, &temperatureQ15);
+			fixedSink += accelQ15[0] + gyroQ15[2] + temperatureQ15;
+		}
+		return CONVERT_SAMPLES;
+	});
+	benchReport("Q15, toFixed", result, "sample");
+
+	// whole read on the simulated bus: transfer, decode, conversion
+	result = benchRun([&]() {
+		device.getDoubleSensorValues(accel, gyro, &temperature);
+		sink += accel[0];
+		return 1U;
+	});
+	benchReport("getDoubleSensorValues (simulated bus)", result, "sample");
+
+	result = benchRun([&]() {
+		device.getFixedSensorValues<MPU6050_Q16_16>(accelQ16, gyroQ16, &temperatureQ16);
+		fixedSink += accelQ16[0];
+		return 1U;
+	});
+	benchReport("getFixedSensorValues Q16.16 (simulated bus)", result, "sample");
+
+	return (sink == 0.12345 || fixedSink == 12345) ? 1 : 0;
+}
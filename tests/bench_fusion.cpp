@@ -0,0 +1,91 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Orientation updates per second per filter on one core
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Complementary, Madgwick and Mahony, quaternion only and with Euler angles
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Fusion.h"
+#include <math.h>
+#include <vector>
+
+#define FUSION_SAMPLES		1024U
+#define FUSION_RATE_HZ		1000U
+
+static const struct { MPU6050_FusionFilter filter; const char* name; } filters[] = {
+	{ MPU6050_FUSION_COMPLEMENTARY, "complementary" },
+	{ MPU6050_FUSION_MADGWICK, "Madgwick" },
+	{ MPU6050_FUSION_MAHONY, "Mahony" },
+};
+
+int main(void)
+{
+	std::vector<float> ax(FUSION_SAMPLES), ay(FUSION_SAMPLES), az(FUSION_SAMPLES), temp(FUSION_SAMPLES);
+	std::vector<float> gx(FUSION_SAMPLES), gy(FUSION_SAMPLES), gz(FUSION_SAMPLES);
+	std::vector<float> qw(FUSION_SAMPLES), qx(FUSION_SAMPLES), qy(FUSION_SAMPLES), qz(FUSION_SAMPLES);
+	std::vector<float> roll(FUSION_SAMPLES), pitch(FUSION_SAMPLES), yaw(FUSION_SAMPLES);
+	std::vector<uint64_t> timestamps(FUSION_SAMPLES), stamped(FUSION_SAMPLES);
+	MPU6050_SoA in = { ax.data(), ay.data(), az.data(), temp.data(), gx.data(), gy.data(), gz.data() };
+	MPU6050_OrientationSoA quaternionOnly = { qw.data(), qx.data(), qy.data(), qz.data(), nullptr, nullptr, nullptr, nullptr };
+	MPU6050_OrientationSoA withEuler = { qw.data(), qx.data(), qy.data(), qz.data(), roll.data(), pitch.data(), yaw.data(), stamped.data() };
+	char name[64];
+	double sink = 0.0;
+	uint64_t batch = 0;
+	BenchResult result;
+
+	// a slow tilt with gyro rates to match, the filters do the same work for any plausible input
+	for (unsigned int i = 0; i < FUSION_SAMPLES; i++)
+	{
+		float angle = 0.5f * sinf((float)i * 0.01f);
+		ax[i] = sinf(angle);
+		ay[i] = 0.0f;
+		az[i] = cosf(angle);
+		temp[i] = 25.0f;
+		gx[i] = 0.1f;
+		gy[i] = 0.5f * cosf((float)i * 0.01f) * 0.01f * (float)FUSION_RATE_HZ * (180.0f / (float)M_PI);
+		gz[i] = -0.2f;
+	}
+	printf("batch preparation: %s\n", MPU6050_Fusion::preparePath());
+
+	for (const auto& entry : filters)
+	{
+		MPU6050_Fusion fusion(entry.filter, 1.0f / (float)FUSION_RATE_HZ);
+
+		result = benchRun([&]() {
+			unsigned int count = fusion.update(in, nullptr, FUSION_SAMPLES, quaternionOnly);
+			sink += qw[FUSION_SAMPLES - 1U];
+			return count;
+		});
+		snprintf(name, sizeof(name), "%s, quaternion", entry.name);
+		benchReport(name, result, "update");
+
+		fusion.reset();
+		result = benchRun([&]() {
+			unsigned int count;
+			for (unsigned int i = 0; i < FUSION_SAMPLES; i++)
+				timestamps[i] = (batch * FUSION_SAMPLES + i + 1U) * (1000000000ULL / FUSION_RATE_HZ);
+			batch++;
+			count = fusion.update(in, timestamps.data(), FUSION_SAMPLES, withEuler);
+			sink += roll[FUSION_SAMPLES - 1U];
+			return count;
+		});
+		snprintf(name, sizeof(name), "%s, timestamps + Euler angles", entry.name);
+		benchReport(name, result, "update");
+	}
+	return sink == 0.12345 ? 1 : 0;
+}
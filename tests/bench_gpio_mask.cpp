@@ -0,0 +1,133 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: GPIO toggles per second on the memory backed register page
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Per pin output_gpio() against bank mask writes, UNR_GpioPin and UNR_GpioChip
+*/
+
+
+#include "bench.h"
+#include "UNR_BCM2711_GpioChip.h"
+
+#define BENCH_TOGGLES		4096U
+#define BUS_SHIFT			4U				// 8 bit parallel bus on GPIO 4-11
+#define BUS_MASK			(0xFFU << BUS_SHIFT)
+
+static volatile unsigned int g_sink;
+
+/*
+* The stores land in ordinary memory, so these are the CPU costs of the access paths. On the Pi the peripheral
+* write latency comes on top, equally for every path.
+*/
+int main(void)
+{
+	UNR_GpioChip chip{UNR_GpioMemoryBacked()};
+	UNR_GpioPin<17> pin(chip, OUTPUT);
+	UNR_GpioIndirectPin<17> indirectPin(chip, OUTPUT);
+	BenchResult result;
+
+	if (setup_fake() != SETUP_OK)
+	{
+		printf("setup_fake failed\n");
+		return 1;
+	}
+	for (int gpio = BUS_SHIFT; gpio < (int)BUS_SHIFT + 8; gpio++) setup_gpio(gpio, OUTPUT, PUD_OFF);
+	setup_gpio(17, OUTPUT, PUD_OFF);
+
+	// single pin
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < BENCH_TOGGLES; i += 2U)
+		{
+			output_gpio(17, 1);
+			output_gpio(17, 0);
+		}
+		return BENCH_TOGGLES;
+	});
+	benchReport("pin: output_gpio()", result, "toggle");
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < BENCH_TOGGLES; i += 2U)
+		{
+			gpio_write_mask(0, 1U << 17, 0);
+			gpio_write_mask(0, 0, 1U << 17);
+		}
+		return BENCH_TOGGLES;
+	});
+	benchReport("pin: gpio_write_mask()", result, "toggle");
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < BENCH_TOGGLES; i += 2U)
+		{
+			pin.set();
+			pin.clear();
+		}
+		return BENCH_TOGGLES;
+	});
+	benchReport("pin: UNR_GpioPin<17>", result, "toggle");
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < BENCH_TOGGLES; i += 2U)
+		{
+			indirectPin.set();
+			indirectPin.clear();
+		}
+		return BENCH_TOGGLES;
+	});
+	benchReport("pin: UNR_GpioIndirectPin<17>", result, "toggle");
+
+	// one byte on the parallel bus, every bit updated
+	result = benchRun([&]() {
+		for (unsigned int value = 0; value < BENCH_TOGGLES; value++)
+			for (int bit = 0; bit < 8; bit++) output_gpio((int)BUS_SHIFT + bit, (value >> bit) & 1U);
+		return BENCH_TOGGLES;
+	});
+	benchReport("byte: 8 x output_gpio()", result, "byte");
+
+	result = benchRun([&]() {
+		for (unsigned int value = 0; value < BENCH_TOGGLES; value++)
+			gpio_write_value(0, BUS_MASK, (value & 0xFFU) << BUS_SHIFT);
+		return BENCH_TOGGLES;
+	});
+	benchReport("byte: gpio_write_value()", result, "byte");
+
+	result = benchRun([&]() {
+		for (unsigned int value = 0; value < BENCH_TOGGLES; value++)
+			chip.writeValue(0, BUS_MASK, (value & 0xFFU) << BUS_SHIFT);
+		return BENCH_TOGGLES;
+	});
+	benchReport("byte: UNR_GpioChip::writeValue()", result, "byte");
+
+	// read back
+	result = benchRun([&]() {
+		unsigned int high = 0;
+		for (unsigned int i = 0; i < BENCH_TOGGLES; i++)
+			for (int bit = 0; bit < 8; bit++) high += (unsigned int)input_gpio((int)BUS_SHIFT + bit);
+		g_sink = high;
+		return BENCH_TOGGLES;
+	});
+	benchReport("read byte: 8 x input_gpio()", result, "byte");
+
+	result = benchRun([&]() {
+		unsigned int high = 0;
+		for (unsigned int i = 0; i < BENCH_TOGGLES; i++) high += (gpio_read_bank(0) & BUS_MASK) >> BUS_SHIFT;
+		g_sink = high;
+		return BENCH_TOGGLES;
+	});
+	benchReport("read byte: gpio_read_bank()", result, "byte");
+
+	cleanup();
+	return 0;
+}
@@ -0,0 +1,84 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Chunked bulk register read / write throughput per chunk size
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Pages per second and kernel crossings per page on the simulated adapter
+*/
+
+
+#include "bench.h"
+#include "UNR_SimTransport.h"
+#include "UNR_BCM2711_I2CHandle.h"
+
+#define BULK_BYTES			256U		// the whole 8 bit register space, one EEPROM page
+#define EEPROM_ADDRESS		0x50
+
+/*
+* 256 byte register file with a wrapping pointer, an EEPROM page / firmware RAM stand in
+*/
+class MemoryDevice : public UNR_SimDevice
+{
+private:
+	unsigned char m_memory[256];
+
+public:
+	MemoryDevice(void) { for (unsigned int i = 0; i < sizeof(m_memory); i++) m_memory[i] = (unsigned char)i; }
+	unsigned char readRegister(unsigned char _register) override { return m_memory[_register]; }
+	void writeRegister(unsigned char _register, unsigned char _value) override { m_memory[_register] = _value; }
+};
+
+static void run(const char* _bus, const UNR_SimLatency& _latency)
+{
+	static const unsigned short chunks[] = { 16U, UNR_I2C_DEFAULT_CHUNK_BYTES, 64U, 128U, 255U };
+	UNR_SimTransport adapter(_latency);
+	MemoryDevice memory;
+	UNR_I2CHandle handle(adapter, EEPROM_ADDRESS);
+	static unsigned char data[BULK_BYTES];
+	char name[64];
+	uint64_t transfers;
+	BenchResult result;
+	// the warm up call of benchRun() is not in result.ops but went over the bus
+	auto crossings = [&]() { return (double)(adapter.getTransfers() - transfers) / (double)(result.ops + 1U); };
+
+	adapter.attach(EEPROM_ADDRESS, &memory);
+	for (unsigned short chunk : chunks)
+	{
+		handle.i2c_setChunkSize(chunk);
+
+		transfers = adapter.getTransfers();
+		result = benchRun([&]() {
+			handle.i2c_readBulk(data, 0x00, BULK_BYTES);
+			return 1U;
+		});
+		snprintf(name, sizeof(name), "%s: read, %u byte chunks", _bus, chunk);
+		benchReport(name, result, "page", crossings(), "crossings/page");
+
+		transfers = adapter.getTransfers();
+		result = benchRun([&]() {
+			handle.i2c_writeBulk(data, 0x00, BULK_BYTES);
+			return 1U;
+		});
+		snprintf(name, sizeof(name), "%s: write, %u byte chunks", _bus, chunk);
+		benchReport(name, result, "page", crossings(), "crossings/page");
+	}
+}
+
+int main(void)
+{
+	run("no latency", UNR_SIM_LATENCY_NONE);
+	run("400 kHz", UNR_SIM_LATENCY_I2C_400K);
+	return 0;
+}
@@ -0,0 +1,88 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Aggregate transactions per second of 1, 2 and 4 devices sharing one UNR_I2CBus
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: One thread per device on the simulated adapter
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Simulated.h"
+#include "UNR_BCM2711_I2CBus.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define BUS_MAX_DEVICES		4U
+
+/*
+* Every device reads its sample window with one combined transaction in a loop of its own thread. The bus lock
+* serializes them, so with the 400 kHz model the aggregate rate stays at what the wire allows while the lock
+* overhead shows in the no latency rows.
+*/
+static void run(const char* _bus, const UNR_SimLatency& _latency, unsigned int _devices)
+{
+	UNR_SimTransport adapter(_latency);
+	UNR_I2CBus bus(adapter);
+	MPU6050_Model models[BUS_MAX_DEVICES];
+	std::vector<std::thread> threads;
+	std::atomic<bool> stop(false);
+	std::atomic<uint64_t> ops(0), errors(0);
+	uint64_t start, cpuStart;
+	BenchResult result;
+	char name[64];
+
+	for (unsigned int d = 0; d < _devices; d++) adapter.attach((unsigned char)(MPU6050_DEVICE_ADDRESS + d), &models[d]);
+
+	start = benchClock(CLOCK_MONOTONIC);
+	cpuStart = benchClock(CLOCK_PROCESS_CPUTIME_ID);
+	for (unsigned int d = 0; d < _devices; d++)
+	{
+		threads.emplace_back([&, d]() {
+			UNR_I2CHandle handle(bus, (unsigned char)(MPU6050_DEVICE_ADDRESS + d));
+			unsigned char data[MPU6050_FIFO_FRAME_SIZE];
+			unsigned char dataRegister = MPU6050_RA_ACCEL_XOUT_H;
+			uint64_t done = 0, failed = 0;
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				if (handle.i2c_readReg(data[0], dataRegister, MPU6050_FIFO_FRAME_SIZE) < 0) failed++;
+				done++;
+			}
+			ops.fetch_add(done);
+			errors.fetch_add(failed);
+		});
+	}
+	while (benchClock(CLOCK_MONOTONIC) - start < benchBudget_ns())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	stop.store(true);
+	for (std::thread& thread : threads) thread.join();
+	result.elapsed_ns = benchClock(CLOCK_MONOTONIC) - start;
+	result.cpu_ns = benchClock(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+	result.ops = ops.load();
+
+	snprintf(name, sizeof(name), "%s: %u device%s", _bus, _devices, _devices == 1U ? "" : "s");
+	benchReport(name, result, "transaction", (double)errors.load(), "errors");
+}
+
+int main(void)
+{
+	for (unsigned int devices = 1U; devices <= BUS_MAX_DEVICES; devices *= 2U) run("no latency", UNR_SIM_LATENCY_NONE, devices);
+	for (unsigned int devices = 1U; devices <= BUS_MAX_DEVICES; devices *= 2U) run("400 kHz", UNR_SIM_LATENCY_I2C_400K, devices);
+	return 0;
+}
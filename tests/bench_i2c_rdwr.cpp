@@ -0,0 +1,90 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Register reads as write() + read() against combined I2C_RDWR transactions
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Kernel crossings and time per sample on the simulated bus
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Simulated.h"
+
+/*
+* Every transport call stands for one kernel crossing. The 400 kHz latency model adds the wire time of each call,
+* so the saved STOP / START and addressing show up the way they do on the bus.
+*/
+static void run(const char* _bus, const UNR_SimLatency& _latency)
+{
+	MPU6050_Simulated device(MPU6050_DEVICE_ADDRESS, _latency);
+	UNR_I2CHandle handle(device.transport(), MPU6050_DEVICE_ADDRESS);
+	unsigned char data[MPU6050_FIFO_FRAME_SIZE], status = 0;
+	unsigned char dataRegister = MPU6050_RA_ACCEL_XOUT_H, statusRegister = MPU6050_RA_INT_STATUS;
+	char name[64];
+	uint64_t transfers;
+	BenchResult result;
+	// the warm up call of benchRun() is not in result.ops but went over the bus
+	auto crossings = [&]() { return (double)(device.transport().getTransfers() - transfers) / (double)(result.ops + 1U); };
+
+	device.transport().setLatency(UNR_SIM_LATENCY_NONE);
+	device.initialize();
+	device.transport().setLatency(_latency);
+
+	transfers = device.transport().getTransfers();
+	result = benchRun([&]() {
+		handle.i2c_write_simple(dataRegister, 1U);
+		handle.i2c_read_simple(data[0], MPU6050_FIFO_FRAME_SIZE);
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: sample, write() + read()", _bus);
+	benchReport(name, result, "sample", crossings(), "crossings/sample");
+
+	transfers = device.transport().getTransfers();
+	result = benchRun([&]() {
+		handle.i2c_readReg(data[0], dataRegister, MPU6050_FIFO_FRAME_SIZE);
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: sample, I2C_RDWR", _bus);
+	benchReport(name, result, "sample", crossings(), "crossings/sample");
+
+	// INT_STATUS and the sample window, the read a data ready poll does
+	transfers = device.transport().getTransfers();
+	result = benchRun([&]() {
+		handle.i2c_write_simple(statusRegister, 1U);
+		handle.i2c_read_simple(status, 1U);
+		handle.i2c_write_simple(dataRegister, 1U);
+		handle.i2c_read_simple(data[0], MPU6050_FIFO_FRAME_SIZE);
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: status + sample, write() + read()", _bus);
+	benchReport(name, result, "sample", crossings(), "crossings/sample");
+
+	transfers = device.transport().getTransfers();
+	result = benchRun([&]() {
+		handle.i2c_queueReadReg(status, statusRegister, 1U);
+		handle.i2c_queueReadReg(data[0], dataRegister, MPU6050_FIFO_FRAME_SIZE);
+		handle.i2c_submit();
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: status + sample, one batch", _bus);
+	benchReport(name, result, "sample", crossings(), "crossings/sample");
+}
+
+int main(void)
+{
+	run("no latency", UNR_SIM_LATENCY_NONE);
+	run("400 kHz", UNR_SIM_LATENCY_I2C_400K);
+	return 0;
+}
@@ -0,0 +1,122 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Max speed replay throughput through the MPU6050_RaspbPi read paths and into the fusion stage
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Samples per second polled, from the FIFO and replay -> fusion
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Replay.h"
+#include "MPU6050_Fusion.h"
+#include <math.h>
+#include <vector>
+
+#define REPLAY_PATH			"bench_replay.cap"
+#define REPLAY_RECORDS		(64U * 1024U)
+#define REPLAY_PERIOD_NS	1000000ULL		// recorded at 1 kHz
+#define REPLAY_BATCH		64U				// frames per FIFO drain
+
+/*
+* A slow tilt about X, gravity on Y / Z and the matching gyro rate
+*/
+static bool writeCapture(void)
+{
+	MPU6050_CaptureConfig config = { MPU6050_ACCEL_FS_2_SCALE, MPU6050_GYRO_FS_250_SCALE, 1000U, MPU6050_DEVICE_ADDRESS, { 0, 0, 0 } };
+	MPU6050_Sample sample = {};
+
+	MPU6050_CaptureWriter writer(REPLAY_PATH, config, MPU6050_CAPTURE_BLOCK_SIZE, false);
+	for (unsigned int i = 0; i < REPLAY_RECORDS; i++)
+	{
+		double angle = 0.5 * sin((double)i * 0.001);
+		sample.raw[MPU6050_AY] = (int16_t)(sin(angle) * MPU6050_ACCEL_FS_2_SCALE);
+		sample.raw[MPU6050_AZ] = (int16_t)(cos(angle) * MPU6050_ACCEL_FS_2_SCALE);
+		sample.raw[MPU6050_GX] = (int16_t)(0.5 * cos((double)i * 0.001) * 57.29578 * MPU6050_GYRO_FS_250_SCALE);
+		sample.timestamp = (uint64_t)(i + 1U) * REPLAY_PERIOD_NS;
+		sample.sequence = i;
+		if (writer.append(&sample, 1U) < 0) return false;
+	}
+	return writer.close() >= 0;
+}
+
+int main(void)
+{
+	MPU6050_Sample sample, batch[REPLAY_BATCH];
+	double accel[3], gyro[3], temperature, sink = 0.0;
+	float ax[REPLAY_BATCH], ay[REPLAY_BATCH], az[REPLAY_BATCH], temp[REPLAY_BATCH], gx[REPLAY_BATCH], gy[REPLAY_BATCH], gz[REPLAY_BATCH];
+	float qw[REPLAY_BATCH], qx[REPLAY_BATCH], qy[REPLAY_BATCH], qz[REPLAY_BATCH];
+	uint64_t timestamps[REPLAY_BATCH];
+	MPU6050_SoA in = { ax, ay, az, temp, gx, gy, gz };
+	MPU6050_OrientationSoA out = { qw, qx, qy, qz, nullptr, nullptr, nullptr, nullptr };
+	BenchResult result;
+
+	if (!writeCapture()) return 1;
+	{
+		MPU6050_Replay replay(REPLAY_PATH, MPU6050_REPLAY_MAX_SPEED, true);
+		replay.initialize();
+
+		result = benchRun([&]() {
+			replay.getSample(sample);
+			sink += sample.raw[MPU6050_AZ];
+			return 1U;
+		});
+		benchReport("polled, getSample", result, "sample");
+
+		result = benchRun([&]() {
+			replay.getDoubleSensorValues(accel, gyro, &temperature);
+			sink += accel[2];
+			return 1U;
+		});
+		benchReport("polled, getDoubleSensorValues", result, "sample");
+	}
+	{
+		MPU6050_Replay replay(REPLAY_PATH, MPU6050_REPLAY_MAX_SPEED, true);
+		replay.initialize();
+		replay.enableFIFO();
+
+		result = benchRun([&]() {
+			int frames = replay.getFIFOSamples(batch, REPLAY_BATCH);
+			sink += batch[0].raw[MPU6050_AZ];
+			return frames > 0 ? (unsigned int)frames : 0U;
+		});
+		benchReport("FIFO, getFIFOSamples", result, "sample");
+
+		// the processing chain a recording is replayed into: scale to floats, fusion on the recorded timestamps
+		MPU6050_Fusion fusion(MPU6050_FUSION_MADGWICK, (float)(REPLAY_PERIOD_NS * 1e-9));
+		const float accelInv = (float)(1.0 / replay.getAccelScale()), gyroInv = (float)(1.0 / replay.getGyroScale());
+		result = benchRun([&]() {
+			int frames = replay.getFIFOSamples(batch, REPLAY_BATCH);
+			if (frames <= 0) return 0U;
+			for (int i = 0; i < frames; i++)
+			{
+				ax[i] = (float)batch[i].raw[MPU6050_AX] * accelInv;
+				ay[i] = (float)batch[i].raw[MPU6050_AY] * accelInv;
+				az[i] = (float)batch[i].raw[MPU6050_AZ] * accelInv;
+				temp[i] = 0.0f;
+				gx[i] = (float)batch[i].raw[MPU6050_GX] * gyroInv;
+				gy[i] = (float)batch[i].raw[MPU6050_GY] * gyroInv;
+				gz[i] = (float)batch[i].raw[MPU6050_GZ] * gyroInv;
+				timestamps[i] = batch[i].timestamp;
+			}
+			fusion.update(in, timestamps, (unsigned int)frames, out);
+			sink += qw[0];
+			return (unsigned int)frames;
+		});
+		benchReport("FIFO -> Madgwick fusion", result, "sample");
+	}
+	remove(REPLAY_PATH);
+	return sink == 0.12345 ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Per sample decode cost of MPU6050_Sample and allocations on the read path
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: bswap decode and multiply only conversion against the byte swap, two's complement and divide path
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Simulated.h"
+#include <new>
+#include <vector>
+
+#define DECODE_SAMPLES		1024U
+
+// heap allocations of the whole program, the read path has to leave it unchanged
+static uint64_t g_allocations = 0;
+
+void* operator new(size_t _size)
+{
+	void* memory;
+	g_allocations++;
+	if ((memory = malloc(_size ? _size : 1U)) == nullptr) throw std::bad_alloc();
+	return memory;
+}
+void* operator new[](size_t _size) { return operator new(_size); }
+void operator delete(void* _memory) noexcept { free(_memory); }
+void operator delete[](void* _memory) noexcept { free(_memory); }
+void operator delete(void* _memory, size_t) noexcept { free(_memory); }
+void operator delete[](void* _memory, size_t) noexcept { free(_memory); }
+
+/*
+* The conversion the driver did before MPU6050_Sample: byte swap, branchy two's complement, one divide per value
+*/
+#define SWAP_BYTES(X)	(((0x00FF & X)<<8) | ((0xFF00 & X) >> 8))
+
+static signed int f2sComplement(uint16_t _in)
+{
+	if (_in >= 0b1000000000000000)
+	{
+		_in = ~(_in);
+		_in = _in + 0b0000000000000001;
+		return (0 - _in);
+	}
+	return _in;
+}
+
+static void legacyDecode(const uint16_t* _raw, double* accel, double* gyro, double* temperature, double _accelScale, double _gyroScale)
+{
+	uint16_t value[MPU6050_CHANNELS];
+	for (unsigned int i = 0; i < MPU6050_CHANNELS; i++) value[i] = (uint16_t)SWAP_BYTES(_raw[i]);
+	accel[0] = (double)f2sComplement(value[0]) / _accelScale;
+	accel[1] = (double)f2sComplement(value[1]) / _accelScale;
+	accel[2] = (double)f2sComplement(value[2]) / _accelScale;
+	temperature[0] = (double)f2sComplement(value[3]) / 340.00 + 36.53;
+	gyro[0] = (double)f2sComplement(value[4]) / _gyroScale;
+	gyro[1] = (double)f2sComplement(value[5]) / _gyroScale;
+	gyro[2] = (double)f2sComplement(value[6]) / _gyroScale;
+}
+
+int main(void)
+{
+	MPU6050_Simulated device;
+	std::vector<MPU6050_Sample> wire(DECODE_SAMPLES), samples(DECODE_SAMPLES);
+	double accel[3], gyro[3], temperature, sink = 0.0;
+	uint64_t allocations, reads = 0;
+	BenchResult result;
+
+	device.initialize();
+	for (unsigned int i = 0; i < DECODE_SAMPLES; i++)
+	{
+		device.step(1);
+		device.getSample(samples[i]);
+		wire[i] = samples[i];
+		for (unsigned int c = 0; c < MPU6050_CHANNELS; c++)
+			wire[i].raw[c] = (int16_t)__builtin_bswap16((uint16_t)wire[i].raw[c]);	// back to the bus byte order
+	}
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < DECODE_SAMPLES; i++)
+		{
+			legacyDecode((const uint16_t*)wire[i].raw, accel, gyro, &temperature, MPU6050_ACCEL_FS_2_SCALE, MPU6050_GYRO_FS_250_SCALE);
+			sink += accel[0] + gyro[2] + temperature;
+		}
+		return DECODE_SAMPLES;
+	});
+	benchReport("swap, two's complement, divide", result, "sample");
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < DECODE_SAMPLES; i++)
+		{
+			samples[i] = wire[i];
+			MPU6050_decodeSample(samples[i]);
+			sink += samples[i].raw[MPU6050_AX];
+		}
+		return DECODE_SAMPLES;
+	});
+	benchReport("MPU6050_decodeSample", result, "sample");
+
+	result = benchRun([&]() {
+		for (unsigned int i = 0; i < DECODE_SAMPLES; i++)
+		{
+			samples[i] = wire[i];
+			MPU6050_decodeSample(samples[i]);
+			device.toDouble(samples[i], accel, gyro, &temperature);
+			sink += accel[0] + gyro[2] + temperature;
+		}
+		return DECODE_SAMPLES;
+	});
+	benchReport("MPU6050_decodeSample + toDouble", result, "sample");
+
+	// whole read path on the simulated bus: transfer, decode, conversion
+	allocations = g_allocations;
+	result = benchRun([&]() {
+		device.getDoubleSensorValues(accel, gyro, &temperature);
+		sink += accel[0];
+		reads++;
+		return 1U;
+	});
+	benchReport("getDoubleSensorValues (simulated bus)", result, "sample",
+				(double)(g_allocations - allocations) / (double)reads, "allocations/sample");
+
+	allocations = g_allocations;
+	reads = 0;
+	result = benchRun([&]() {
+		device.getSample(samples[0]);
+		sink += samples[0].raw[MPU6050_GZ];
+		reads++;
+		return 1U;
+	});
+	benchReport("getSample (simulated bus)", result, "sample", (double)(g_allocations - allocations) / (double)reads, "allocations/sample");
+
+	return sink == 0.12345 ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Whole driver stack on the simulated transports, I2C through MPU6050_RaspbPi and SPI through UNR_SPIHandle
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Samples per second and time per read, polled and FIFO
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Simulated.h"
+#include "UNR_BCM2711_SPIHandle.h"
+
+#define STACK_FIFO_BATCH	64U		// frames per FIFO drain, well inside the 1 KiB FIFO
+
+static double g_sink = 0.0;
+
+/*
+* MPU6050_RaspbPi on the simulated I2C bus. The time per sample of the polled rows is the read latency seen by the
+* caller; the FIFO rows include MPU6050_Model::step() producing the frames.
+*/
+static void runI2C(const char* _bus, const UNR_SimLatency& _latency)
+{
+	MPU6050_Simulated device(MPU6050_DEVICE_ADDRESS, UNR_SIM_LATENCY_NONE);
+	MPU6050_Sample sample, batch[STACK_FIFO_BATCH];
+	double accel[3], gyro[3], temperature;
+	char name[64];
+	BenchResult result;
+
+	device.initialize();
+	device.transport().setLatency(_latency);
+
+	result = benchRun([&]() {
+		device.step(1);
+		device.getSample(sample);
+		g_sink += sample.raw[MPU6050_AX];
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "I2C %s: getSample", _bus);
+	benchReport(name, result, "sample");
+
+	result = benchRun([&]() {
+		device.step(1);
+		device.getDoubleSensorValues(accel, gyro, &temperature);
+		g_sink += accel[0] + gyro[2] + temperature;
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "I2C %s: getDoubleSensorValues", _bus);
+	benchReport(name, result, "sample");
+
+	device.transport().setLatency(UNR_SIM_LATENCY_NONE);
+	device.enableFIFO();
+	device.transport().setLatency(_latency);
+	result = benchRun([&]() {
+		int frames;
+		device.step(STACK_FIFO_BATCH);
+		frames = device.getFIFOSamples(batch, STACK_FIFO_BATCH);
+		g_sink += batch[0].raw[MPU6050_GZ];
+		return frames > 0 ? (unsigned int)frames : 0U;
+	});
+	snprintf(name, sizeof(name), "I2C %s: getFIFOSamples, %u frames", _bus, STACK_FIFO_BATCH);
+	benchReport(name, result, "sample", (double)result.elapsed_ns * 1e-3 / ((double)result.ops / STACK_FIFO_BATCH), "us/drain");
+}
+
+/*
+* The same sample window over SPI: command and answer in one message, then the driver's decode
+*/
+static void runSPI(const char* _bus, const UNR_SimLatency& _latency)
+{
+	UNR_SimTransport bus(_latency);
+	MPU6050_Model model;
+	UNR_SPIHandle handle(bus, 0U, 8U, 1000000U);
+	const unsigned char dataCommand = MPU6050_RA_ACCEL_XOUT_H | UNR_SIM_SPI_READ_FLAG;
+	const unsigned char statusCommand = MPU6050_RA_INT_STATUS | UNR_SIM_SPI_READ_FLAG;
+	unsigned char status = 0;
+	MPU6050_Sample sample;
+	char name[64];
+	BenchResult result;
+
+	bus.attachSPI(&model);
+
+	result = benchRun([&]() {
+		model.step(1);
+		handle.spi_queueTransfer(&dataCommand, nullptr, 1U);
+		handle.spi_queueTransfer(nullptr, (unsigned char*)sample.raw, MPU6050_FIFO_FRAME_SIZE);
+		handle.spi_submit();
+		MPU6050_decodeSample(sample);
+		g_sink += sample.raw[MPU6050_AX];
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "SPI %s: sample window", _bus);
+	benchReport(name, result, "sample");
+
+	result = benchRun([&]() {
+		model.step(1);
+		handle.spi_queueTransfer(&statusCommand, nullptr, 1U);
+		handle.spi_queueTransfer(nullptr, &status, 1U, 0U, 0U, true);
+		handle.spi_queueTransfer(&dataCommand, nullptr, 1U);
+		handle.spi_queueTransfer(nullptr, (unsigned char*)sample.raw, MPU6050_FIFO_FRAME_SIZE);
+		handle.spi_submit();
+		MPU6050_decodeSample(sample);
+		g_sink += sample.raw[MPU6050_AX] + status;
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "SPI %s: status + sample window", _bus);
+	benchReport(name, result, "sample");
+}
+
+int main(void)
+{
+	runI2C("no latency", UNR_SIM_LATENCY_NONE);
+	runI2C("400 kHz", UNR_SIM_LATENCY_I2C_400K);
+	runSPI("no latency", UNR_SIM_LATENCY_NONE);
+	runSPI("1 MHz", UNR_SIM_LATENCY_SPI_1M);
+	return g_sink == 0.5 ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: SPI register reads as write() + read() against one ioctl(SPI_IOC_MESSAGE(n))
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Kernel crossings and transactions per second on the simulated bus
+*/
+
+
+#include "bench.h"
+#include "MPU6050_Simulated.h"
+#include "UNR_BCM2711_SPIHandle.h"
+
+/*
+* Every transport call stands for one kernel crossing, the 1 MHz latency model adds the wire time of each call.
+* The write() + read() rows only show the cost: chip select drops between the calls, so the read clocks in a new
+* command instead of the register contents (what the message API fixes).
+*/
+static void run(const char* _bus, const UNR_SimLatency& _latency)
+{
+	UNR_SimTransport bus(_latency);
+	MPU6050_Model model;
+	UNR_SPIHandle handle(bus, 0U, 8U, 1000000U);
+	unsigned char data[MPU6050_FIFO_FRAME_SIZE + 1U], status = 0;
+	unsigned char tx[MPU6050_FIFO_FRAME_SIZE + 1U] = { 0 };
+	const unsigned char dataCommand = MPU6050_RA_ACCEL_XOUT_H | UNR_SIM_SPI_READ_FLAG;
+	const unsigned char statusCommand = MPU6050_RA_INT_STATUS | UNR_SIM_SPI_READ_FLAG;
+	char name[64];
+	uint64_t transfers;
+	BenchResult result;
+	// the warm up call of benchRun() is not in result.ops but went over the bus
+	auto crossings = [&]() { return (double)(bus.getTransfers() - transfers) / (double)(result.ops + 1U); };
+
+	bus.attachSPI(&model);
+	tx[0] = dataCommand;
+
+	transfers = bus.getTransfers();
+	result = benchRun([&]() {
+		handle.spi_write(dataCommand, 1U);
+		handle.spi_read(data[0], MPU6050_FIFO_FRAME_SIZE);
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: sample, write() + read()", _bus);
+	benchReport(name, result, "transaction", crossings(), "crossings/transaction");
+
+	transfers = bus.getTransfers();
+	result = benchRun([&]() {
+		handle.spi_queueTransfer(&dataCommand, nullptr, 1U);
+		handle.spi_queueTransfer(nullptr, data, MPU6050_FIFO_FRAME_SIZE);
+		handle.spi_submit();
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: sample, one message", _bus);
+	benchReport(name, result, "transaction", crossings(), "crossings/transaction");
+
+	transfers = bus.getTransfers();
+	result = benchRun([&]() {
+		handle.spi_transfer(tx, data, MPU6050_FIFO_FRAME_SIZE + 1U);
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: sample, full duplex segment", _bus);
+	benchReport(name, result, "transaction", crossings(), "crossings/transaction");
+
+	// INT_STATUS and the sample window, the read a data ready poll does
+	transfers = bus.getTransfers();
+	result = benchRun([&]() {
+		handle.spi_write(statusCommand, 1U);
+		handle.spi_read(status, 1U);
+		handle.spi_write(dataCommand, 1U);
+		handle.spi_read(data[0], MPU6050_FIFO_FRAME_SIZE);
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: status + sample, write() + read()", _bus);
+	benchReport(name, result, "transaction", crossings(), "crossings/transaction");
+
+	transfers = bus.getTransfers();
+	result = benchRun([&]() {
+		handle.spi_queueTransfer(&statusCommand, nullptr, 1U);
+		handle.spi_queueTransfer(nullptr, &status, 1U, 0U, 0U, true);
+		handle.spi_queueTransfer(&dataCommand, nullptr, 1U);
+		handle.spi_queueTransfer(nullptr, data, MPU6050_FIFO_FRAME_SIZE);
+		handle.spi_submit();
+		return 1U;
+	});
+	snprintf(name, sizeof(name), "%s: status + sample, one message", _bus);
+	benchReport(name, result, "transaction", crossings(), "crossings/transaction");
+}
+
+int main(void)
+{
+	run("no latency", UNR_SIM_LATENCY_NONE);
+	run("1 MHz", UNR_SIM_LATENCY_SPI_1M);
+	return 0;
+}
@@ -0,0 +1,117 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Sustained SPI stream throughput, blocking spi_stream() against the double buffered UNR_SPIStreamer
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: MB/s and CPU load on the simulated bus
+*/
+
+
+#include "bench.h"
+#include "UNR_SimTransport.h"
+#include "UNR_BCM2711_SPIStreamer.h"
+
+#define STREAM_BLOCK_BYTES	(16U * 1024U)	// several spidev bufsiz chunks per block
+
+// 32 MHz display / ADC link: 8 clocks per byte, driver and DMA setup once per message
+constexpr UNR_SimLatency SPI_32M = { 10000U, 250U };
+
+/*
+* Display style data port: the first byte of a chip select assertion is the command, the rest go to one register.
+*/
+class StreamSink : public UNR_SimDevice
+{
+public:
+	unsigned char readRegister(unsigned char _register) override { return _register; }
+	void writeRegister(unsigned char _register, unsigned char _value) override { (void)_register; (void)_value; }
+	bool autoIncrement(unsigned char _register) const override { (void)_register; return false; }
+};
+
+static volatile unsigned long g_sink;
+
+// the caller side work per block, a generated frame
+static void fill(unsigned char* _block, unsigned int _frame)
+{
+	for (unsigned int i = 0; i < STREAM_BLOCK_BYTES; i++) _block[i] = (unsigned char)(i * 31U + _frame);
+}
+
+static void onReceive(void* _context, const unsigned char* _rx, unsigned long _length)
+{
+	unsigned long sum = 0;
+	(void)_context;
+	for (unsigned long i = 0; i < _length; i++) sum += _rx[i];
+	g_sink = g_sink + sum;
+}
+
+static void report(const char* _bus, const char* _mode, const BenchResult& _result, uint64_t _bytes)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "%s: %s", _bus, _mode);
+	benchReport(name, _result, "block", (double)_bytes / ((double)_result.elapsed_ns * 1e-3), "MB/s");
+}
+
+static void run(const char* _bus, const UNR_SimLatency& _latency)
+{
+	UNR_SimTransport bus(_latency);
+	StreamSink sink;
+	UNR_SPIHandle handle(bus, 0U, 8U, 32000000U);
+	static unsigned char block[STREAM_BLOCK_BYTES];
+	unsigned int frame = 0;
+	uint64_t bytes;
+	BenchResult result;
+
+	bus.attachSPI(&sink);
+
+	// fill, then wait for the bus: nothing overlaps
+	bytes = bus.getBytes();
+	result = benchRun([&]() {
+		fill(block, frame++);
+		handle.spi_stream(block, nullptr, STREAM_BLOCK_BYTES);
+		return 1U;
+	});
+	report(_bus, "spi_stream(), fill then send", result, bus.getBytes() - bytes);
+
+	// the next block is filled while the last one is on the wire
+	{
+		UNR_SPIStreamer streamer(handle, STREAM_BLOCK_BYTES);
+		bytes = streamer.getBytesSent();
+		result = benchRun([&]() {
+			fill(streamer.nextBuffer(), frame++);
+			streamer.submit(STREAM_BLOCK_BYTES);
+			return 1U;
+		});
+		streamer.flush();
+		report(_bus, "UNR_SPIStreamer, transmit", result, streamer.getBytesSent() - bytes);
+	}
+
+	{
+		UNR_SPIStreamer streamer(handle, STREAM_BLOCK_BYTES, onReceive, nullptr);
+		bytes = streamer.getBytesSent();
+		result = benchRun([&]() {
+			fill(streamer.nextBuffer(), frame++);
+			streamer.submit(STREAM_BLOCK_BYTES);
+			return 1U;
+		});
+		streamer.flush();
+		report(_bus, "UNR_SPIStreamer, full duplex", result, streamer.getBytesSent() - bytes);
+	}
+}
+
+int main(void)
+{
+	run("no latency", UNR_SIM_LATENCY_NONE);
+	run("32 MHz", SPI_32M);
+	return 0;
+}
@@ -0,0 +1,97 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Bit exact parity of MPU6050_decodeBlock() with MPU6050_decodeBlockScalar()
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Every count up to a few vector groups, every full scale range, random and extreme raw values
+*/
+
+
+#include "MPU6050_BulkDecoder.h"
+#include "MPU6050_RegisterMap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define PARITY_MAX_COUNT	100U	// covers several groups of the widest path plus every tail length
+#define PARITY_ROUNDS		50U
+
+static const float kAccel[4] = { MPU6050_ACCEL_FS_2_SCALE, MPU6050_ACCEL_FS_4_SCALE, MPU6050_ACCEL_FS_8_SCALE, MPU6050_ACCEL_FS_16_SCALE };
+static const float kGyro[4] = { MPU6050_GYRO_FS_250_SCALE, MPU6050_GYRO_FS_500_SCALE, MPU6050_GYRO_FS_1000_SCALE, MPU6050_GYRO_FS_2000_SCALE };
+static const int16_t kExtremes[] = { -32768, -32767, -1, 0, 1, 32766, 32767, -12420, 12420 };
+
+struct Buffers
+{
+	std::vector<float> data;
+	MPU6050_SoA soa;
+
+	explicit Buffers(unsigned int _count) : data(7U * _count + 7U)
+	{
+		float* p = data.data();
+		soa = { p, p + _count + 1U, p + 2U * (_count + 1U), p + 3U * (_count + 1U), p + 4U * (_count + 1U),
+				p + 5U * (_count + 1U), p + 6U * (_count + 1U) };
+	}
+};
+
+int main(void)
+{
+	unsigned int failures = 0, checked = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__AVX2__)
+	if (!__builtin_cpu_supports("avx2")) { printf("SKIP: %s build on a CPU without AVX2\n", MPU6050_decodeBlockPath()); return 0; }
+#elif defined(__SSSE3__)
+	if (!__builtin_cpu_supports("ssse3")) { printf("SKIP: %s build on a CPU without SSSE3\n", MPU6050_decodeBlockPath()); return 0; }
+#endif
+#endif
+
+	srand(6050);
+	for (unsigned int round = 0; round < PARITY_ROUNDS; round++)
+	{
+		for (unsigned int count = 0; count <= PARITY_MAX_COUNT; count++)
+		{
+			// records end exactly at the end of the allocation, so an over read shows up under AddressSanitizer
+			std::vector<unsigned char> storage(count * MPU6050_RECORD_SIZE + 1U);
+			unsigned char* records = storage.data() + 1U;		// odd address, the vector paths must not need alignment
+			for (unsigned int i = 0; i < count * 7U; i++)
+			{
+				int16_t value = (round & 1U) ? kExtremes[rand() % (int)(sizeof(kExtremes) / sizeof(kExtremes[0]))] : (int16_t)rand();
+				records[2U * i] = (unsigned char)((uint16_t)value >> 8);
+				records[2U * i + 1U] = (unsigned char)value;
+			}
+
+			for (unsigned int range = 0; range < 16U; range++)
+			{
+				Buffers fast(count), scalar(count);
+				float accelInv = 1.0f / kAccel[range & 3U], gyroInv = 1.0f / kGyro[range >> 2];
+				// both sides see the same garbage past the last record, so a write past _count is caught as well
+				memset(fast.data.data(), 0x5A, fast.data.size() * sizeof(float));
+				memset(scalar.data.data(), 0x5A, scalar.data.size() * sizeof(float));
+				MPU6050_decodeBlock(records, count, fast.soa, accelInv, gyroInv);
+				MPU6050_decodeBlockScalar(records, count, scalar.soa, accelInv, gyroInv);
+				checked++;
+				if (memcmp(fast.data.data(), scalar.data.data(), fast.data.size() * sizeof(float)) != 0)
+				{
+					if (failures < 10) printf("FAIL: count %u accel range %u gyro range %u round %u\n", count, range & 3U, range >> 2, round);
+					failures++;
+				}
+			}
+		}
+	}
+
+	printf("%s: %u blocks, %u mismatches\n", MPU6050_decodeBlockPath(), checked, failures);
+	return failures ? 1 : 0;
+}
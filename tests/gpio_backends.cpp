@@ -0,0 +1,179 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: UNR_GpioSimBackend and UNR_GpioTraceBackend behind UNR_GpioChip and UNR_GpioIndirectPin
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Simulated levels, store trace, direct pins refused on a modelled chip
+* Rev 2: Banks other than 0 / 1 rejected by the chip and the gpio functions
+*/
+
+
+#include "UNR_BCM2711_GpioChip.h"
+#include <stdio.h>
+
+extern volatile uint32_t* gpio_map;
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+/*
+* Outputs read back their latch, inputs their driven level or their pull, SET / CLR read as 0
+*/
+static void simulatedLevels(void)
+{
+	UNR_GpioSimBackend* sim = new UNR_GpioSimBackend();
+	UNR_GpioChip chip(sim);
+	UNR_GpioIndirectPin<17> output(chip, OUTPUT);
+	UNR_GpioIndirectPin<45> input(chip, INPUT, PUD_UP);
+	UNR_GpioIndirectPin<27> floating(chip, INPUT);
+
+	CHECK(chip.registers() == nullptr, "modelled chip exposes direct registers");
+	CHECK(!output.read(), "output high before set()");
+	output.set();
+	CHECK(output.read(), "output latch not read back after set()");
+	CHECK(sim->getOutputLatch(0) == (1U << 17), "latch 0x%08x after set()", sim->getOutputLatch(0));
+	CHECK(chip.load(UNR_SET_OFFSET) == 0 && chip.load(UNR_CLR_OFFSET) == 0, "SET / CLR do not read as 0");
+	output.clear();
+	CHECK(!output.read(), "output still high after clear()");
+
+	CHECK(input.read(), "undriven input with pull up reads low");
+	CHECK(!floating.read(), "floating input reads high");
+	sim->driveInput(45, false);
+	CHECK(!input.read(), "input driven low reads high");
+	sim->driveInput(27, true);
+	CHECK(floating.read(), "input driven high reads low");
+	sim->releaseInput(45);
+	CHECK(input.read(), "released input does not follow its pull up");
+
+	// an input ignores the latch, the same pin as output shows it
+	chip.writeMask(0, 1U << 27, 0);
+	sim->releaseInput(27);
+	CHECK(!floating.read(), "input shows the output latch");
+	floating.setup(OUTPUT);
+	CHECK(floating.read(), "output does not show the latch set while it was an input");
+
+	chip.writeValue(1, 0xFFU << 8, 0xA5U << 8);
+	CHECK(sim->getOutputLatch(1) == (0xA5U << 8), "bank 1 latch 0x%08x after writeValue", sim->getOutputLatch(1));
+	chip.store(UNR_PINLEVEL_OFFSET, 0xFFFFFFFFU);
+	CHECK(chip.readBank(0) == ((1U << 27)), "LEV written or wrong levels 0x%08x", chip.readBank(0));
+}
+
+/*
+* Every store reaches the target and is logged in order, past the capacity only counted
+*/
+static void trace(void)
+{
+	UNR_GpioSimBackend* sim = new UNR_GpioSimBackend();
+	UNR_GpioTraceBackend* tracer = new UNR_GpioTraceBackend(sim, 4U);
+	UNR_GpioChip chip(tracer);
+	UNR_GpioIndirectPin<4> pin(chip);
+
+	pin.set();
+	pin.clear();
+	pin.write(true);
+	chip.writeMask(1, 1U << 3, 1U << 4);
+
+	const std::vector<UNR_GpioTraceEntry>& log = tracer->getTrace();
+	CHECK(log.size() == 4U, "%zu entries logged", log.size());
+	if (log.size() == 4U)
+	{
+		CHECK(log[0].offset == UNR_SET_OFFSET && log[0].value == (1U << 4), "entry 0: offset %u value 0x%08x", log[0].offset, log[0].value);
+		CHECK(log[1].offset == UNR_CLR_OFFSET && log[1].value == (1U << 4), "entry 1: offset %u value 0x%08x", log[1].offset, log[1].value);
+		CHECK(log[2].offset == UNR_SET_OFFSET, "entry 2: offset %u", log[2].offset);
+		CHECK(log[3].offset == UNR_SET_OFFSET + 1U && log[3].value == (1U << 3), "entry 3: offset %u value 0x%08x", log[3].offset, log[3].value);
+		CHECK(log[0].timestamp <= log[1].timestamp && log[1].timestamp <= log[2].timestamp && log[2].timestamp <= log[3].timestamp,
+				"timestamps not in order");
+	}
+	CHECK(tracer->getDropped() == 1U, "%llu dropped instead of 1", (unsigned long long)tracer->getDropped());
+	CHECK(sim->getOutputLatch(0) == (1U << 4) && sim->getOutputLatch(1) == (1U << 3), "stores not forwarded to the target");
+	CHECK(&tracer->getTarget() == sim, "target is not the wrapped backend");
+
+	tracer->clearTrace();
+	CHECK(tracer->getTrace().empty() && tracer->getDropped() == 0, "trace not cleared");
+	CHECK(pin.read() == false && tracer->getTrace().empty(), "a load was traced");
+
+	bool thrown = false;
+	try { UNR_GpioTraceBackend orphan(nullptr, 1U); }
+	catch (const std::runtime_error&) { thrown = true; }
+	CHECK(thrown, "trace without a target did not throw");
+}
+
+/*
+* UNR_GpioDirect needs the register page, a direct pin on a modelled chip throws instead of storing nowhere
+*/
+static void directPinRefused(void)
+{
+	UNR_GpioChip chip(new UNR_GpioSimBackend());
+	UNR_GpioChip memory{UNR_GpioMemoryBacked()};
+	bool thrown = false;
+
+	try { UNR_GpioPin<4> pin(chip); (void)pin; }
+	catch (const std::runtime_error&) { thrown = true; }
+	CHECK(thrown, "direct pin accepted a chip without registers");
+
+	// the indirect pin also runs on a plain memory chip
+	UNR_GpioIndirectPin<4> pin(memory, OUTPUT);
+	pin.set();
+	CHECK(memory.registers()[UNR_SET_OFFSET] == (1U << 4), "indirect pin store missing on the memory chip");
+
+	thrown = false;
+	try { UNR_GpioChip none(static_cast<UNR_GpioBackend*>(nullptr)); }
+	catch (const std::runtime_error&) { thrown = true; }
+	CHECK(thrown, "chip without a backend did not throw");
+}
+
+/*
+* A bank past 1 (or a negative one) would store into reserved words or FSEL, nothing may change
+*/
+static void bankRange(void)
+{
+	UNR_GpioChip chip{UNR_GpioMemoryBacked()};
+	uint32_t before[UNR_GPIO_REGISTER_WORDS];
+	bool unchanged = true;
+
+	for (unsigned int i = 0; i < UNR_GPIO_REGISTER_WORDS; i++) chip.registers()[i] = before[i] = 0x5A5A0000U + i;
+	CHECK(chip.writeMask(2, 0xFFFFFFFFU, 0xFFFFFFFFU) == -1, "chip: bank 2 write not rejected");
+	CHECK(chip.writeValue(UNR_GPIO_BANKS + 7U, 0xFFFFFFFFU, 0U) == -1, "chip: bank %u write not rejected", UNR_GPIO_BANKS + 7U);
+	CHECK(chip.readBank(2) == 0U, "chip: bank 2 read 0x%08x", chip.readBank(2));
+	CHECK(chip.writeMask(1, 1U << 3, 0) == 0 && chip.registers()[UNR_SET_OFFSET + 1U] == (1U << 3), "chip: bank 1 write rejected");
+	before[UNR_SET_OFFSET + 1U] = 1U << 3;
+	for (unsigned int i = 0; i < UNR_GPIO_REGISTER_WORDS; i++) unchanged &= chip.registers()[i] == before[i];
+	CHECK(unchanged, "chip: an out of range bank changed the register page");
+
+	if (setup_fake() != SETUP_OK) { CHECK(false, "setup_fake failed"); return; }
+	for (unsigned int i = 0; i < UNR_GPIO_REGISTER_WORDS; i++) gpio_map[i] = before[i];
+	CHECK(gpio_write_mask(2, 0xFFFFFFFFU, 0xFFFFFFFFU) == -1, "gpio_write_mask: bank 2 not rejected");
+	CHECK(gpio_write_mask(-3, 0xFFFFFFFFU, 0xFFFFFFFFU) == -1, "gpio_write_mask: bank -3 not rejected");
+	CHECK(gpio_write_value(-1, 0xFFFFFFFFU, 0x0000FFFFU) == -1, "gpio_write_value: bank -1 not rejected");
+	CHECK(gpio_read_bank(2) == 0U && gpio_read_bank(-1) == 0U, "gpio_read_bank: out of range bank read a register");
+	CHECK(gpio_write_value(0, 0xFFU, 0x0FU) == 0, "gpio_write_value: bank 0 rejected");
+	before[UNR_SET_OFFSET] = 0x0FU;
+	before[UNR_CLR_OFFSET] = 0xF0U;
+	unchanged = true;
+	for (unsigned int i = 0; i < UNR_GPIO_REGISTER_WORDS; i++) unchanged &= gpio_map[i] == before[i];
+	CHECK(unchanged, "gpio functions: an out of range bank changed the register page");
+	cleanup();
+}
+
+int main(void)
+{
+	simulatedLevels();
+	trace();
+	directPinRefused();
+	bankRange();
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Data ready edge events from a pipe standing in for the GPIO line event fd
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: gpio_wait_edge, waitForSample and MPU6050_Acquisition in data ready mode
+* Rev 2: Data ready mode runs without a periodic sampler
+*/
+
+
+#include "MPU6050_Acquisition.h"
+#include "MPU6050_Simulated.h"
+#include "UNR_GPIO_BCM2711.h"
+#include <linux/gpio.h>
+#include <sys/eventfd.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+#define EDGE_EVENTS		500U
+
+static bool writeEdge(int _fd, uint64_t _timestamp)
+{
+	struct gpioevent_data event;
+	memset(&event, 0x00, sizeof(event));
+	event.timestamp = _timestamp;
+	event.id = GPIOEVENT_EVENT_RISING_EDGE;
+	return write(_fd, &event, sizeof(event)) == (ssize_t)sizeof(event);
+}
+
+/*
+* Timeout, one event, a short record and a closed writer
+*/
+static void waitEdge(void)
+{
+	int fds[2];
+	uint64_t edge = 0;
+	int result;
+
+	if (pipe(fds) != 0) { CHECK(false, "pipe failed"); return; }
+	result = gpio_wait_edge(fds[0], 10, &edge);
+	CHECK(result == 0, "no event: returned %d instead of a timeout", result);
+
+	writeEdge(fds[1], 123456789ULL);
+	result = gpio_wait_edge(fds[0], 10, &edge);
+	CHECK(result == 1 && edge == 123456789ULL, "event: returned %d, timestamp %llu", result, (unsigned long long)edge);
+	result = gpio_wait_edge(fds[0], 10, nullptr);
+	CHECK(result == 0, "event delivered twice");
+
+	writeEdge(fds[1], 1ULL);
+	writeEdge(fds[1], 2ULL);
+	CHECK(gpio_wait_edge(fds[0], 10, &edge) == 1 && edge == 1ULL, "first of two queued events");
+	CHECK(gpio_wait_edge(fds[0], 10, &edge) == 1 && edge == 2ULL, "second of two queued events");
+
+	CHECK(write(fds[1], &edge, 4U) == 4, "short write");
+	result = gpio_wait_edge(fds[0], 10, &edge);
+	CHECK(result == -1, "short record: returned %d", result);
+
+	close(fds[1]);
+	result = gpio_wait_edge(fds[0], 10, &edge);
+	CHECK(result == -1, "closed writer: returned %d", result);
+	close(fds[0]);
+}
+
+/*
+* An eventfd is readable but delivers an 8 byte counter, not a gpioevent_data record
+*/
+static void eventFd(void)
+{
+	int fd = eventfd(0, EFD_NONBLOCK);
+	uint64_t edge = 0;
+	int result;
+
+	if (fd < 0) { CHECK(false, "eventfd failed"); return; }
+	CHECK(gpio_wait_edge(fd, 10, &edge) == 0, "idle eventfd did not time out");
+	eventfd_write(fd, 1U);
+	result = gpio_wait_edge(fd, 10, &edge);
+	CHECK(result == -1, "eventfd counter taken as an edge: returned %d", result);
+	close(fd);
+}
+
+/*
+* waitForSample() reads the sample after the edge and stamps it with the edge time
+*/
+static void waitForSample(void)
+{
+	MPU6050_Simulated device;
+	MPU6050_Sample sample, polled;
+	int fds[2];
+	int result;
+
+	if (pipe(fds) != 0) { CHECK(false, "pipe failed"); return; }
+	device.initialize();
+	CHECK(device.enableDataReadyInterrupt() > 0, "enableDataReadyInterrupt failed");
+	CHECK(device.model().readRegister(MPU6050_RA_INT_ENABLE) & (1U << MPU6050_INTERRUPT_DATA_RDY_BIT), "DATA_RDY interrupt not enabled");
+
+	result = device.waitForSample(fds[0], sample, 10);
+	CHECK(result == 0, "no edge: returned %d", result);
+
+	device.step(1);
+	writeEdge(fds[1], 42000ULL);
+	result = device.waitForSample(fds[0], sample, 10);
+	CHECK(result == 1, "edge: returned %d", result);
+	CHECK(sample.timestamp == 42000ULL, "sample stamped %llu instead of the edge time", (unsigned long long)sample.timestamp);
+	device.getSample(polled);
+	CHECK(memcmp(sample.raw, polled.raw, sizeof(polled.raw)) == 0, "sample is not the one in the data registers");
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/*
+* Data ready acquisition thread: every edge gives one sample in the ring with the edge timestamp, in order
+*/
+static void acquisitionDataReady(void)
+{
+	MPU6050_Simulated* device = new MPU6050_Simulated();
+	UNR_SamplerConfig timing = { UNR_SAMPLER_MIN_RATE_HZ, 0, -1, false };
+	MPU6050_Sample sample;
+	unsigned int received = 0, waits = 0;
+	int fds[2];
+
+	if (pipe(fds) != 0) { CHECK(false, "pipe failed"); delete device; return; }
+	device->initialize();
+	MPU6050_Acquisition acquisition(device, timing, UNR_RING_DROP_NEWEST, MPU6050_ACQ_DATA_READY);
+	CHECK(acquisition.start() < 0, "started without a data ready source");
+	acquisition.setDataReadySource(fds[0]);
+	CHECK(acquisition.start() > 0, "acquisition did not start");
+
+	for (unsigned int i = 0; i < EDGE_EVENTS; i++)
+	{
+		writeEdge(fds[1], 1000ULL * (i + 1U));
+		while (acquisition.pop(sample))
+		{
+			CHECK(sample.timestamp == 1000ULL * (received + 1U), "sample %u stamped %llu", received, (unsigned long long)sample.timestamp);
+			received++;
+		}
+	}
+	while (received < EDGE_EVENTS && waits++ < 1000U)
+	{
+		usleep(1000);
+		while (acquisition.pop(sample))
+		{
+			CHECK(sample.timestamp == 1000ULL * (received + 1U), "sample %u stamped %llu", received, (unsigned long long)sample.timestamp);
+			received++;
+		}
+	}
+	CHECK(acquisition.isRunning(), "edge thread not reported as running");
+	acquisition.resetTimingStats();
+	CHECK(acquisition.getTimingStats().periods == 0, "timing statistics in data ready mode");
+	acquisition.stop();
+	CHECK(!acquisition.isRunning(), "still running after stop()");
+	CHECK(received == EDGE_EVENTS, "%u of %u edges gave a sample", received, EDGE_EVENTS);
+	CHECK(acquisition.getReadErrors() == 0, "%llu read errors", (unsigned long long)acquisition.getReadErrors());
+	CHECK(acquisition.getOverruns() == 0, "%llu overruns", (unsigned long long)acquisition.getOverruns());
+	close(fds[0]);
+	close(fds[1]);
+}
+
+int main(void)
+{
+	waitEdge();
+	eventFd();
+	waitForSample();
+	acquisitionDataReady();
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Register stores of the compile time UNR_GpioPin against the run time GPIO functions
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: FSEL, pull, SET, CLR and LEV words on a memory backed chip and the setup_fake() page
+*/
+
+
+#include "UNR_BCM2711_GpioChip.h"
+#include <stdio.h>
+#include <string.h>
+
+extern volatile uint32_t* gpio_map;
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+// offsets folded at compile time, GPIO 45 is bank 1 bit 13, FSEL4 bits 15-17, pull register 2 bits 26-27
+static_assert(UNR_GpioPin<45>::kBank == 1U && UNR_GpioPin<45>::kMask == (1U << 13), "GPIO 45 bank / mask");
+static_assert(UNR_GpioPin<45>::kSetOffset == UNR_SET_OFFSET + 1U && UNR_GpioPin<45>::kClrOffset == UNR_CLR_OFFSET + 1U, "GPIO 45 SET / CLR");
+static_assert(UNR_GpioPin<45>::kLevelOffset == UNR_PINLEVEL_OFFSET + 1U, "GPIO 45 LEV");
+static_assert(UNR_GpioPin<45>::kFselOffset == UNR_FSEL_OFFSET + 4U && UNR_GpioPin<45>::kFselShift == 15U, "GPIO 45 FSEL");
+static_assert(UNR_GpioPin<45>::kPullOffset == UNR_PULLUPDN_OFFSET_2711_2 && UNR_GpioPin<45>::kPullShift == 26U, "GPIO 45 pull");
+
+/*
+* Every word of the two register pages, the first difference is reported
+*/
+static bool samePages(volatile uint32_t* _pin, volatile uint32_t* _legacy, unsigned int _gpio, const char* _step)
+{
+	for (unsigned int i = 0; i < UNR_GPIO_REGISTER_WORDS; i++)
+	{
+		if (_pin[i] != _legacy[i])
+		{
+			CHECK(false, "GPIO %u %s: word %u is 0x%08x, gpio functions give 0x%08x", _gpio, _step, i, _pin[i], _legacy[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void fillPattern(volatile uint32_t* _registers)
+{
+	for (unsigned int i = 0; i < UNR_GPIO_REGISTER_WORDS; i++) _registers[i] = 0x9E3779B9U * (i + 1U);
+}
+
+/*
+* The pin and the run time functions do the same sequence on two pages that start out equal
+*/
+template<unsigned int Pin>
+static void checkPin(void)
+{
+	typedef UNR_GpioPin<Pin> Pin_t;
+	UNR_GpioChip chip{UNR_GpioMemoryBacked()};
+	UNR_GpioChip runtime{UNR_GpioMemoryBacked()};
+	volatile uint32_t* registers = chip.registers();
+
+	fillPattern(registers);
+	fillPattern(runtime.registers());
+	fillPattern(gpio_map);
+
+	Pin_t pin(chip, OUTPUT, PUD_UP);
+	setup_gpio((int)Pin, OUTPUT, PUD_UP);
+	runtime.setupPin(Pin, OUTPUT, PUD_UP);
+	samePages(registers, gpio_map, Pin, "setup OUTPUT / PUD_UP");
+	samePages(runtime.registers(), gpio_map, Pin, "setupPin OUTPUT / PUD_UP");
+	CHECK(((registers[Pin_t::kFselOffset] >> Pin_t::kFselShift) & 7U) == 1U, "GPIO %u: FSEL is not output", Pin);
+	CHECK(get_pullupdn((int)Pin) == 1, "GPIO %u: pull is not up", Pin);
+
+	registers[Pin_t::kSetOffset] = 0;
+	gpio_map[Pin_t::kSetOffset] = 0;
+	pin.set();
+	output_gpio((int)Pin, 1);
+	samePages(registers, gpio_map, Pin, "set");
+	CHECK(registers[Pin_t::kSetOffset] == Pin_t::kMask, "GPIO %u: SET word 0x%08x", Pin, registers[Pin_t::kSetOffset]);
+
+	registers[Pin_t::kClrOffset] = 0;
+	gpio_map[Pin_t::kClrOffset] = 0;
+	pin.write(false);
+	output_gpio((int)Pin, 0);
+	samePages(registers, gpio_map, Pin, "clear");
+	CHECK(registers[Pin_t::kClrOffset] == Pin_t::kMask, "GPIO %u: CLR word 0x%08x", Pin, registers[Pin_t::kClrOffset]);
+
+	pin.setup(INPUT, PUD_DOWN);
+	setup_gpio((int)Pin, INPUT, PUD_DOWN);
+	samePages(registers, gpio_map, Pin, "setup INPUT / PUD_DOWN");
+	CHECK(get_pullupdn((int)Pin) == 2, "GPIO %u: pull is not down", Pin);
+
+	registers[Pin_t::kLevelOffset] = Pin_t::kMask;
+	gpio_map[Pin_t::kLevelOffset] = Pin_t::kMask;
+	CHECK(pin.read() && input_gpio((int)Pin) == 1, "GPIO %u: high level not read", Pin);
+	registers[Pin_t::kLevelOffset] = ~Pin_t::kMask;
+	gpio_map[Pin_t::kLevelOffset] = ~Pin_t::kMask;
+	CHECK(!pin.read() && input_gpio((int)Pin) == 0, "GPIO %u: low level not read", Pin);
+}
+
+template<unsigned int... Pins>
+static void checkPins(void)
+{
+	int expand[] = { (checkPin<Pins>(), 0)... };
+	(void)expand;
+}
+
+int main(void)
+{
+	if (setup_fake() != SETUP_OK)
+	{
+		printf("setup_fake failed\nFAILED\n");
+		return 1;
+	}
+	// first and last pin of each FSEL and pull word, both banks
+	checkPins<0, 4, 9, 10, 15, 16, 17, 29, 31, 32, 39, 45, 47, 48, 49, 50, 57>();
+	cleanup();
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: DMP upload and quaternion packets of MPU6050_RaspbPi against MPU6050_Simulated
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Image sizes, read back, packets still being written by the DMP
+*/
+
+
+#include "MPU6050_Simulated.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static std::vector<unsigned char> image(unsigned int _size)
+{
+	std::vector<unsigned char> data(_size);
+	for (unsigned int i = 0; i < _size; i++) data[i] = (unsigned char)(i * 13U + 7U);
+	return data;
+}
+
+static void upload(void)
+{
+	MPU6050_Simulated device;
+	std::vector<unsigned char> motionApps20 = image(MPU6050_DMP_MOTIONAPPS20_SIZE);
+	std::vector<unsigned char> motionApps612 = image(MPU6050_DMP_MOTIONAPPS612_SIZE);
+	std::vector<unsigned char> tooLarge = image(MPU6050_DMP_MEMORY_SIZE + 1U);
+
+	device.initialize();
+	CHECK(device.loadDMPFirmware(motionApps20.data(), (unsigned int)motionApps20.size(), MPU6050_DMP_MOTIONAPPS20_START_ADDRESS) == 1,
+			"MotionApps 2.0 image rejected");
+	CHECK(memcmp(device.model().getDMPMemory(), motionApps20.data(), motionApps20.size()) == 0, "MotionApps 2.0 image not in DMP memory");
+	CHECK(device.loadDMPFirmware(motionApps612.data(), (unsigned int)motionApps612.size(), MPU6050_DMP_MOTIONAPPS612_START_ADDRESS) == 1,
+			"MotionApps 6.12 image rejected");
+	CHECK(memcmp(device.model().getDMPMemory(), motionApps612.data(), motionApps612.size()) == 0, "MotionApps 6.12 image not in DMP memory");
+	CHECK(device.loadDMPFirmware(tooLarge.data(), (unsigned int)tooLarge.size(), 0) == -1, "image larger than DMP memory accepted");
+}
+
+/*
+* The DMP writes its packets byte by byte, a count taken in between must not reset the stream
+*/
+static void partialPacket(unsigned short _packetBytes)
+{
+	MPU6050_Simulated device;
+	MPU6050_Quaternion quaternions[16];
+	int packets;
+
+	device.initialize();
+	device.model().setDMPPacketSize(_packetBytes);
+	CHECK(device.enableDMP(_packetBytes) == 1, "enableDMP failed");
+	device.step(3);
+	for (unsigned int i = 0; i < 10; i++) device.model().writeRegister(MPU6050_RA_FIFO_R_W, 0x00);
+
+	packets = device.getDMPQuaternions(quaternions, 16U);
+	CHECK(packets == 3, "%u byte packets: drained %d instead of 3", _packetBytes, packets);
+	CHECK(device.getFIFOOverflowCount() == 0, "%u byte packets: partial packet counted as an overflow", _packetBytes);
+	for (int i = 0; i < packets; i++)
+	{
+		float norm = quaternions[i].w * quaternions[i].w + quaternions[i].x * quaternions[i].x
+					+ quaternions[i].y * quaternions[i].y + quaternions[i].z * quaternions[i].z;
+		CHECK(fabsf(norm - 1.0f) < 1e-4f, "%u byte packets: quaternion %d has norm %f", _packetBytes, i, norm);
+	}
+	CHECK(device.getSimulatedFIFOCount() == 10, "%u byte packets: partial packet not left in the FIFO", _packetBytes);
+}
+
+int main(void)
+{
+	upload();
+	partialPacket(MPU6050_DMP_MOTIONAPPS20_PACKET_SIZE);
+	partialPacket(MPU6050_DMP_MOTIONAPPS612_PACKET_SIZE);
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: FIFO streaming of MPU6050_RaspbPi against MPU6050_Simulated
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Frame contents, partial frames, overflow and resync
+*/
+
+
+#include "MPU6050_Simulated.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+#define FIFO_FRAMES		(MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_SIZE)
+
+/*
+* Frames drained from the FIFO match the data registers of the same sample, in order and with increasing sequence
+*/
+static void frameContents(void)
+{
+	MPU6050_Simulated device;
+	MPU6050_Sample fifo[FIFO_FRAMES], polled;
+	int frames;
+
+	device.initialize();
+	CHECK(device.enableFIFO() > 0, "enableFIFO failed");
+	for (unsigned int i = 0; i < 20; i++)
+	{
+		device.step(1);
+		frames = device.getFIFOSamples(fifo, FIFO_FRAMES);
+		CHECK(frames == 1, "step %u drained %d frames", i, frames);
+		CHECK(device.getSample(polled) > 0, "getSample failed");
+		CHECK(memcmp(fifo[0].raw, polled.raw, sizeof(polled.raw)) == 0, "step %u: FIFO frame differs from the data registers", i);
+		CHECK(polled.sequence == fifo[0].sequence + 1U, "sequence not increasing");
+	}
+
+	device.step(10);
+	frames = device.getFIFOSamples(fifo, 4U);
+	CHECK(frames == 4, "limited drain returned %d", frames);
+	frames = device.getFIFOSamples(fifo, FIFO_FRAMES);
+	CHECK(frames == 6, "rest of the drain returned %d", frames);
+	CHECK(device.getFIFOOverflowCount() == 0, "overflow counted without an overflow");
+}
+
+/*
+* A count taken while the chip is writing a frame: the complete frames are returned, the partial one stays queued
+*/
+static void partialFrame(void)
+{
+	MPU6050_Simulated device;
+	MPU6050_Sample fifo[FIFO_FRAMES];
+	unsigned char frame[MPU6050_FIFO_FRAME_SIZE];
+	int frames;
+
+	device.initialize();
+	device.enableFIFO();
+	device.step(3);
+	for (unsigned int i = 0; i < MPU6050_FIFO_FRAME_SIZE; i++) frame[i] = (unsigned char)(0x10 + i);
+	for (unsigned int i = 0; i < 5; i++) device.model().writeRegister(MPU6050_RA_FIFO_R_W, frame[i]);
+
+	frames = device.getFIFOSamples(fifo, FIFO_FRAMES);
+	CHECK(frames == 3, "partial frame: drained %d frames instead of 3", frames);
+	CHECK(device.getFIFOOverflowCount() == 0, "partial frame counted as an overflow");
+	CHECK(device.getSimulatedFIFOCount() == 5, "partial frame not left in the FIFO (%u bytes)", device.getSimulatedFIFOCount());
+
+	for (unsigned int i = 5; i < MPU6050_FIFO_FRAME_SIZE; i++) device.model().writeRegister(MPU6050_RA_FIFO_R_W, frame[i]);
+	frames = device.getFIFOSamples(fifo, FIFO_FRAMES);
+	CHECK(frames == 1, "completed frame: drained %d frames", frames);
+	CHECK(frames == 1 && fifo[0].raw[0] == (int16_t)0x1011 && fifo[0].raw[6] == (int16_t)0x1C1D, "completed frame decoded as %04x .. %04x",
+			(uint16_t)fifo[0].raw[0], (uint16_t)fifo[0].raw[6]);
+}
+
+/*
+* An overflowing FIFO is reported once, reset, and the next drain starts on a frame boundary
+*/
+static void overflow(void)
+{
+	MPU6050_Simulated device;
+	MPU6050_Sample fifo[FIFO_FRAMES], polled;
+	int frames;
+
+	device.initialize();
+	device.enableFIFO();
+	device.step(FIFO_FRAMES + 10U);
+	frames = device.getFIFOSamples(fifo, FIFO_FRAMES);
+	CHECK(frames == MPU6050_FIFO_OVERFLOW, "overflow returned %d", frames);
+	CHECK(device.getFIFOOverflowCount() == 1, "overflow count %u", device.getFIFOOverflowCount());
+	CHECK(device.getSimulatedFIFOCount() == 0, "FIFO not reset after the overflow");
+
+	device.step(2);
+	frames = device.getFIFOSamples(fifo, FIFO_FRAMES);
+	CHECK(frames == 2, "drain after the reset returned %d", frames);
+	device.getSample(polled);
+	CHECK(frames == 2 && memcmp(fifo[1].raw, polled.raw, sizeof(polled.raw)) == 0, "frames after the reset are not aligned");
+	CHECK(device.getFIFOOverflowCount() == 1, "overflow counted again");
+}
+
+int main(void)
+{
+	frameContents();
+	partialFrame();
+	overflow();
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}
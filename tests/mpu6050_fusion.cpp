@@ -0,0 +1,128 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: MPU6050_Fusion tilt accuracy on a synthetic trace with known orientation
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Complementary, Madgwick and Mahony against the true roll / pitch of a noisy 1 kHz trace
+*/
+
+
+#include "MPU6050_Fusion.h"
+#include <math.h>
+#include <stdio.h>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+#define TRACE_RATE_HZ		1000U
+#define TRACE_SECONDS		20U
+#define TRACE_SAMPLES		(TRACE_RATE_HZ * TRACE_SECONDS)
+#define SETTLE_SAMPLES		TRACE_RATE_HZ				// the first second is not scored
+#define BATCH_SAMPLES		100U						// uneven against MPU6050_FUSION_CHUNK on purpose
+#define MAX_MEAN_TILT_DEG	1.0
+#define MAX_TILT_DEG		3.0
+
+static const double kDeg = M_PI / 180.0;
+
+/*
+* Roll, pitch and yaw (Z-Y-X, degrees) swing slowly; the sensor only feels gravity, so the accelerometer is the
+* rotated reference Z axis and the gyro the body rates of the Euler angle derivatives. Gaussian noise on both.
+*/
+struct Trace
+{
+	std::vector<float> ax, ay, az, temp, gx, gy, gz;
+	std::vector<uint64_t> timestamp;
+	std::vector<double> roll, pitch;
+
+	Trace(void) : ax(TRACE_SAMPLES), ay(TRACE_SAMPLES), az(TRACE_SAMPLES), temp(TRACE_SAMPLES), gx(TRACE_SAMPLES), gy(TRACE_SAMPLES),
+				gz(TRACE_SAMPLES), timestamp(TRACE_SAMPLES), roll(TRACE_SAMPLES), pitch(TRACE_SAMPLES)
+	{
+		std::mt19937 generator(6050U);
+		std::normal_distribution<double> gyroNoise(0.0, 0.05);		// deg/s
+		std::normal_distribution<double> accelNoise(0.0, 0.005);	// g
+		double t, phi, theta, phiDot, thetaDot, psiDot;
+
+		for (unsigned int i = 0; i < TRACE_SAMPLES; i++)
+		{
+			t = (double)i / TRACE_RATE_HZ;
+			phi = 30.0 * sin(2.0 * M_PI * 0.2 * t) * kDeg;
+			theta = 20.0 * sin(2.0 * M_PI * 0.13 * t + 1.0) * kDeg;
+			phiDot = 30.0 * 2.0 * M_PI * 0.2 * cos(2.0 * M_PI * 0.2 * t) * kDeg;
+			thetaDot = 20.0 * 2.0 * M_PI * 0.13 * cos(2.0 * M_PI * 0.13 * t + 1.0) * kDeg;
+			psiDot = 15.0 * kDeg;
+
+			roll[i] = phi / kDeg;
+			pitch[i] = theta / kDeg;
+			ax[i] = (float)(-sin(theta) + accelNoise(generator));
+			ay[i] = (float)(sin(phi) * cos(theta) + accelNoise(generator));
+			az[i] = (float)(cos(phi) * cos(theta) + accelNoise(generator));
+			temp[i] = 25.0f;
+			gx[i] = (float)((phiDot - psiDot * sin(theta)) / kDeg + gyroNoise(generator));
+			gy[i] = (float)((thetaDot * cos(phi) + psiDot * sin(phi) * cos(theta)) / kDeg + gyroNoise(generator));
+			gz[i] = (float)((-thetaDot * sin(phi) + psiDot * cos(phi) * cos(theta)) / kDeg + gyroNoise(generator));
+			timestamp[i] = 1000000000ULL + (uint64_t)i * (1000000000ULL / TRACE_RATE_HZ);
+		}
+	}
+};
+
+static void checkFilter(const Trace& _trace, MPU6050_FusionFilter _filter, const char* _name)
+{
+	MPU6050_Fusion fusion(_filter, 1.0f / TRACE_RATE_HZ);
+	std::vector<float> qw(TRACE_SAMPLES), qx(TRACE_SAMPLES), qy(TRACE_SAMPLES), qz(TRACE_SAMPLES);
+	std::vector<float> roll(TRACE_SAMPLES), pitch(TRACE_SAMPLES), yaw(TRACE_SAMPLES);
+	std::vector<uint64_t> timestamp(TRACE_SAMPLES);
+	double error, norm, sum = 0.0, worst = 0.0, worstNorm = 0.0;
+	unsigned int stampErrors = 0;
+
+	for (unsigned int first = 0; first < TRACE_SAMPLES; first += BATCH_SAMPLES)
+	{
+		MPU6050_SoA in = { (float*)&_trace.ax[first], (float*)&_trace.ay[first], (float*)&_trace.az[first], (float*)&_trace.temp[first],
+							(float*)&_trace.gx[first], (float*)&_trace.gy[first], (float*)&_trace.gz[first] };
+		MPU6050_OrientationSoA out = { &qw[first], &qx[first], &qy[first], &qz[first], &roll[first], &pitch[first], &yaw[first], &timestamp[first] };
+		CHECK(fusion.update(in, &_trace.timestamp[first], BATCH_SAMPLES, out) == BATCH_SAMPLES, "%s: update did not take the batch", _name);
+	}
+
+	for (unsigned int i = 0; i < TRACE_SAMPLES; i++)
+	{
+		if (timestamp[i] != _trace.timestamp[i]) stampErrors++;
+		norm = fabs(sqrt((double)qw[i] * qw[i] + (double)qx[i] * qx[i] + (double)qy[i] * qy[i] + (double)qz[i] * qz[i]) - 1.0);
+		if (norm > worstNorm) worstNorm = norm;
+		if (i < SETTLE_SAMPLES) continue;
+		error = sqrt((roll[i] - _trace.roll[i]) * (roll[i] - _trace.roll[i]) + (pitch[i] - _trace.pitch[i]) * (pitch[i] - _trace.pitch[i]));
+		sum += error;
+		if (error > worst) worst = error;
+	}
+	sum /= (double)(TRACE_SAMPLES - SETTLE_SAMPLES);
+	printf("%s: mean tilt error %.3f deg, max %.3f deg, max |q| - 1 %.2e\n", _name, sum, worst, worstNorm);
+	CHECK(sum < MAX_MEAN_TILT_DEG, "%s: mean tilt error %.3f deg", _name, sum);
+	CHECK(worst < MAX_TILT_DEG, "%s: max tilt error %.3f deg", _name, worst);
+	CHECK(worstNorm < 1e-4, "%s: quaternion norm off by %.2e", _name, worstNorm);
+	CHECK(stampErrors == 0, "%s: %u output timestamps differ from the input", _name, stampErrors);
+}
+
+int main(void)
+{
+	Trace trace;
+
+	printf("prepare path: %s\n", MPU6050_Fusion::preparePath());
+	checkFilter(trace, MPU6050_FUSION_COMPLEMENTARY, "complementary");
+	checkFilter(trace, MPU6050_FUSION_MADGWICK, "madgwick");
+	checkFilter(trace, MPU6050_FUSION_MAHONY, "mahony");
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}
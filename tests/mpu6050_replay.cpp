@@ -0,0 +1,162 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: MPU6050_Replay of a generated capture file through the MPU6050_RaspbPi reads
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Recorded timestamps on polled and FIFO reads, max speed and timed replay
+*/
+
+
+#include "MPU6050_Replay.h"
+#include <stdio.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+#define CAPTURE_PATH		"mpu6050_replay.cap"
+#define CAPTURE_RECORDS		400U
+#define FIFO_FRAMES			(MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_SIZE)
+
+/*
+* Record i has ACCEL_X = i + 1 (the tests find the record of a replayed sample from it) and a 10 ms period
+* with a few microseconds of jitter, so a host timestamp can never pass for a recorded one
+*/
+static uint64_t recordTimestamp(unsigned int _index)
+{
+	return 5000000000ULL + (uint64_t)_index * 10000000ULL + (uint64_t)(_index % 3U) * 1700ULL;
+}
+
+static bool writeCapture(void)
+{
+	MPU6050_CaptureConfig config = { MPU6050_ACCEL_FS_2_SCALE, MPU6050_GYRO_FS_250_SCALE, 100U, MPU6050_DEVICE_ADDRESS, {} };
+	MPU6050_Sample sample = {};
+
+	MPU6050_CaptureWriter writer(CAPTURE_PATH, config, MPU6050_CAPTURE_BLOCK_SIZE, false);
+	for (unsigned int i = 0; i < CAPTURE_RECORDS; i++)
+	{
+		sample.raw[MPU6050_AX] = (int16_t)(i + 1U);
+		sample.raw[MPU6050_AZ] = 16384;
+		sample.raw[MPU6050_GZ] = (int16_t)-(int)i;
+		sample.timestamp = recordTimestamp(i);
+		sample.sequence = i;
+		if (writer.append(&sample, 1U) < 0) return false;
+	}
+	return writer.close() >= 0;
+}
+
+/*
+* The sample is a record of the capture and carries that record's timestamp
+*/
+static bool checkRecorded(const MPU6050_Sample& _sample, const char* _mode)
+{
+	int index = _sample.raw[MPU6050_AX] - 1;
+	bool ok = index >= 0 && index < (int)CAPTURE_RECORDS && _sample.timestamp == recordTimestamp((unsigned int)index);
+	CHECK(ok, "%s: sample %d has timestamp %llu", _mode, index, (unsigned long long)_sample.timestamp);
+	return ok;
+}
+
+static void polledMaxSpeed(void)
+{
+	MPU6050_Replay replay(CAPTURE_PATH, MPU6050_REPLAY_MAX_SPEED);
+	MPU6050_Sample sample;
+	unsigned int read = 0;
+
+	replay.initialize();
+	while (!replay.finished() && read < 2U * CAPTURE_RECORDS)
+	{
+		CHECK(replay.getSample(sample) > 0, "getSample failed");
+		CHECK(sample.raw[MPU6050_AX] == (int16_t)(read + 1U), "polled: read %u got record %d", read, sample.raw[MPU6050_AX] - 1);
+		checkRecorded(sample, "polled");
+		read++;
+	}
+	CHECK(read == CAPTURE_RECORDS, "polled: %u of %u records read", read, CAPTURE_RECORDS);
+}
+
+/*
+* Max speed FIFO: every record once, in order, with its own timestamp although a whole batch is one read
+*/
+static void fifoMaxSpeed(void)
+{
+	MPU6050_Replay replay(CAPTURE_PATH, MPU6050_REPLAY_MAX_SPEED);
+	MPU6050_Sample batch[FIFO_FRAMES];
+	unsigned int next = 0, empty = 0;
+	int frames;
+
+	replay.initialize();
+	CHECK(replay.enableFIFO() > 0, "enableFIFO failed");
+	while (next < CAPTURE_RECORDS && empty < 4U)
+	{
+		frames = replay.getFIFOSamples(batch, 7U);
+		CHECK(frames >= 0, "getFIFOSamples returned %d", frames);
+		if (frames <= 0) { empty++; continue; }
+		for (int i = 0; i < frames; i++, next++)
+		{
+			CHECK(batch[i].raw[MPU6050_AX] == (int16_t)(next + 1U), "FIFO: expected record %u, got %d", next, batch[i].raw[MPU6050_AX] - 1);
+			checkRecorded(batch[i], "FIFO");
+		}
+	}
+	CHECK(next == CAPTURE_RECORDS, "FIFO: %u of %u records read", next, CAPTURE_RECORDS);
+}
+
+/*
+* 10x real time: the driver polls on its own schedule, samples still carry the recorded time, not the read time
+*/
+static void timed(bool _fifo)
+{
+	MPU6050_Replay replay(CAPTURE_PATH, 10.0);
+	MPU6050_Sample batch[FIFO_FRAMES];
+	unsigned int samples = 0;
+	uint64_t previous = 0;
+	int frames;
+
+	replay.initialize();
+	if (_fifo) CHECK(replay.enableFIFO() > 0, "enableFIFO failed");
+	while (!replay.finished())
+	{
+		usleep(3000);
+		if (_fifo)
+		{
+			frames = replay.getFIFOSamples(batch, FIFO_FRAMES);
+			CHECK(frames >= 0, "getFIFOSamples returned %d", frames);
+		}
+		else
+			frames = replay.getSample(batch[0]);
+		for (int i = 0; i < frames; i++, samples++)
+		{
+			if (!checkRecorded(batch[i], _fifo ? "timed FIFO" : "timed polled")) return;
+			CHECK(batch[i].timestamp >= previous, "timestamps go back");
+			previous = batch[i].timestamp;
+		}
+	}
+	CHECK(samples > 0, "nothing replayed");
+}
+
+int main(void)
+{
+	if (!writeCapture())
+	{
+		printf("cannot write %s\nFAILED\n", CAPTURE_PATH);
+		return 1;
+	}
+	polledMaxSpeed();
+	fifoMaxSpeed();
+	timed(false);
+	timed(true);
+	unlink(CAPTURE_PATH);
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}
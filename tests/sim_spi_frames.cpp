@@ -0,0 +1,105 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: SPI framing of UNR_SimTransport, one command per chip select assertion
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Combined and split command / data segments, cs_change frame boundaries
+*/
+
+
+#include "UNR_SimTransport.h"
+#include "MPU6050_Simulated.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static struct spi_ioc_transfer segment(const unsigned char* _tx, unsigned char* _rx, unsigned int _len, bool _csChange = false)
+{
+	struct spi_ioc_transfer s;
+	memset(&s, 0, sizeof(s));
+	s.tx_buf = (unsigned long)_tx;
+	s.rx_buf = (unsigned long)_rx;
+	s.len = _len;
+	s.cs_change = _csChange ? 1 : 0;
+	return s;
+}
+
+int main(void)
+{
+	UNR_SimTransport bus;
+	MPU6050_Model model;
+	const unsigned char config[4] = { 0x07, 0x03, 0x08, 0x10 };		// SMPLRT_DIV, CONFIG, GYRO_CONFIG, ACCEL_CONFIG
+	unsigned char tx[8], rx[8];
+	struct spi_ioc_transfer segments[4];
+
+	bus.attachSPI(&model);
+
+	// write: command and data in one segment
+	tx[0] = MPU6050_RA_SMPLRT_DIV;
+	memcpy(&tx[1], config, 4);
+	segments[0] = segment(tx, nullptr, 5U);
+	CHECK(bus.transfer(segments, 1U) == 5, "combined write failed");
+	CHECK(model.readRegister(MPU6050_RA_SMPLRT_DIV) == config[0] && model.readRegister(MPU6050_RA_ACCEL_CONFIG) == config[3],
+			"combined write landed at the wrong registers");
+
+	// read: command and answer in one full duplex segment
+	memset(tx, 0, sizeof(tx));
+	tx[0] = MPU6050_RA_SMPLRT_DIV | UNR_SIM_SPI_READ_FLAG;
+	memset(rx, 0xEE, sizeof(rx));
+	segments[0] = segment(tx, rx, 5U);
+	bus.transfer(segments, 1U);
+	CHECK(memcmp(&rx[1], config, 4) == 0, "combined read returned %02x %02x %02x %02x", rx[1], rx[2], rx[3], rx[4]);
+
+	// read: command segment, then a receive only segment under the same chip select (spi_queueTransfer(&cmd, nullptr, 1),
+	// spi_queueTransfer(nullptr, rx, n))
+	tx[0] = MPU6050_RA_SMPLRT_DIV | UNR_SIM_SPI_READ_FLAG;
+	memset(rx, 0xEE, sizeof(rx));
+	segments[0] = segment(tx, nullptr, 1U);
+	segments[1] = segment(nullptr, rx, 4U);
+	CHECK(bus.transfer(segments, 2U) == 5, "split read failed");
+	CHECK(memcmp(rx, config, 4) == 0, "split read returned %02x %02x %02x %02x", rx[0], rx[1], rx[2], rx[3]);
+	CHECK(model.readRegister(0x00) == 0x00, "split read wrote register 0");
+
+	// write: command segment, then the data from a second buffer
+	const unsigned char command = MPU6050_RA_GYRO_CONFIG;
+	const unsigned char data[2] = { 0x18, 0x18 };
+	segments[0] = segment(&command, nullptr, 1U);
+	segments[1] = segment(data, nullptr, 2U);
+	bus.transfer(segments, 2U);
+	CHECK(model.readRegister(MPU6050_RA_GYRO_CONFIG) == 0x18 && model.readRegister(MPU6050_RA_ACCEL_CONFIG) == 0x18, "split write failed");
+
+	// two frames in one call: cs_change ends the first, the next byte is a new command
+	unsigned char whoAmI[2] = { MPU6050_RA_WHO_AM_I | UNR_SIM_SPI_READ_FLAG, 0x00 };
+	unsigned char answer[2];
+	tx[0] = MPU6050_RA_SMPLRT_DIV | UNR_SIM_SPI_READ_FLAG;
+	memset(rx, 0xEE, sizeof(rx));
+	segments[0] = segment(tx, nullptr, 1U);
+	segments[1] = segment(nullptr, rx, 1U, true);
+	segments[2] = segment(whoAmI, answer, 2U);
+	bus.transfer(segments, 3U);
+	CHECK(rx[0] == config[0], "first frame returned %02x", rx[0]);
+	CHECK(answer[1] == MPU6050_ADDRESS_AD0_LOW, "second frame returned %02x instead of WHO_AM_I", answer[1]);
+
+	// a new call is a new frame even without cs_change
+	segments[0] = segment(whoAmI, answer, 2U);
+	bus.transfer(segments, 1U);
+	CHECK(answer[1] == MPU6050_ADDRESS_AD0_LOW, "second call returned %02x instead of WHO_AM_I", answer[1]);
+
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+/* Author: Sanket L. (slokhande@unr.edu)
+	Copyright (C) 2022  Sanket Lokhande
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*
+*
+*  File Description: Producer / consumer stress test of UNR_SPSCRing and the MPU6050_Acquisition loss counters
+*
+* Unauthorized Distrubution is strictly prohibited.
+* Rev 1: Torn records, ordering, size() bounds and overrun accounting under both policies, FIFO overflow count
+*/
+
+
+#include "UNR_SPSCRing.h"
+#include "MPU6050_Acquisition.h"
+#include "MPU6050_Simulated.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+
+#define STRESS_RING_CAPACITY	256U
+#define STRESS_ITEMS			4000000ULL
+
+typedef UNR_SPSCRing<MPU6050_Sample, STRESS_RING_CAPACITY> StressRing;
+
+static int failures = 0;
+
+#define CHECK(_condition, ...) do { if (!(_condition)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static void pin(int _cpu)
+{
+	cpu_set_t set;
+	if (_cpu >= (int)std::thread::hardware_concurrency()) return;
+	CPU_ZERO(&set);
+	CPU_SET(_cpu, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);		// best effort, the test is valid unpinned
+}
+
+// every field is derived from the sequence number, a record mixing two pushes cannot pass check()
+static void fill(MPU6050_Sample& _sample, uint64_t _sequence)
+{
+	for (unsigned int c = 0; c < 7; c++) _sample.raw[c] = (int16_t)(_sequence * 7U + c);
+	_sample.timestamp = ~_sequence;
+	_sample.sequence = _sequence;
+}
+
+static bool intact(const MPU6050_Sample& _sample)
+{
+	for (unsigned int c = 0; c < 7; c++)
+		if (_sample.raw[c] != (int16_t)(_sample.sequence * 7U + c)) return false;
+	return _sample.timestamp == ~_sample.sequence;
+}
+
+static void stressRing(UNR_RingPolicy _policy)
+{
+	StressRing ring(_policy);
+	std::atomic<bool> done(false);
+	uint64_t pushed = 0, rejected = 0, popped = 0, torn = 0, disordered = 0, oversized = 0;
+	uint64_t last = 0;
+	bool first = true;
+	MPU6050_Sample batch[64];
+	unsigned int count;
+
+	std::thread producer([&]()
+	{
+		MPU6050_Sample sample;
+		pin(0);
+		for (uint64_t i = 0; i < STRESS_ITEMS; i++)
+		{
+			fill(sample, i);
+			if (!ring.push(sample) && _policy == UNR_RING_DROP_NEWEST) rejected++;
+			pushed++;
+		}
+		done.store(true, std::memory_order_release);
+	});
+
+	pin(1);
+	for (;;)
+	{
+		bool finished = done.load(std::memory_order_acquire);
+		if (ring.size() > STRESS_RING_CAPACITY) oversized++;
+		// alternate single and batch pops so both claim paths race the producer
+		if (popped & 1U) count = ring.popBatch(batch, 1U + (unsigned int)(popped % 64U));
+		else count = ring.pop(batch[0]) ? 1U : 0U;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (!intact(batch[i])) torn++;
+			if (!first && batch[i].sequence <= last) disordered++;
+			last = batch[i].sequence;
+			first = false;
+		}
+		popped += count;
+		if (count == 0 && finished && ring.empty()) break;
+	}
+	producer.join();
+
+	printf("%s: pushed %llu popped %llu overruns %llu\n", _policy == UNR_RING_DROP_OLDEST ? "drop oldest" : "drop newest",
+			(unsigned long long)pushed, (unsigned long long)popped, (unsigned long long)ring.overruns());
+	CHECK(torn == 0, "%llu torn records", (unsigned long long)torn);
+	CHECK(disordered == 0, "%llu records out of order", (unsigned long long)disordered);
+	CHECK(oversized == 0, "size() above capacity %llu times", (unsigned long long)oversized);
+	CHECK(popped + ring.overruns() == pushed, "popped %llu + overruns %llu != pushed %llu", (unsigned long long)popped,
+			(unsigned long long)ring.overruns(), (unsigned long long)pushed);
+	if (_policy == UNR_RING_DROP_NEWEST) CHECK(rejected == ring.overruns(), "rejected pushes %llu != overruns", (unsigned long long)rejected);
+	CHECK(last == STRESS_ITEMS - 1U || _policy == UNR_RING_DROP_NEWEST, "newest record %llu not delivered", (unsigned long long)last);
+}
+
+/*
+* 8 kHz samples into the 1024 byte FIFO (73 frames, about 9 ms) drained at 100 Hz: every drain finds it overflowed
+*/
+static void fifoOverflows(void)
+{
+	MPU6050_Simulated* device = new MPU6050_Simulated();
+	UNR_SamplerConfig timing = { UNR_SAMPLER_MIN_RATE_HZ, 0, -1, false };
+
+	device->initialize();
+	device->setDLPFMode(MPU6050_DLPF_BW_256);
+	device->setOutputRate(MPU6050_GYRO_RATE_DLPF_OFF);
+	device->model().setRealTime(true);
+
+	MPU6050_Acquisition acquisition(device, timing, UNR_RING_DROP_OLDEST, MPU6050_ACQ_FIFO);
+	CHECK(acquisition.start() > 0, "acquisition did not start");
+	usleep(200000);
+	acquisition.stop();
+	printf("fifo: overflows %llu read errors %llu\n", (unsigned long long)acquisition.getFIFOOverflows(),
+			(unsigned long long)acquisition.getReadErrors());
+	CHECK(acquisition.getFIFOOverflows() > 0, "sensor FIFO overflows not counted");
+	CHECK(acquisition.getReadErrors() == 0, "overflows counted as read errors");
+}
+
+int main(void)
+{
+	stressRing(UNR_RING_DROP_OLDEST);
+	stressRing(UNR_RING_DROP_NEWEST);
+	fifoOverflows();
+	printf(failures ? "FAILED\n" : "PASSED\n");
+	return failures ? 1 : 0;
+}